@@ -62,7 +62,6 @@ SolenoidState solenoid = {
     .lastState = false};
 
 CommandSystem _commandSystem;
-MainCommand _cmdMain;
 
 // Get maximum pattern count for given beats (2^(beats-1) since first beat is always accented)
 uint16_t getMaxPatterns(uint8_t beats)
@@ -157,66 +156,91 @@ void IRAM_ATTR hallSensorISR()
   }
 }
 
-void setupCommands(MainCommand *cmd)
+void cmdBpm(const CommandArgs &cmd)
 {
-  cmd->addCallback("bpm", "Set bpm (20-300)", [](void *arg)
-                   {
-        std::vector<String> cmd = *(std::vector<String>*)arg;
-        if (cmd.size() < 2) return;
-        uint32_t newBpm = cmd[1].toInt();
-        if (newBpm >= MIN_GLOBAL_BPM && newBpm <= MAX_GLOBAL_BPM) {
-            timing.bpm = newBpm;
-            Serial.printf("BPM: %d (effective: %d)\n", 
-                newBpm, 
-                getEffectiveBpm(newBpm, timing.subdivision));
-        } });
-
-  cmd->addCallback("measure", "Set beats per measure (1-16)", [](void *arg)
-                   {
-        std::vector<String> cmd = *(std::vector<String>*)arg;
-        if (cmd.size() < 2) return;
-        uint8_t beats = cmd[1].toInt();
-        if (beats >= 1 && beats <= MAX_BEATS) {
-            timing.beatsPerMeasure = beats;
-            timing.currentPattern = 1;  // Reset to first pattern
-            timing.currentBeat = 0;     // Reset beat counter
-            printPatterns(beats);
-        } });
-
-  cmd->addCallback("pattern", "Set beat pattern", [](void *arg)
-                   {
-        std::vector<String> cmd = *(std::vector<String>*)arg;
-        if (cmd.size() < 2) return;
-        uint16_t pattern = cmd[1].toInt();
-        uint16_t maxPatterns = getMaxPatterns(timing.beatsPerMeasure);
-        if (pattern >= 1 && pattern <= maxPatterns) {
-            timing.currentPattern = pattern;
-            Serial.printf("Pattern set to %d: ", pattern);
-            uint16_t pat = generatePattern(timing.beatsPerMeasure, pattern);
-            for (uint8_t b = 0; b < timing.beatsPerMeasure; b++) {
-                Serial.print(isAccentBeat(b, pat) ? 'X' : 'x');
-            }
-            Serial.println();
-        } });
-
-  cmd->addCallback("subdivision", "Set subdivision (2=half,4=quarter,8=eighth)", [](void *arg)
-                   {
-        std::vector<String> cmd = *(std::vector<String>*)arg;
-        if (cmd.size() < 2) return;
-        uint8_t sub = cmd[1].toInt();
-        if (sub == 2 || sub == 4 || sub == 8) {
-            timing.subdivision = sub;
-            Serial.printf("Subdivision: 1/%d (effective BPM: %d)\n", 
-                sub, 
-                getEffectiveBpm(timing.bpm, sub));
-        } });
+  if (cmd.argc < 2)
+    return;
+  uint32_t newBpm = cmd.toInt(1);
+  if (newBpm >= MIN_GLOBAL_BPM && newBpm <= MAX_GLOBAL_BPM)
+  {
+    timing.bpm = newBpm;
+    Serial.printf("BPM: %d (effective: %d)\n",
+                  newBpm,
+                  getEffectiveBpm(newBpm, timing.subdivision));
+  }
+}
+
+void cmdMeasure(const CommandArgs &cmd)
+{
+  if (cmd.argc < 2)
+    return;
+  uint8_t beats = cmd.toInt(1);
+  if (beats >= 1 && beats <= MAX_BEATS)
+  {
+    timing.beatsPerMeasure = beats;
+    timing.currentPattern = 1; // Reset to first pattern
+    timing.currentBeat = 0;    // Reset beat counter
+    printPatterns(beats);
+  }
 }
 
+void cmdPattern(const CommandArgs &cmd)
+{
+  if (cmd.argc < 2)
+    return;
+  uint16_t pattern = cmd.toInt(1);
+  uint16_t maxPatterns = getMaxPatterns(timing.beatsPerMeasure);
+  if (pattern >= 1 && pattern <= maxPatterns)
+  {
+    timing.currentPattern = pattern;
+    Serial.printf("Pattern set to %d: ", pattern);
+    uint16_t pat = generatePattern(timing.beatsPerMeasure, pattern);
+    for (uint8_t b = 0; b < timing.beatsPerMeasure; b++)
+    {
+      Serial.print(isAccentBeat(b, pat) ? 'X' : 'x');
+    }
+    Serial.println();
+  }
+}
+
+void cmdMidiStats(const CommandArgs &cmd);
+void cmdPools(const CommandArgs &cmd);
+void cmdClock(const CommandArgs &cmd);
+
+void cmdSubdivision(const CommandArgs &cmd)
+{
+  if (cmd.argc < 2)
+    return;
+  uint8_t sub = cmd.toInt(1);
+  if (sub == 2 || sub == 4 || sub == 8)
+  {
+    timing.subdivision = sub;
+    Serial.printf("Subdivision: 1/%d (effective BPM: %d)\n",
+                  sub,
+                  getEffectiveBpm(timing.bpm, sub));
+  }
+}
+
+// Command table, hashed at compile time
+constexpr command_t mainCommands[] = {
+    {"bpm", "Set bpm (20-300)", cmdBpm},
+    {"measure", "Set beats per measure (1-16)", cmdMeasure},
+    {"pattern", "Set beat pattern", cmdPattern},
+    {"subdivision", "Set subdivision (2=half,4=quarter,8=eighth)", cmdSubdivision},
+    {"midistats", "Print BLE MIDI send/receive statistics", cmdMidiStats},
+    {"pools", "Print NimBLE memory pool usage", cmdPools},
+    {"clock", "BLE MIDI clock output (on/off)", cmdClock},
+};
+constexpr CommandTable<7> mainCommandTable(mainCommands);
+
+MainCommand _cmdMain(mainCommandTable.view());
+
 /* -------------------------------------------------------------------------- */
 /*                                     BLE                                    */
 /* -------------------------------------------------------------------------- */
-#include "ble_utils/BLEMsgStructure.h"
-#include "ble_utils/BLEMetronomeServer.h"
+#include <BLEMsgStructure.h>
+#include <BLEMetronomeServer.h>
+#include <NimBLEDevice.h>
 void onBleConnected();
 void onBleDisconnect();
 void onControlChange(uint8_t channel, uint8_t controller, uint8_t value, uint16_t timestamp);
@@ -244,6 +268,114 @@ void sendCurrentStatus()
   sendCC(16, 4, map(timing.beatsPerMeasure, 1, MAX_BEATS, 0, 127));
 }
 
+void cmdMidiStats(const CommandArgs &cmd)
+{
+  ProtocolMidi::TxStats stats = BLEMetronomeServer.getTxStats();
+  Serial.printf("MIDI: %u messages in %u notifications (%u full, %u dropped), max latency %u us\n",
+                stats.messages, stats.packets, stats.fullFlushes, stats.dropped, stats.maxLatencyUs);
+  Serial.printf("Clock: %u timed messages, sent up to %u us after their event time (stamped with the event time)\n",
+                stats.timedMessages, stats.maxSendLagUs);
+  ProtocolMidi::RxStats rx = BLEMetronomeServer.getRxStats();
+  Serial.printf("Received: %u packets, %u bytes, parse avg %u us, max %u us\n",
+                rx.packets, rx.bytes, rx.packets ? (uint32_t)(rx.totalParseUs / rx.packets) : 0, rx.maxParseUs);
+  if (cmd.argc > 1 && cmd.is(1, "reset"))
+  {
+    BLEMetronomeServer.resetTxStats();
+    BLEMetronomeServer.resetRxStats();
+  }
+}
+
+// For sizing msys/mbuf pools: a high water near the block count, or any
+// failures, means the pool is too small
+void cmdPools(const CommandArgs &cmd)
+{
+  struct os_mempool_info info;
+  struct os_mempool *mp = NULL;
+  while ((mp = os_mempool_info_get_next(mp, &info)) != NULL)
+  {
+    Serial.printf("%-16s %4d x %4d B: %3d in use, high water %3d, %d failures\n",
+                  info.omi_name, info.omi_num_blocks, info.omi_block_size,
+                  info.omi_num_blocks - info.omi_num_free,
+                  info.omi_num_blocks - info.omi_min_free, info.omi_num_fails);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                              BLE MIDI clock out                            */
+/* -------------------------------------------------------------------------- */
+// 24 clocks per quarter note on the metronome's own beat grid (beats fall on
+// multiples of msPerBeat since boot, see processMetronomeTick). Each clock is
+// stamped with the time it was due, not the time the loop got to it.
+typedef struct
+{
+  bool running;
+  bool startPending;     // Send Start before the next clock
+  uint32_t msPerBeat;    // Grid the tick numbers belong to
+  uint8_t ticksPerBeat;
+  uint64_t nextTick;     // Clock number since boot
+} ClockOutState;
+
+ClockOutState clockOut = {};
+
+uint64_t clockTickMicros(uint64_t tick)
+{
+  return tick * clockOut.msPerBeat * 1000 / clockOut.ticksPerBeat;
+}
+
+void processClockOut()
+{
+  int64_t now = esp_timer_get_time();
+  bool active = timing.enabled && BLEMetronomeServer.isClockOutput() && BLEMetronomeServer.isConnected();
+  if (!active)
+  {
+    if (clockOut.running)
+    {
+      BLEMetronomeServer.clockStop((uint32_t)now);
+      clockOut.running = false;
+    }
+    return;
+  }
+
+  uint32_t msPerBeat = getMsPerBeat(timing.bpm, timing.subdivision);
+  uint8_t ticksPerBeat = 96 / timing.subdivision; // 24 per quarter note
+  if (!clockOut.running)
+  {
+    // Start on the next beat
+    clockOut.msPerBeat = msPerBeat;
+    clockOut.ticksPerBeat = ticksPerBeat;
+    clockOut.nextTick = ((uint64_t)now / 1000 / msPerBeat + 1) * ticksPerBeat;
+    clockOut.startPending = true;
+    clockOut.running = true;
+  }
+  else if (msPerBeat != clockOut.msPerBeat || ticksPerBeat != clockOut.ticksPerBeat)
+  {
+    // Tempo change: continue with the next clock on the new grid
+    clockOut.msPerBeat = msPerBeat;
+    clockOut.ticksPerBeat = ticksPerBeat;
+    clockOut.nextTick = (uint64_t)now * ticksPerBeat / (msPerBeat * 1000ULL) + 1;
+  }
+
+  for (uint64_t due = clockTickMicros(clockOut.nextTick); due <= (uint64_t)now;
+       due = clockTickMicros(clockOut.nextTick))
+  {
+    if (clockOut.startPending)
+    {
+      BLEMetronomeServer.songPosition(0, (uint32_t)due);
+      BLEMetronomeServer.clockStart((uint32_t)due);
+      clockOut.startPending = false;
+    }
+    BLEMetronomeServer.clockTick((uint32_t)due);
+    clockOut.nextTick++;
+  }
+}
+
+void cmdClock(const CommandArgs &cmd)
+{
+  if (cmd.argc > 1)
+    BLEMetronomeServer.setClockOutput(cmd.is(1, "on"));
+  Serial.printf("BLE MIDI clock output %s\n", BLEMetronomeServer.isClockOutput() ? "on" : "off");
+}
+
 void onBleConnected()
 {
   Serial.println("BLE Connected");
@@ -307,6 +439,12 @@ void onControlChange(uint8_t channel, uint8_t controller, uint8_t value, uint16_
     // Notify connected devices of new beats per measure as ch16 cc4
     sendCC(16, 4, value);
   }
+  // Clock output on/off by CH15 CC5
+  if (channel_actual == 15 && controller == 5)
+  {
+    BLEMetronomeServer.setClockOutput(value >= 64);
+    Serial.printf("BLE MIDI clock output %s\n", value >= 64 ? "on" : "off");
+  }
 
 }
 
@@ -318,7 +456,6 @@ void setup()
   pinMode(solenoid.piezoPin, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(solenoid.piezoPin), hallSensorISR, FALLING);
 
-  setupCommands(&_cmdMain);
   _commandSystem.registerClass(&_cmdMain);
 
   // Print initial patterns
@@ -332,4 +469,5 @@ void loop()
   {
     processMetronomeTick(&timing, &solenoid);
   }
+  processClockOut();
 }
\ No newline at end of file
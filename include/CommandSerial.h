@@ -3,25 +3,96 @@
 
 #include <Arduino.h>
 #include <HardwareSerial.h>
-#include <queue>
 
 /**
  * @brief Design base on concept that some class may not always run
  * So it's good to add and remove at runtime to reduce memory usage
  */
 
+// Longest command line, and most tokens per line
+#define COMMAND_LINE_MAX 96
+#define COMMAND_MAX_ARGS 8
+// Bytes taken from the UART RX buffer per parser() call, so loop() stays bounded
+#define COMMAND_MAX_BYTES_PER_POLL 64
+
 enum commandState_en
 {
     C_STOPPED,
     C_RUNNING,
 };
 
+// Tokens of one command line; argv points into the line reader's buffer and
+// is only valid during dispatch
+struct CommandArgs
+{
+    uint8_t argc;
+    const char *argv[COMMAND_MAX_ARGS];
+
+    int toInt(uint8_t index, int fallback = 0) const
+    {
+        return index < argc ? atoi(argv[index]) : fallback;
+    }
+
+    bool is(uint8_t index, const char *text) const
+    {
+        return index < argc && strcmp(argv[index], text) == 0;
+    }
+};
+
+// Incremental line reader: bytes are fed as they arrive and the line is
+// split in place once it ends, so nothing blocks and nothing is allocated
+class CommandLineReader
+{
+private:
+    char m_line[COMMAND_LINE_MAX];
+    uint8_t m_length = 0;
+    bool m_overflow = false;
+    CommandArgs m_args = {};
+
+public:
+    // Returns true when a complete, non-empty line has been tokenized
+    bool feed(char c)
+    {
+        if (c != '\n' && c != '\r') {
+            if (m_length < COMMAND_LINE_MAX - 1)
+                m_line[m_length++] = c;
+            else
+                m_overflow = true;
+            return false;
+        }
+
+        m_line[m_length] = '\0';
+        uint8_t length = m_length;
+        bool overflow = m_overflow;
+        m_length = 0;
+        m_overflow = false;
+
+        if (overflow) {
+            Serial.println("Command line too long");
+            return false;
+        }
+        return length > 0 && tokenize();
+    }
+
+    const CommandArgs &args() const { return m_args; }
+
+private:
+    bool tokenize()
+    {
+        m_args.argc = 0;
+        char *p = m_line;
+        while (*p && m_args.argc < COMMAND_MAX_ARGS) {
+            while (*p == ' ') *p++ = '\0';
+            if (!*p) break;
+            m_args.argv[m_args.argc++] = p;
+            while (*p && *p != ' ') p++;
+        }
+        // Ignore anything beyond COMMAND_MAX_ARGS tokens
+        if (*p) *p = '\0';
+        return m_args.argc > 0;
+    }
+};
 
-typedef struct {
-    String name;
-    String description;
-    void (*callback)(void* arg);
-} command_t;
 
 class CommandBase
 {
@@ -46,7 +117,7 @@ public:
     }
     
     // virtual void update() = 0;
-    virtual void parser(const std::vector<String>& cmd) = 0;
+    virtual void parser(const CommandArgs& cmd) = 0;
     virtual void help() = 0;
 }; 
 
@@ -56,11 +127,13 @@ class CommandSystem
 public:
     CommandBase *command_s; 
     int currentId; 
+    CommandLineReader reader;
      
 
     CommandSystem()
     {
         command_s = 0; 
+        currentId = 0;
         Serial.println("CommandSystem initialized");
     }
 
@@ -71,35 +144,33 @@ public:
         command->insert(&command_s);
         return currentId++;
     }
- 
-    std::vector<String> splitString(const String& input) {
-        std::vector<String> result;
-        int start = 0;
-        int end = input.indexOf(' ');
-
-        while (end != -1) {
-            result.push_back(input.substring(start, end));
-            start = end + 1;
-            end = input.indexOf(' ', start);
-        }
 
-        // Add the last substring
-        result.push_back(input.substring(start));
-
-        return result;
+    /// takes what is waiting in the UART RX buffer (never waits for more)
+    /// and dispatches each complete line
+    inline void parser()
+    { 
+        for (int n = 0; n < COMMAND_MAX_BYTES_PER_POLL && Serial.available(); n++)
+            feed(Serial.read());
     }
 
+    /// feeds one byte read by someone else (e.g. a binary protocol demux
+    /// that owns the UART)
+    inline void feed(char c)
+    {
+        if (reader.feed(c))
+            dispatch(reader.args());
+    }
 
-    inline void parser()
-    { 
-        if(!Serial.available()) return;
-        
-        String cmd = Serial.readStringUntil('\n');
-        std::vector<String> cmdParts = splitString(cmd);
-        Serial.println("Recv: " + cmd); 
-        if(cmdParts.size() == 0) return;
+    inline void dispatch(const CommandArgs &cmdParts)
+    {
+        Serial.print("Recv:");
+        for (uint8_t i = 0; i < cmdParts.argc; i++) {
+            Serial.print(' ');
+            Serial.print(cmdParts.argv[i]);
+        }
+        Serial.println();
         int mode = 0;
-        if(cmdParts[0] == "help") mode = 1;
+        if(cmdParts.is(0, "help")) mode = 1;
 
         CommandBase **command = &command_s;
         while (*command)
@@ -5,48 +5,133 @@
 #include "CommandSerial.h"
 #include "config.h"
 
+typedef struct {
+    const char *name;
+    const char *description;
+    void (*callback)(const CommandArgs &args);
+} command_t;
+
+// FNV-1a with the seed mixed into the result, usable at compile time and at
+// run time. Seeding only the offset basis is not enough: the low bits the
+// table uses then take a handful of layouts whatever the seed
+constexpr uint32_t commandHash(const char *name, uint32_t seed)
+{
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    hash ^= seed;
+    hash *= 0x9E3779B1u;
+    hash ^= hash >> 15;
+    return hash;
+}
+
+// Non-template view of a CommandTable, so MainCommand can hold any size
+struct CommandTableView
+{
+    const command_t *commands;
+    uint8_t count;
+    const uint8_t *slots;     // Command index + 1 per slot, 0 = empty
+    uint8_t slotMask;
+    uint32_t seed;
+
+    const command_t *find(const char *name) const
+    {
+        uint8_t slot = slots[commandHash(name, seed) & slotMask];
+        if (slot == 0) return nullptr;
+        const command_t *command = &commands[slot - 1];
+        return strcmp(command->name, name) == 0 ? command : nullptr;
+    }
+};
+
+// Perfect hash table built at compile time: the seed is searched until
+// every command name lands in its own slot, so a lookup is one hash and
+// one string compare. Past 24 commands the search can outrun the
+// compiler's constexpr budget
+template <size_t N>
+class CommandTable
+{
+    static_assert(N > 0 && N <= 24, "CommandTable holds 1 to 24 commands");
+
+    static constexpr size_t slotCountFor(size_t n)
+    {
+        size_t size = 1;
+        while (size < 2 * n) size <<= 1;
+        return size;
+    }
+
+public:
+    static constexpr size_t SLOTS = slotCountFor(N);
+
+    const command_t *commands;
+    uint8_t slots[SLOTS] = {};
+    uint32_t seed = 0;
+
+    constexpr CommandTable(const command_t (&table)[N]) : commands(table)
+    {
+        for (seed = 0; seed < 100000; seed++) {
+            if (tryBuild(table))
+                return;
+        }
+        // Only reached for duplicate names; not constexpr, so a constexpr
+        // table fails to compile
+        noPerfectHashSeed();
+    }
+
+    constexpr CommandTableView view() const
+    {
+        return {commands, (uint8_t)N, slots, (uint8_t)(SLOTS - 1), seed};
+    }
+
+private:
+    static void noPerfectHashSeed() {}
+
+    constexpr bool tryBuild(const command_t (&table)[N])
+    {
+        for (size_t i = 0; i < SLOTS; i++) slots[i] = 0;
+        for (size_t i = 0; i < N; i++) {
+            size_t slot = commandHash(table[i].name, seed) & (SLOTS - 1);
+            if (slots[slot] != 0) return false;
+            slots[slot] = i + 1;
+        }
+        return true;
+    }
+};
+
 class MainCommand : public CommandBase
 {
 private:
-    std::vector<command_t> m_commands;
+    CommandTableView m_table;
 public:
-    MainCommand() {  
+    MainCommand(const CommandTableView &table) : m_table(table) {
         commandState = C_RUNNING;
     }
 
     ~MainCommand() {  }
 
-    void addCallback(const String& name, const String& description, void (*callback)(void* arg) ) {
-        command_t command;
-        command.name = name;
-        command.description = description;
-        command.callback = callback;
-        m_commands.push_back(command);
+    inline bool runCallback(const char *fnName, const CommandArgs &args) {
+        const command_t *command = m_table.find(fnName);
+        if (!command) return false;
+        command->callback(args);
+        return true;
     }
 
-    inline void runCallback(const String& fnName, void* arg) {
-        for (auto& command : m_commands) {
-            if(command.name == fnName) {
-                command.callback(arg);
-                return;
-            }
-        }
-    } 
-
     virtual void help() {
         Serial.println("========= MainCommand help =========");
-        for (auto& command : m_commands) {
-            Serial.println(command.name + " -> " + command.description);
+        for (uint8_t i = 0; i < m_table.count; i++) {
+            Serial.print(m_table.commands[i].name);
+            Serial.print(" -> ");
+            Serial.println(m_table.commands[i].description);
         }
     }
 
-    virtual void parser(const std::vector<String>& cmd) {
-        Serial.println("MainCommand parser");   
-        if(cmd.size() > 0) {
-            runCallback(cmd[0], (void*)&cmd);
-        } 
+    virtual void parser(const CommandArgs& cmd) {
+        if(cmd.argc > 0) {
+            runCallback(cmd.argv[0], cmd);
+        }
     }
 
 };
 
-#endif /* MAINCOMMAND_H_ */
\ No newline at end of file
+#endif /* MAINCOMMAND_H_ */
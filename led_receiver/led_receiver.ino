@@ -1,20 +1,70 @@
 #include <Arduino.h>
 #include <esp_now.h>
 #include <WiFi.h>
-#include <FastLED.h>
 #include <uClock.h>
+#include <esp_timer.h>
+#include <Preferences.h>
+#include <atomic>
+
+// Use FastLED's I2S parallel driver instead of one RMT channel per strip
+// (must be defined before FastLED.h is included)
+#define LED_USE_I2S 0
+#if LED_USE_I2S
+#define FASTLED_ESP32_I2S true
+#endif
 
-// LED strip configuration
-#define LED_PIN     4
-#define NUM_LEDS    33
+#include <FastLED.h>
+
+// LED strip configuration: up to 8 strips driven in parallel
+#define LED_STRIP_COUNT 1
+#define LEDS_PER_STRIP  33
+#define LED_STRIP_PINS  {4, 16, 17, 18, 19, 21, 22, 23}
+#define NUM_LEDS    (LED_STRIP_COUNT * LEDS_PER_STRIP)
 #define LED_TYPE    WS2812B
 #define COLOR_ORDER GRB
 
+// Frame pacing: frames are only pushed when something changed, at most this often
+#define LED_MAX_FPS 100
+#define LED_STATS_INTERVAL_MS 5000  // Print frame statistics (0 = off)
+
+// Layout: segments of the strip(s) mapped to the tempo or to a channel.
+// Set over the air (MSG_LAYOUT) or with the serial "layout" command.
+#define LED_MAX_SEGMENTS 8
+#define LED_MAX_CHANNELS 4
+#define SEGMENT_TEMPO    0xFF  // Segment shows the beat rather than a channel
+#define SEGMENT_REVERSE  0x01  // Segment runs from its last LED to its first
+#define LAYOUT_BLOB_VERSION 1  // Bump when LedLayout changes
+
+// Beat-synced effects (EFFECT_CLASSIC = one LED per step, white beat flash)
+#define LED_EFFECT   EFFECT_CLASSIC
+#define LED_PALETTE  0     // 0 party, 1 ocean, 2 lava, 3 forest, 4 heat
+#define EFFECT_DECAY 215   // Trail level kept per frame, 8.8 (256 = no decay)
+
 // Timing constants
 #define CLOCK_TIMEOUT 2000  // Connection timeout in ms
 
+// Predictive beat scheduling
+#define RADIO_LATENCY_US 2000       // Typical leader beat -> BEAT frame arrival
+#define LED_OUTPUT_LATENCY_US 1500  // Timer fire -> LEDs lit (loop wake + show)
+#define BEAT_PHASE_GAIN 4           // Phase error divisor per BEAT frame (PLL gain)
+#define FREE_RUN_TIMEOUT 10000      // Keep flashing this long without BEAT frames (ms)
+#define BEAT_PHASE_IDLE 0xFFFF      // Beat phase reported while the timeline is stopped
+
+// Sync group ID (must match the metronome's); default only, the "group"
+// command stores another one in flash. IDs up to SYNC_GROUP_RESERVED_MAX
+// are where frames without a group field land (their type comes first).
+#define SYNC_GROUP_ID 0x0100
+#define SYNC_GROUP_RESERVED_MAX 0x00FF
+
+// Received frames are queued by the ESP-NOW callback and handled by a
+// receiver task, so nothing slow runs in the WiFi driver's context
+#define RX_RING_SIZE 16             // Frames (power of two)
+#define RX_TASK_PRIORITY 5          // Above loop(), below the WiFi task
+#define SYNC_DEBUG 1                // Log protocol events to Serial (0 = silent)
+
 // Forward declarations
 class LEDDisplay;
+class BeatTimeline;
 class SyncFollower;
 
 // Message types from the protocol
@@ -23,11 +73,14 @@ typedef enum {
   MSG_BEAT = 1,
   MSG_BAR = 2,
   MSG_CONTROL = 3,
-  MSG_PATTERN = 4
+  MSG_PATTERN = 4,
+  MSG_ASSIGN = 5,
+  MSG_LAYOUT = 6
 } MessageType;
 
 // Protocol message structures
 typedef struct {
+  uint16_t groupID;           // Sync group/session ID (2 bytes)
   MessageType type;           // Message type (1 byte)
   uint8_t deviceID[6];        // MAC address of sender (6 bytes)
   uint32_t sequenceNum;       // Sequence number (4 bytes)
@@ -72,20 +125,407 @@ typedef struct {
       uint8_t enabled;        // Channel enabled state
       uint8_t reserved[2];    // Reserved
     } pattern;
+    
+    struct {
+      uint16_t layoutID;      // Layout version; segments of one layout share it
+      uint8_t segmentIndex;   // Index of this segment
+      uint8_t segmentCount;   // Number of segments in the layout
+      uint16_t start;         // First LED
+      uint16_t length;        // Number of LEDs
+      uint8_t channel;        // Channel shown, or SEGMENT_TEMPO
+      uint8_t flags;          // SEGMENT_REVERSE
+      uint8_t reserved[2];    // Reserved
+    } layout;
   } data;
 } SyncMessage;
 
+// LED layout as received and persisted (the NVS blob is this struct)
+struct LayoutSegment {
+  uint16_t start;             // First physical LED
+  uint16_t length;            // Number of LEDs
+  uint8_t channel;            // Channel shown, or SEGMENT_TEMPO
+  uint8_t flags;              // SEGMENT_REVERSE
+};
+
+struct LedLayout {
+  uint16_t layoutID;          // From the leader; 0 = set locally
+  uint8_t version;
+  uint8_t segmentCount;
+  LayoutSegment segments[LED_MAX_SEGMENTS];
+  
+  bool isValid() const {
+    if (version != LAYOUT_BLOB_VERSION) return false;
+    if (segmentCount == 0 || segmentCount > LED_MAX_SEGMENTS) return false;
+    for (uint8_t i = 0; i < segmentCount; i++) {
+      const LayoutSegment& seg = segments[i];
+      if (seg.length == 0 || (uint32_t)seg.start + seg.length > NUM_LEDS) return false;
+      if (seg.channel != SEGMENT_TEMPO && seg.channel >= LED_MAX_CHANNELS) return false;
+      
+      // Each physical LED belongs to at most one segment
+      for (uint8_t j = 0; j < i; j++) {
+        const LayoutSegment& other = segments[j];
+        if (seg.start < other.start + other.length && other.start < seg.start + seg.length) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  
+  // Tempo section followed by two channel sections of equal size
+  static LedLayout defaults() {
+    LedLayout layout = {};
+    uint16_t third = NUM_LEDS / 3;
+    layout.version = LAYOUT_BLOB_VERSION;
+    layout.segmentCount = 3;
+    layout.segments[0] = {0, third, SEGMENT_TEMPO, 0};
+    layout.segments[1] = {third, third, 0, 0};
+    layout.segments[2] = {(uint16_t)(2 * third), third, 1, 0};
+    return layout;
+  }
+  
+  bool load() {
+    Preferences prefs;
+    prefs.begin("led_rx", true);
+    size_t len = prefs.getBytes("layout", this, sizeof(*this));
+    prefs.end();
+    return len == sizeof(*this) && isValid();
+  }
+  
+  void save() const {
+    Preferences prefs;
+    prefs.begin("led_rx", false);
+    prefs.putBytes("layout", this, sizeof(*this));
+    prefs.end();
+  }
+  
+  void print() const {
+    Serial.printf("LED layout %u: %u segments\n", layoutID, segmentCount);
+    for (uint8_t i = 0; i < segmentCount; i++) {
+      const LayoutSegment& seg = segments[i];
+      if (seg.channel == SEGMENT_TEMPO) {
+        Serial.printf("  %u: tempo", i);
+      } else {
+        Serial.printf("  %u: channel %u", i, seg.channel);
+      }
+      Serial.printf(", LEDs %u-%u%s\n", seg.start, seg.start + seg.length - 1,
+                    (seg.flags & SEGMENT_REVERSE) ? ", reversed" : "");
+    }
+  }
+};
+
+// A received frame with its local arrival time
+struct RxFrame {
+  SyncMessage msg;
+  int64_t rxTime;             // esp_timer_get_time() in the ESP-NOW callback
+};
+
+// Single-producer/single-consumer ring from the ESP-NOW callback to the
+// receiver task. Lock-free: each side only writes its own index.
+template <size_t SIZE>
+class FrameRing {
+  static_assert((SIZE & (SIZE - 1)) == 0, "Ring size must be a power of two");
+  
+private:
+  RxFrame frames[SIZE];
+  std::atomic<uint32_t> head{0};  // Next slot to write (producer)
+  std::atomic<uint32_t> tail{0};  // Next slot to read (consumer)
+  volatile uint32_t dropped = 0;  // Frames lost to a full ring
+
+public:
+  bool push(const uint8_t* data, int64_t rxTime) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= SIZE) {
+      dropped++;
+      return false;
+    }
+    RxFrame& frame = frames[h & (SIZE - 1)];
+    memcpy(&frame.msg, data, sizeof(SyncMessage));
+    frame.rxTime = rxTime;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+  
+  bool pop(RxFrame& out) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    out = frames[t & (SIZE - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+  
+  uint32_t getDropped() const { return dropped; }
+};
+
 // LED Display class to handle visual feedback
+// Pins as compile-time constants for FastLED's templates
+constexpr uint8_t STRIP_PINS[] = LED_STRIP_PINS;
+static_assert(LED_STRIP_COUNT >= 1 && LED_STRIP_COUNT <= 8, "1 to 8 LED strips supported");
+
+// One controller per strip; all strips are sent in parallel by FastLED.show()
+CLEDController* stripControllers[LED_STRIP_COUNT];
+
+template <uint8_t STRIP>
+void addStrips(CRGB* buffer) {
+  if constexpr (STRIP < LED_STRIP_COUNT) {
+    stripControllers[STRIP] = &FastLED.addLeds<LED_TYPE, STRIP_PINS[STRIP], COLOR_ORDER>(
+        buffer + STRIP * LEDS_PER_STRIP, LEDS_PER_STRIP);
+    stripControllers[STRIP]->setCorrection(TypicalLEDStrip);
+    addStrips<STRIP + 1>(buffer);
+  }
+}
+
+enum EffectMode : uint8_t {
+  EFFECT_CLASSIC = 0,  // One LED per step, white flash on the beat
+  EFFECT_PULSE,        // Sections pulse with a decaying envelope every beat
+  EFFECT_CHASE,        // A head runs across the tempo section once per beat
+  EFFECT_TRAILS,       // Beats and steps leave decaying trails
+  EFFECT_COUNT
+};
+
+// Each accent class has its own palette offset and level
+enum Accent : uint8_t {
+  ACCENT_DOWNBEAT = 0,
+  ACCENT_HIT,
+  ACCENT_REST,
+  ACCENT_COUNT
+};
+
+// Beat-synced effects engine. Pixel levels are 8.8 fixed point (0x0000 -
+// 0xFFFF = brightness 0 - 255.996), so trails fade smoothly without float
+// math; colors come from a 256-entry LUT built once from a FastLED palette.
+// Per-pixel work is confined to fill/decay/colorize loops over flat arrays.
+class EffectsEngine {
+private:
+  uint16_t level[NUM_LEDS];      // 8.8 brightness per pixel
+  uint8_t colorIndex[NUM_LEDS];  // Palette LUT index per pixel
+  CRGB paletteLut[256];
+  uint16_t envelope[256];        // 8.8 pulse envelope over one beat
+  
+  EffectMode mode = LED_EFFECT;
+  uint16_t decay = EFFECT_DECAY;
+  
+  const uint8_t accentColor[ACCENT_COUNT] = {0, 96, 160};
+  const uint16_t accentLevel[ACCENT_COUNT] = {0xFFFF, 0xC000, 0x3000};
+
+public:
+  void begin() {
+    // Exponential decay from full to exactly zero over one beat
+    const float floorLevel = expf(-4.0f);
+    for (int i = 0; i < 256; i++) {
+      float e = (expf(-4.0f * i / 256.0f) - floorLevel) / (1.0f - floorLevel);
+      envelope[i] = (uint16_t)(e * 65535.0f);
+    }
+    memset(level, 0, sizeof(level));
+    memset(colorIndex, 0, sizeof(colorIndex));
+    setPalette(LED_PALETTE);
+  }
+  
+  void setMode(EffectMode newMode) {
+    if (newMode < EFFECT_COUNT) {
+      mode = newMode;
+      clearAll();
+    }
+  }
+  
+  EffectMode getMode() const { return mode; }
+  
+  void setPalette(uint8_t index) {
+    CRGBPalette16 palette;
+    switch (index) {
+      case 1:  palette = OceanColors_p; break;
+      case 2:  palette = LavaColors_p; break;
+      case 3:  palette = ForestColors_p; break;
+      case 4:  palette = HeatColors_p; break;
+      default: palette = PartyColors_p; break;
+    }
+    for (int i = 0; i < 256; i++) {
+      paletteLut[i] = ColorFromPalette(palette, i, 255, LINEARBLEND);
+    }
+  }
+  
+  // Tempo section: phase is the position within the current beat (0-0xFFFF);
+  // chaseHead is the section's last chase head pixel (section relative)
+  void renderMain(uint16_t start, uint16_t count, uint16_t phase, bool beat, Accent accent,
+                  uint16_t& chaseHead) {
+    if (count == 0) return;
+    uint16_t peak = accentLevel[accent];
+    uint8_t color = accentColor[accent];
+    
+    switch (mode) {
+      case EFFECT_PULSE:
+        fill(start, count, scale(envelope[phase >> 8], peak), color);
+        break;
+        
+      case EFFECT_CHASE: {
+        decayRange(start, count);
+        // Stopped: no head, let the trail fade out
+        if (phase == BEAT_PHASE_IDLE) break;
+        
+        // Light the pixels the head reached since the last frame; a head
+        // that hasn't moved is left to decay like the rest of the trail
+        uint16_t head = ((uint32_t)phase * count) >> 16;
+        if (beat || head < chaseHead) {
+          deposit(start, head + 1, peak, color);
+        } else if (head > chaseHead) {
+          deposit(start + chaseHead + 1, head - chaseHead, peak, color);
+        }
+        chaseHead = head;
+        break;
+      }
+        
+      case EFFECT_TRAILS:
+        decayRange(start, count);
+        if (beat) deposit(start, count, peak, color);
+        break;
+        
+      default:
+        break;
+    }
+  }
+  
+  // Channel section: the current step lights a block of pixels (on the
+  // beat that reached it; trails then fade until the next one)
+  void renderSteps(uint16_t start, uint16_t count, uint8_t step, uint8_t steps,
+                   uint16_t phase, bool beat, Accent accent) {
+    if (count == 0 || steps == 0) return;
+    uint16_t blockStart = start + (uint32_t)step * count / steps;
+    uint16_t blockLength = max(1, count / steps);
+    uint16_t peak = accentLevel[accent];
+    uint8_t color = accentColor[accent];
+    
+    if (mode == EFFECT_PULSE) {
+      fill(start, count, 0, color);
+      fill(blockStart, blockLength, scale(envelope[phase >> 8], peak), color);
+    } else {
+      decayRange(start, count);
+      if (beat) deposit(blockStart, blockLength, peak, color);
+    }
+  }
+  
+  void clearRange(uint16_t start, uint16_t count) {
+    memset(level + start, 0, count * sizeof(level[0]));
+  }
+  
+  void clearAll() {
+    memset(level, 0, sizeof(level));
+  }
+  
+  // Map levels through the palette LUT into the frame buffer; map holds the
+  // physical LED of each logical pixel. Returns true if any pixel is still lit.
+  bool colorize(CRGB* out, const uint16_t* map, uint16_t count) {
+    uint16_t lit = 0;
+    const uint16_t* l = level;
+    const uint8_t* c = colorIndex;
+    for (uint16_t i = 0; i < count; i++) {
+      uint16_t s = (l[i] >> 8) + 1;  // 1-256, so 0 stays black
+      const CRGB& rgb = paletteLut[c[i]];
+      CRGB& px = out[map[i]];
+      px.r = (rgb.r * s) >> 8;
+      px.g = (rgb.g * s) >> 8;
+      px.b = (rgb.b * s) >> 8;
+      lit |= l[i] & 0xFF00;
+    }
+    return lit != 0;
+  }
+
+private:
+  static uint16_t scale(uint16_t value, uint16_t amount) {
+    return ((uint32_t)value * amount) >> 16;
+  }
+  
+  void decayRange(uint16_t start, uint16_t count) {
+    uint16_t* l = level + start;
+    for (uint16_t i = 0; i < count; i++) {
+      l[i] = ((uint32_t)l[i] * decay) >> 8;
+    }
+  }
+  
+  // Set a level with a palette gradient (a quarter of the palette) across
+  // the range; colors step in 8.8 to avoid a divide per pixel
+  void fill(uint16_t start, uint16_t count, uint16_t value, uint8_t color) {
+    uint16_t* l = level + start;
+    uint8_t* c = colorIndex + start;
+    uint16_t step = (64 << 8) / count;
+    uint16_t index = color << 8;
+    for (uint16_t i = 0; i < count; i++) {
+      l[i] = value;
+      c[i] = index >> 8;
+      index += step;
+    }
+  }
+  
+  // Raise levels in a single accent color; existing trails aren't cut
+  void deposit(uint16_t start, uint16_t count, uint16_t value, uint8_t color) {
+    uint16_t* l = level + start;
+    uint8_t* c = colorIndex + start;
+    for (uint16_t i = 0; i < count; i++) {
+      if (value > l[i]) {
+        l[i] = value;
+        c[i] = color;
+      }
+    }
+  }
+};
+
 class LEDDisplay {
 private:
-  CRGB* leds;
-  uint8_t numLeds;
-  uint8_t mainSection;    // Number of LEDs in main tempo section
-  uint8_t channelSection; // Number of LEDs per channel section
+  // Double-buffered pixels: frames are rendered into the back buffer while
+  // the output task sends the front buffer to the strips
+  CRGB* buffers[2];
+  uint8_t backBuffer = 1;
+  CRGB* leds;             // Current back buffer
+  TaskHandle_t outputTask = nullptr;
+  SemaphoreHandle_t outputIdle = nullptr;
+  volatile uint32_t outputTimeMax = 0;
+  
+  uint16_t numLeds;
+  
+  // Compiled layout: each segment becomes a contiguous run of logical
+  // pixels, and pixelMap gives the physical LED of every logical pixel, so
+  // rendering never looks at segment offsets or direction
+  struct Section {
+    uint16_t start;        // First logical pixel
+    uint16_t length;
+    uint8_t channel;       // Channel shown, or SEGMENT_TEMPO
+    uint16_t chaseHead;    // Effect state
+  };
+  Section sections[LED_MAX_SEGMENTS];
+  uint8_t sectionCount = 0;
+  uint16_t mappedLeds = 0;
+  uint16_t pixelMap[NUM_LEDS];
+  LedLayout layout;
+  
+  // Layout handed over by the receiver task or serial console, compiled
+  // by update() between frames
+  LedLayout pendingLayout;
+  volatile bool layoutPending = false;
+  portMUX_TYPE layoutMux = portMUX_INITIALIZER_UNLOCKED;
   
   uint32_t lastBeatTime = 0;
   uint32_t beatDuration = 100; // Flash duration in ms
   
+  // Dirty-frame tracking: the strip is only re-rendered when the beat state
+  // or an animation changes
+  bool dirty = true;
+  // Beat handed over by the timeline (timer or receiver task); update()
+  // applies it in loop(), so the render state has a single writer
+  std::atomic<uint32_t> pendingBeatPosition{0};
+  std::atomic<bool> beatPending{false};  // A beat bypasses the FPS cap
+  bool flashOn = false;
+  uint32_t lastFrameTime = 0;
+  bool animating = false;             // Effects need a frame every FPS period
+  
+  EffectsEngine effects;
+  
+  // Frame statistics
+  uint32_t framesPushed = 0;
+  uint32_t frameTimeTotal = 0;   // Render + hand-off time since last report (us)
+  uint32_t frameTimeMax = 0;
+  uint32_t lastStatsTime = 0;
+  
   // Enhanced pattern tracking
   struct ChannelState {
     bool enabled;
@@ -94,84 +534,277 @@ private:
     uint16_t pattern;
     uint32_t lastUpdateTick;
   };
-  ChannelState channels[2];
+  ChannelState channels[LED_MAX_CHANNELS];
   
   // Global pattern sync
   uint32_t globalTick = 0;
   uint16_t totalPatternLength = 4;
 
 public:
-  LEDDisplay(CRGB* ledArray, uint8_t totalLeds) : leds(ledArray), numLeds(totalLeds) {
-    // Divide strip into 3 sections (main + 2 channels)
-    mainSection = numLeds / 3;
-    channelSection = mainSection;
-    
+  LEDDisplay(CRGB* frontBuffer, CRGB* backBuffer, uint16_t totalLeds)
+      : buffers{frontBuffer, backBuffer}, leds(backBuffer), numLeds(totalLeds) {
     // Initialize channel states
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < LED_MAX_CHANNELS; i++) {
       channels[i] = {false, 0, 4, 0, 0};
     }
+  }
+
+  // Load the stored layout and start the output task (FastLED.show() runs
+  // there, on the radio core)
+  void begin() {
+    effects.begin();
+    if (!layout.load()) {
+      layout = LedLayout::defaults();
+    }
+    compileLayout();
+    layout.print();
     
-    Serial.printf("LED sections: total=%d, main=%d, channel=%d\n",
-                 numLeds, mainSection, channelSection);
+    outputIdle = xSemaphoreCreateBinary();
+    xSemaphoreGive(outputIdle);
+    xTaskCreatePinnedToCore(outputTaskEntry, "led_output", 4096, this, 2, &outputTask, 0);
   }
 
   void clear() {
-    FastLED.clear();
+    fill_solid(leds, numLeds, CRGB::Black);
   }
 
+  // Hand the back buffer to the output task and start rendering into the
+  // other one. Only waits if the previous frame is still being sent.
   void show() {
-    FastLED.show();
+    xSemaphoreTake(outputIdle, portMAX_DELAY);
+    for (uint8_t s = 0; s < LED_STRIP_COUNT; s++) {
+      stripControllers[s]->setLeds(leds + s * LEDS_PER_STRIP, LEDS_PER_STRIP);
+    }
+    xTaskNotifyGive(outputTask);
+    
+    backBuffer ^= 1;
+    leds = buffers[backBuffer];
   }
 
-  void updateMainBeat() {
+  // Render and push a frame if something changed and the FPS cap allows it.
+  // beatPhase is the position within the current beat from the timeline.
+  // Returns true if a frame was pushed.
+  bool update(uint16_t beatPhase) {
+    uint32_t now = micros();
+    if (!beatPending.load(std::memory_order_relaxed) &&
+        now - lastFrameTime < 1000000UL / LED_MAX_FPS) {
+      return false;
+    }
+    bool beat = beatPending.exchange(false, std::memory_order_acquire);
+    if (beat) {
+      applyBeat(pendingBeatPosition.load(std::memory_order_relaxed));
+    }
+    
+    if (layoutPending) {
+      applyPendingLayout();
+    }
+    
+    // Time-driven changes: the classic flash ending, or running effects
+    bool flash = millis() - lastBeatTime < beatDuration;
+    if (flash != flashOn) {
+      flashOn = flash;
+      dirty = true;
+    }
+    if (!dirty && !animating) {
+      return false;
+    }
+    
+    if (effects.getMode() == EFFECT_CLASSIC) {
+      // Buffers alternate, so every frame is rendered from scratch
+      clear();
+      updateMainBeat();
+      updateChannels();
+      animating = false;
+    } else {
+      // Keep rendering while anything is lit or the phase moves; once the
+      // timeline stops and the trails have faded, frames stop too
+      animating = renderEffects(beatPhase, beat) || beatPhase != BEAT_PHASE_IDLE;
+    }
+    show();
+    dirty = false;
+    lastFrameTime = now;
+    
+    uint32_t frameTime = micros() - now;
+    framesPushed++;
+    frameTimeTotal += frameTime;
+    if (frameTime > frameTimeMax) frameTimeMax = frameTime;
+    return true;
+  }
+  
+  // Print frames per second pushed and CPU time per frame, then reset
+  void reportStats() {
+    if (LED_STATS_INTERVAL_MS == 0) return;
     uint32_t now = millis();
-    if (now - lastBeatTime < beatDuration) {
-      // Flash white on beat
-      for (int i = 0; i < mainSection; i++) {
-        leds[i] = CRGB::White;
+    uint32_t elapsed = now - lastStatsTime;
+    if (elapsed < LED_STATS_INTERVAL_MS) return;
+    
+    Serial.printf("LED frames: %.1f fps, render avg %lu us, max %lu us, output max %lu us\n",
+                 framesPushed * 1000.0f / elapsed,
+                 framesPushed ? frameTimeTotal / framesPushed : 0,
+                 frameTimeMax,
+                 outputTimeMax);
+    framesPushed = 0;
+    frameTimeTotal = 0;
+    frameTimeMax = 0;
+    outputTimeMax = 0;
+    lastStatsTime = now;
+  }
+  
+  void markDirty() {
+    dirty = true;
+  }
+  
+  void setEffect(EffectMode mode) {
+    effects.setMode(mode);
+    dirty = true;
+  }
+  
+  void setPalette(uint8_t index) {
+    effects.setPalette(index);
+    dirty = true;
+  }
+  
+  // Queue a new layout (any task); it's validated, compiled and stored
+  // before the next frame. Returns false if the layout is invalid.
+  bool requestLayout(const LedLayout& newLayout) {
+    if (!newLayout.isValid()) return false;
+    portENTER_CRITICAL(&layoutMux);
+    pendingLayout = newLayout;
+    layoutPending = true;
+    portEXIT_CRITICAL(&layoutMux);
+    return true;
+  }
+  
+  const LedLayout& getLayout() const { return layout; }
+  
+  void applyPendingLayout() {
+    LedLayout next;
+    portENTER_CRITICAL(&layoutMux);
+    next = pendingLayout;
+    layoutPending = false;
+    portEXIT_CRITICAL(&layoutMux);
+    
+    if (memcmp(&next, &layout, sizeof(layout)) == 0) return;
+    layout = next;
+    compileLayout();
+    layout.save();
+    layout.print();
+  }
+  
+  // Build the section table and pixel lookup table from the layout
+  void compileLayout() {
+    uint16_t logical = 0;
+    sectionCount = layout.segmentCount;
+    for (uint8_t i = 0; i < sectionCount; i++) {
+      const LayoutSegment& seg = layout.segments[i];
+      sections[i] = {logical, seg.length, seg.channel, 0};
+      
+      bool reverse = seg.flags & SEGMENT_REVERSE;
+      for (uint16_t j = 0; j < seg.length; j++) {
+        pixelMap[logical + j] = reverse ? seg.start + seg.length - 1 - j : seg.start + j;
       }
-    } else {
-      // Clear main section
-      for (int i = 0; i < mainSection; i++) {
-        leds[i] = CRGB::Black;
+      logical += seg.length;
+    }
+    mappedLeds = logical;
+    
+    effects.clearAll();
+    dirty = true;
+  }
+  
+  // Sends the strips in parallel; frame time is that of the longest strip
+  static void outputTaskEntry(void* arg) {
+    LEDDisplay* self = static_cast<LEDDisplay*>(arg);
+    for (;;) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      uint32_t start = micros();
+      FastLED.show();
+      uint32_t elapsed = micros() - start;
+      if (elapsed > self->outputTimeMax) self->outputTimeMax = elapsed;
+      xSemaphoreGive(self->outputIdle);
+    }
+  }
+
+  // Returns true while any pixel is still lit
+  bool renderEffects(uint16_t beatPhase, bool beat) {
+    Accent mainAccent = (totalPatternLength && globalTick % totalPatternLength == 0) ? ACCENT_DOWNBEAT : ACCENT_HIT;
+    
+    for (uint8_t s = 0; s < sectionCount; s++) {
+      Section& section = sections[s];
+      if (section.channel == SEGMENT_TEMPO) {
+        effects.renderMain(section.start, section.length, beatPhase, beat, mainAccent,
+                           section.chaseHead);
+        continue;
+      }
+      
+      const ChannelState& channel = channels[section.channel];
+      if (!channel.enabled) {
+        effects.clearRange(section.start, section.length);
+        continue;
+      }
+      
+      uint8_t step = channel.currentBeat;
+      Accent accent = ACCENT_REST;
+      if (step == 0) {
+        accent = ACCENT_DOWNBEAT;
+      } else if ((channel.pattern >> (step - 1)) & 1) {
+        accent = ACCENT_HIT;
+      }
+      effects.renderSteps(section.start, section.length, step, channel.barLength,
+                          beatPhase, beat, accent);
+    }
+    
+    // Unmapped LEDs stay dark
+    clear();
+    return effects.colorize(leds, pixelMap, mappedLeds);
+  }
+
+  void updateMainBeat() {
+    // Flash white on beat (the frame starts cleared)
+    if (!flashOn) return;
+    for (uint8_t s = 0; s < sectionCount; s++) {
+      if (sections[s].channel != SEGMENT_TEMPO) continue;
+      const uint16_t* map = pixelMap + sections[s].start;
+      for (uint16_t i = 0; i < sections[s].length; i++) {
+        leds[map[i]] = CRGB::White;
       }
     }
   }
 
   void updateChannels() {
-    for (int i = 0; i < 2; i++) {
-      if (channels[i].enabled) {
-        int startLed = mainSection + (i * channelSection);
-        int endLed = startLed + channelSection;
-        
-        // Calculate which LEDs should be lit based on current beat
-        for (int led = startLed; led < endLed; led++) {
-          bool isActive = false;
-          
-          // First beat is always active
-          if (channels[i].currentBeat == 0) {
-            isActive = true;
-          } else {
-            // Check pattern for other beats
-            isActive = (channels[i].pattern >> (channels[i].currentBeat - 1)) & 1;
-          }
-          
-          if (led - startLed == channels[i].currentBeat) {
-            leds[led] = isActive ? CRGB::White : CRGB::Red;
-          } else {
-            leds[led] = CRGB::Black;
-          }
-        }
+    for (uint8_t s = 0; s < sectionCount; s++) {
+      const Section& section = sections[s];
+      if (section.channel == SEGMENT_TEMPO) continue;
+      const ChannelState& channel = channels[section.channel];
+      if (!channel.enabled || channel.currentBeat >= section.length) continue;
+      
+      bool isActive = false;
+      
+      // First beat is always active
+      if (channel.currentBeat == 0) {
+        isActive = true;
+      } else {
+        // Check pattern for other beats
+        isActive = (channel.pattern >> (channel.currentBeat - 1)) & 1;
       }
+      
+      // One LED per step
+      leds[pixelMap[section.start + channel.currentBeat]] = isActive ? CRGB::White : CRGB::Red;
     }
   }
 
-  void onBeat(uint8_t beatPosition) {
+  // Any task: the beat is applied by the next update()
+  void onBeat(uint32_t beatPosition) {
+    pendingBeatPosition.store(beatPosition, std::memory_order_relaxed);
+    beatPending.store(true, std::memory_order_release);
+  }
+
+  void applyBeat(uint32_t beatPosition) {
     lastBeatTime = millis();
     globalTick = beatPosition;
+    dirty = true;
     
     // Update channel beats based on their individual lengths
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < LED_MAX_CHANNELS; i++) {
       if (channels[i].enabled) {
         channels[i].currentBeat = beatPosition % channels[i].barLength;
       }
@@ -179,12 +812,13 @@ public:
   }
 
   void updateChannelPattern(uint8_t channel, uint8_t beat, uint8_t length, uint16_t pattern, bool enabled) {
-    if (channel < 2) {
+    if (channel < LED_MAX_CHANNELS) {
       channels[channel].currentBeat = beat;
       channels[channel].barLength = length;
       channels[channel].pattern = pattern;
       channels[channel].enabled = enabled;
       channels[channel].lastUpdateTick = globalTick;
+      dirty = true;
     }
   }
 
@@ -193,6 +827,123 @@ public:
   }
 };
 
+// Local beat timeline: anchor + tempo from the leader. Beats are fired from a
+// local timer at the predicted beat time (minus the LED output latency), so
+// flashes don't carry radio jitter and keep going when frames are lost.
+class BeatTimeline {
+private:
+  LEDDisplay& display;
+  esp_timer_handle_t timer = nullptr;
+  portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+  
+  volatile bool running = false;
+  int64_t nextBeatTime = 0;      // Predicted local time of the next beat (us)
+  uint32_t nextBeatPosition = 0; // Beat position of the next beat
+  int64_t beatPeriod = 500000;   // us per beat (120 BPM)
+  uint32_t lastMessageTime = 0;  // millis() of the last BEAT frame
+  
+  // The timer is re-armed and the beat handed to the display under mux by
+  // whoever moved the prediction, so an older deadline or beat position can
+  // never overwrite a newer one
+  static void onTimer(void* arg) {
+    BeatTimeline* self = static_cast<BeatTimeline*>(arg);
+    
+    portENTER_CRITICAL(&self->mux);
+    uint32_t position = self->nextBeatPosition++;
+    self->nextBeatTime += self->beatPeriod;
+    if (self->running) {
+      self->arm(self->nextBeatTime - LED_OUTPUT_LATENCY_US);
+    }
+    self->display.onBeat(position);
+    portEXIT_CRITICAL(&self->mux);
+  }
+  
+  // Call with mux held (esp_timer start/stop are ISR-safe)
+  void arm(int64_t fireAt) {
+    int64_t delay = fireAt - esp_timer_get_time();
+    esp_timer_stop(timer);
+    esp_timer_start_once(timer, delay > 0 ? delay : 0);
+  }
+
+public:
+  BeatTimeline(LEDDisplay& disp) : display(disp) {}
+  
+  void begin() {
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.name = "beat_timeline";
+    esp_timer_create(&args, &timer);
+  }
+  
+  // Align the timeline with a BEAT frame received at rxTime (local us)
+  void onBeatMessage(uint32_t beatPosition, float bpm, int64_t rxTime) {
+    int64_t observed = rxTime - RADIO_LATENCY_US;
+    lastMessageTime = millis();
+    
+    portENTER_CRITICAL(&mux);
+    if (bpm > 0) {
+      beatPeriod = (int64_t)(60000000.0f / bpm);
+    }
+    
+    // Which predicted beat does this frame refer to: the last one fired
+    // (k = 0) or the upcoming one (k = 1, frame arrived early)
+    int64_t lastBeat = nextBeatTime - beatPeriod;
+    int64_t offset = observed - lastBeat;
+    int64_t k = (offset + beatPeriod / 2) / beatPeriod;
+    int64_t error = offset - k * beatPeriod;
+    
+    bool resync = !running || k < 0 || k > 1 || llabs(error) > beatPeriod / 4;
+    if (resync) {
+      // Hard sync: this beat just happened, the next one is a period away
+      nextBeatTime = observed + beatPeriod;
+      nextBeatPosition = beatPosition + 1;
+    } else {
+      // Soft phase correction (PLL); the leader's position wins
+      nextBeatTime += error / BEAT_PHASE_GAIN;
+      nextBeatPosition = beatPosition + 1 - k;
+    }
+    running = true;
+    arm(nextBeatTime - LED_OUTPUT_LATENCY_US);
+    if (resync) {
+      display.onBeat(beatPosition);
+    }
+    portEXIT_CRITICAL(&mux);
+  }
+  
+  void stop() {
+    portENTER_CRITICAL(&mux);
+    running = false;
+    esp_timer_stop(timer);
+    portEXIT_CRITICAL(&mux);
+  }
+  
+  bool isRunning() const { return running; }
+  
+  // Position within the current beat as it will appear on the LEDs:
+  // 0 = on the beat, 0xFFFF = a full period later (or stopped)
+  uint16_t phase() {
+    if (!running) return BEAT_PHASE_IDLE;
+    int64_t now = esp_timer_get_time() + LED_OUTPUT_LATENCY_US;
+    
+    portENTER_CRITICAL(&mux);
+    int64_t sinceBeat = now - (nextBeatTime - beatPeriod);
+    int64_t period = beatPeriod;
+    portEXIT_CRITICAL(&mux);
+    
+    if (sinceBeat <= 0) return 0;
+    if (sinceBeat >= period) return 0xFFFF;
+    return (uint16_t)((sinceBeat << 16) / period);
+  }
+  
+  // Stop free-running once the leader has been silent for too long
+  void checkTimeout() {
+    if (running && millis() - lastMessageTime > FREE_RUN_TIMEOUT) {
+      stop();
+    }
+  }
+};
+
 // Sync Follower class to handle protocol implementation
 class SyncFollower {
 private:
@@ -203,9 +954,16 @@ private:
   uint32_t lastClockTick = 0;
   
   LEDDisplay& display;
+  BeatTimeline& timeline;
+  Print* debugSink = nullptr;
+  
+  // Layout being assembled from MSG_LAYOUT frames
+  LedLayout incomingLayout = {};
+  uint8_t incomingSegments = 0;  // Bit mask of segments received
   
   struct TimingState {
     uint32_t latencyBuffer[8];
+    uint8_t latencyIndex;
     uint32_t averageLatency;
     uint32_t lastReceivedTick;
     uint32_t predictedNextTick;
@@ -213,43 +971,75 @@ private:
   } timing;
 
 public:
-  SyncFollower(LEDDisplay& disp) : display(disp) {
-    timing.averageLatency = 0;
+  SyncFollower(LEDDisplay& disp, BeatTimeline& tl) : display(disp), timeline(tl) {
+    memset(&timing, 0, sizeof(timing));
     timing.driftCorrection = 1.0;
   }
+  
+  // Where protocol events are logged (nullptr = silent)
+  void setDebugSink(Print* sink) {
+    debugSink = sink;
+  }
+  
+  // Handle one frame from the receive ring (receiver task context)
+  void handleFrame(const RxFrame& frame) {
+    switch (frame.msg.type) {
+      case MSG_CLOCK:
+        handleClock(frame.msg, frame.rxTime);
+        break;
+      case MSG_BEAT:
+        handleBeat(frame.msg, frame.rxTime);
+        break;
+      case MSG_BAR:
+        handleBar(frame.msg);
+        break;
+      case MSG_PATTERN:
+        handlePattern(frame.msg);
+        break;
+      case MSG_CONTROL:
+        handleControl(frame.msg);
+        break;
+      case MSG_LAYOUT:
+        handleLayout(frame.msg);
+        break;
+      default:
+        break;
+    }
+  }
 
-  void handleClock(const SyncMessage& msg) {
+  void handleClock(const SyncMessage& msg, int64_t rxTime) {
     lastClockTime = millis();
     lastClockTick = msg.data.clock.clockTick;
     
     if (connectionLost) {
       connectionLost = false;
-      Serial.println("Connection restored");
+      display.markDirty();
+      debug("Connection restored\n");
     }
 
     if (!isRunning) return;
 
     // Calculate message latency
-    uint32_t messageLatency = micros() - msg.timestamp;
+    uint32_t messageLatency = (uint32_t)rxTime - msg.timestamp;
     
     // Update timing state and apply PLL corrections
-    updateTimingState(messageLatency, msg.timestamp);
+    updateTimingState(messageLatency, msg.timestamp, rxTime);
     
     // Call uClock to maintain sync
     uClock.clockMe();
   }
 
-  void handleBeat(const SyncMessage& msg) {
+  void handleBeat(const SyncMessage& msg, int64_t rxTime) {
     // Update tempo if changed
     if (msg.data.beat.bpm != currentBpm) {
       currentBpm = msg.data.beat.bpm;
       uClock.setTempo(currentBpm);
     }
 
-    // Update beat position and trigger visual indication
-    display.onBeat(msg.data.beat.beatPosition);
+    // Align the local beat timeline; it fires the visual beat itself
+    timeline.onBeatMessage(msg.data.beat.beatPosition, currentBpm, rxTime);
     
-    Serial.printf("Beat: position=%d/%d, bpm=%.1f\n", 
+    debug("Beat: position=%d/%d, bpm=%.1f\n", 
                  msg.data.beat.beatPosition,
                  msg.data.bar.patternLength,
                  currentBpm);
@@ -259,20 +1049,20 @@ public:
     // Update total pattern length
     display.setTotalPatternLength(msg.data.bar.patternLength);
     
-    Serial.printf("Bar: global=%lu, total_length=%d, channels=%d\n", 
+    debug("Bar: global=%lu, total_length=%d, channels=%d\n", 
                  msg.data.bar.globalBar,
                  msg.data.bar.patternLength,
                  msg.data.bar.channelCount);
   }
 
   void handlePattern(const SyncMessage& msg) {
-    Serial.printf("Pattern: channel=%d, beat=%d/%d, enabled=%d\n",
+    debug("Pattern: channel=%d, beat=%d/%d, enabled=%d\n",
                  msg.data.pattern.channelId,
                  msg.data.pattern.currentBeat,
                  msg.data.pattern.barLength,
                  msg.data.pattern.enabled);
                  
-    if (msg.data.pattern.channelId < 2) {
+    if (msg.data.pattern.channelId < LED_MAX_CHANNELS) {
       display.updateChannelPattern(
         msg.data.pattern.channelId,
         msg.data.pattern.currentBeat,
@@ -283,6 +1073,38 @@ public:
     }
   }
 
+  // Collect layout segments; the layout is applied once all have arrived
+  void handleLayout(const SyncMessage& msg) {
+    uint8_t count = msg.data.layout.segmentCount;
+    uint8_t index = msg.data.layout.segmentIndex;
+    if (count == 0 || count > LED_MAX_SEGMENTS || index >= count) return;
+    
+    // A new layout ID (or shape) restarts assembly
+    if (msg.data.layout.layoutID != incomingLayout.layoutID ||
+        count != incomingLayout.segmentCount) {
+      incomingLayout = {};
+      incomingLayout.version = LAYOUT_BLOB_VERSION;
+      incomingLayout.layoutID = msg.data.layout.layoutID;
+      incomingLayout.segmentCount = count;
+      incomingSegments = 0;
+    }
+    
+    incomingLayout.segments[index] = {
+      msg.data.layout.start,
+      msg.data.layout.length,
+      msg.data.layout.channel,
+      msg.data.layout.flags
+    };
+    incomingSegments |= 1 << index;
+    
+    if (incomingSegments == (uint8_t)((1u << count) - 1)) {
+      incomingSegments = 0;
+      if (!display.requestLayout(incomingLayout)) {
+        debug("Invalid layout %u ignored\n", incomingLayout.layoutID);
+      }
+    }
+  }
+
   void handleControl(const SyncMessage& msg) {
     switch (msg.data.control.command) {
       case 1: // START
@@ -293,15 +1115,17 @@ public:
         break;
       case 2: // STOP
         isRunning = false;
+        timeline.stop();
         uClock.stop();
         break;
       case 3: // PAUSE
         isRunning = false;
+        timeline.stop();
         uClock.stop();
         break;
       case 4: // RESET
         // Reset all channel beats
-        for (uint8_t i = 0; i < 2; i++) {
+        for (uint8_t i = 0; i < LED_MAX_CHANNELS; i++) {
           display.updateChannelPattern(i, 0, 4, 0, false);
         }
         break;
@@ -312,26 +1136,37 @@ public:
     if (isRunning && millis() - lastClockTime > CLOCK_TIMEOUT) {
       if (!connectionLost) {
         connectionLost = true;
-        Serial.println("Connection to leader lost");
+        debug("Connection to leader lost\n");
       }
     }
   }
 
   void update() {
     checkConnection();
-    if (!connectionLost) {
-      display.updateMainBeat();
-      display.updateChannels();
-      display.show();
+    timeline.checkTimeout();
+    
+    // The timeline keeps the beat going through short radio dropouts
+    if (!connectionLost || timeline.isRunning()) {
+      display.update(timeline.phase());
     }
+    display.reportStats();
+  }
+
+  void debug(const char* format, ...) {
+    if (!debugSink) return;
+    char line[96];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    debugSink->print(line);
   }
 
 private:
-  void updateTimingState(uint32_t messageLatency, uint64_t messageTimestamp) {
+  void updateTimingState(uint32_t messageLatency, uint64_t messageTimestamp, int64_t rxTime) {
     // Update latency buffer (simple rolling average)
-    static uint8_t latencyIndex = 0;
-    timing.latencyBuffer[latencyIndex] = messageLatency;
-    latencyIndex = (latencyIndex + 1) % 8;
+    timing.latencyBuffer[timing.latencyIndex] = messageLatency;
+    timing.latencyIndex = (timing.latencyIndex + 1) % 8;
 
     // Calculate average latency
     uint32_t sum = 0;
@@ -343,7 +1178,7 @@ private:
     // Calculate phase error and apply corrections
     uint32_t tickInterval = 60000000 / (currentBpm * 24); // microseconds per tick
     uint64_t predictedArrivalTime = messageTimestamp + timing.averageLatency;
-    int32_t phaseError = micros() - predictedArrivalTime;
+    int32_t phaseError = (uint32_t)rxTime - predictedArrivalTime;
 
     // Apply tempo correction if phase error is significant
     if (abs(phaseError) > 100) { // More than 100μs error
@@ -359,51 +1194,193 @@ private:
 };
 
 // Global instances
-CRGB leds[NUM_LEDS];
+CRGB ledBuffers[2][NUM_LEDS];
+CRGB* leds = ledBuffers[0];
 LEDDisplay* display;
+BeatTimeline* timeline;
 SyncFollower* follower;
+volatile uint16_t syncGroupID = SYNC_GROUP_ID;
+volatile uint32_t foreignFrames = 0;  // Frames dropped for another group
+volatile uint32_t legacyFrames = 0;   // Frames dropped for having no group ID
+volatile uint32_t invalidFrames = 0;  // Frames of the wrong size
+FrameRing<RX_RING_SIZE> rxRing;
+TaskHandle_t receiverTaskHandle = nullptr;
+
+// Serial console line buffer
+char serialLine[96];
+uint8_t serialLineLength = 0;
+
+// "layout" prints the layout, "layout default" restores the default, and
+// "layout <seg> [<seg> ...]" sets one, each segment as
+// <channel|t>,<start>,<length>[,r] (t = tempo, r = reversed)
+void handleLayoutCommand(char* args) {
+  char* token = strtok(args, " ");
+  if (!token) {
+    display->getLayout().print();
+    return;
+  }
+  
+  LedLayout layout = {};
+  if (strcmp(token, "default") == 0) {
+    layout = LedLayout::defaults();
+  } else {
+    layout.version = LAYOUT_BLOB_VERSION;
+    for (; token; token = strtok(nullptr, " ")) {
+      if (layout.segmentCount >= LED_MAX_SEGMENTS) {
+        Serial.println("Too many layout segments");
+        return;
+      }
+      
+      char role[4];
+      unsigned start, length;
+      char reverse = 0;
+      if (sscanf(token, "%3[^,],%u,%u,%c", role, &start, &length, &reverse) < 3) {
+        Serial.printf("Bad layout segment: %s\n", token);
+        return;
+      }
+      
+      LayoutSegment& seg = layout.segments[layout.segmentCount++];
+      seg.start = start;
+      seg.length = length;
+      seg.channel = (role[0] == 't') ? SEGMENT_TEMPO : atoi(role);
+      seg.flags = (reverse == 'r') ? SEGMENT_REVERSE : 0;
+    }
+  }
+  
+  if (!display->requestLayout(layout)) {
+    Serial.println("Invalid layout");
+  }
+}
 
-// ESP-NOW callback
+// "group" prints the sync group ID, "group <id>" sets and stores it
+void handleGroupCommand(char* args) {
+  char* token = strtok(args, " ");
+  if (!token) {
+    Serial.printf("Sync group 0x%04X\n", syncGroupID);
+    return;
+  }
+  
+  unsigned long id = strtoul(token, nullptr, 0);
+  if (id <= SYNC_GROUP_RESERVED_MAX || id > 0xFFFF) {
+    Serial.printf("Group ID must be 0x%04X-0xFFFF\n", SYNC_GROUP_RESERVED_MAX + 1);
+    return;
+  }
+  
+  syncGroupID = id;
+  Preferences prefs;
+  prefs.begin("led_rx", false);
+  prefs.putUShort("group", syncGroupID);
+  prefs.end();
+}
+
+void printStats() {
+  Serial.printf("Sync group 0x%04X: %lu foreign, %lu legacy, %lu invalid frames, %lu ring drops\n",
+                syncGroupID, foreignFrames, legacyFrames, invalidFrames, rxRing.getDropped());
+}
+
+// Read serial input without blocking and run complete command lines
+void handleSerialCommands() {
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (serialLineLength < sizeof(serialLine) - 1) {
+        serialLine[serialLineLength++] = c;
+      }
+      continue;
+    }
+    if (serialLineLength == 0) continue;
+    
+    serialLine[serialLineLength] = '\0';
+    serialLineLength = 0;
+    if (strncmp(serialLine, "layout", 6) == 0 &&
+        (serialLine[6] == '\0' || serialLine[6] == ' ')) {
+      handleLayoutCommand(serialLine + 6);
+    } else if (strncmp(serialLine, "group", 5) == 0 &&
+               (serialLine[5] == '\0' || serialLine[5] == ' ')) {
+      handleGroupCommand(serialLine + 5);
+    } else if (strcmp(serialLine, "stats") == 0) {
+      printStats();
+    } else {
+      Serial.printf("Unknown command: %s\n", serialLine);
+    }
+  }
+}
+
+// Receiver task: drains the ring and runs the protocol handlers
+void receiverTask(void* arg) {
+  RxFrame frame;
+  uint32_t reportedDrops = 0;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    while (rxRing.pop(frame)) {
+      follower->handleFrame(frame);
+    }
+    
+    uint32_t drops = rxRing.getDropped();
+    if (drops != reportedDrops) {
+      follower->debug("Receive ring full: %lu frames dropped\n", drops);
+      reportedDrops = drops;
+    }
+  }
+}
+
+// ESP-NOW callback (WiFi task): filter, timestamp and queue only
 void onDataReceived(const uint8_t *mac, const uint8_t *data, int len) {
+  // Drop other groups' traffic before any other work (one compare)
+  uint16_t groupID = 0;
+  if (len >= (int)sizeof(groupID)) {
+    memcpy(&groupID, data, sizeof(groupID));
+  }
+  if (groupID != syncGroupID) {
+    // Frames without a group field carry their type here
+    if (groupID <= SYNC_GROUP_RESERVED_MAX) {
+      legacyFrames++;
+    } else {
+      foreignFrames++;
+    }
+    return;
+  }
+
   if (len != sizeof(SyncMessage)) {
-    Serial.printf("Invalid message size: %d\n", len);
+    invalidFrames++;
     return;
   }
 
-  const SyncMessage *msg = (const SyncMessage *)data;
-  
-  switch (msg->type) {
-    case MSG_CLOCK:
-      follower->handleClock(*msg);
-      break;
-    case MSG_BEAT:
-      follower->handleBeat(*msg);
-      break;
-    case MSG_BAR:
-      follower->handleBar(*msg);
-      break;
-    case MSG_PATTERN:
-      follower->handlePattern(*msg);
-      break;
-    case MSG_CONTROL:
-      follower->handleControl(*msg);
-      break;
+  if (rxRing.push(data, esp_timer_get_time())) {
+    xTaskNotifyGive(receiverTaskHandle);
   }
 }
 
 void setup() {
   Serial.begin(115200);
   
-  // Initialize LED strip
-  FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS)
-         .setCorrection(TypicalLEDStrip);
+  // Sync group from flash, before any frame can arrive
+  Preferences prefs;
+  prefs.begin("led_rx", true);
+  uint16_t storedGroup = prefs.getUShort("group", SYNC_GROUP_ID);
+  prefs.end();
+  if (storedGroup > SYNC_GROUP_RESERVED_MAX) {
+    syncGroupID = storedGroup;
+  }
+  
+  // Initialize LED strips
+  addStrips<0>(leds);
   FastLED.setBrightness(50);
   FastLED.clear();
   FastLED.show();
   
   // Create display and follower instances
-  display = new LEDDisplay(leds, NUM_LEDS);
-  follower = new SyncFollower(*display);
+  display = new LEDDisplay(ledBuffers[0], ledBuffers[1], NUM_LEDS);
+  timeline = new BeatTimeline(*display);
+  timeline->begin();
+  follower = new SyncFollower(*display, *timeline);
+#if SYNC_DEBUG
+  follower->setDebugSink(&Serial);
+#endif
+  
+  // Frames are processed on the app core, away from the WiFi task
+  xTaskCreatePinnedToCore(receiverTask, "sync_rx", 4096, nullptr, RX_TASK_PRIORITY,
+                          &receiverTaskHandle, 1);
   
   // Initialize WiFi in station mode
   WiFi.mode(WIFI_STA);
@@ -427,20 +1404,28 @@ void setup() {
   Serial.print("MAC Address: ");
   Serial.println(WiFi.macAddress());
   
-  // Show startup animation
-  for (int i = 0; i < NUM_LEDS; i++) {
-    leds[i] = CRGB::Green;
+  // Show startup animation (all strips at once)
+  for (int i = 0; i < LEDS_PER_STRIP; i++) {
+    for (int s = 0; s < LED_STRIP_COUNT; s++) {
+      leds[s * LEDS_PER_STRIP + i] = CRGB::Green;
+    }
     FastLED.show();
-    delay(20);
-    leds[i] = CRGB::Black;
+    delay(max(1, 660 / LEDS_PER_STRIP));
+    for (int s = 0; s < LED_STRIP_COUNT; s++) {
+      leds[s * LEDS_PER_STRIP + i] = CRGB::Black;
+    }
   }
   
   // Show ready state
   leds[0] = CRGB::Green;
   FastLED.show();
+  
+  // From here on frames are sent by the display's output task
+  display->begin();
 }
 
 void loop() {
+  handleSerialCommands();
   follower->update();
   delay(1); // Small delay to prevent CPU hogging
 } 
\ No newline at end of file
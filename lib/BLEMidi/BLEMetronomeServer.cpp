@@ -3,7 +3,7 @@
 void BLEMetronomeServerClass::begin(const std::string deviceName)
 {
     BLEMetronomeBase::begin(deviceName);
-    BLEServer *pServer = BLEDevice::createServer();
+    pServer = BLEDevice::createServer();
     pServer->setCallbacks(this);
     BLEAdvertising *pAdvertising = pServer->getAdvertising();
 
@@ -18,12 +18,11 @@ void BLEMetronomeServerClass::begin(const std::string deviceName)
         NIMBLE_PROPERTY::NOTIFY |
         NIMBLE_PROPERTY::WRITE_NR
     );
-    pCharacteristic->setCallbacks(new CharacteristicCallback([this](uint8_t *data, uint16_t size) { this->midi_receivePacket(data, size); }));
+    pCharacteristic->setCallbacks(new CharacteristicCallback([this](const uint8_t *data, uint16_t size) { this->midi_receivePacket(data, size); }));
     pServiceMidi->start();
     pAdvertising->addServiceUUID(pServiceMidi->getUUID());
- 
- 
- 
+
+    setFlushInterval(BLE_MIDI_FLUSH_INTERVAL_US);
 
     pAdvertising->start();
 }
@@ -42,16 +41,23 @@ bool BLEMetronomeServerClass::sendPacket(uint8_t *packet, uint16_t packetSize)
 {
     if(!connected)
         return false;
-    pCharacteristic->setValue(packet, packetSize);
-    pCharacteristic->notify();
+    // Straight from the packet buffer; reads of the characteristic return
+    // no payload, as the BLE-MIDI spec asks
+    pCharacteristic->notify(packet, packetSize);
     return true;
 } 
 
 
 
-void BLEMetronomeServerClass::onConnect(BLEServer* pServer)
+void BLEMetronomeServerClass::onConnect(BLEServer* pServer, ble_gap_conn_desc* desc)
 {
+    // One packet per connection event (interval in 1.25 ms units)
+    setFlushInterval(desc->conn_itvl * 1250);
+    setMaxPacketSize(pServer->getPeerMTU(desc->conn_handle) - 3);
+    connHandle = desc->conn_handle;
     connected = true;
+    if(clockOutput)
+        requestClockInterval();
     if(onConnectCallback != nullptr)
         onConnectCallback();
 }
@@ -59,23 +65,48 @@ void BLEMetronomeServerClass::onConnect(BLEServer* pServer)
 void BLEMetronomeServerClass::onDisconnect(BLEServer* pServer)
 {
     connected = false;
+    setMaxPacketSize(BLE_MIDI_DEFAULT_PACKET);
     if(onDisconnectCallback != nullptr)
         onDisconnectCallback();
     pServer->startAdvertising();
 }
 
-CharacteristicCallback::CharacteristicCallback(std::function<void(uint8_t*, uint16_t)> onWriteCallback, std::function<void()> onReadCallback) : onWriteCallback(onWriteCallback), onReadCallback(onReadCallback) {}
+void BLEMetronomeServerClass::setClockOutput(bool enabled)
+{
+    clockOutput = enabled;
+    if(enabled && connected)
+        requestClockInterval();
+}
+
+bool BLEMetronomeServerClass::isClockOutput()
+{
+    return clockOutput;
+}
+
+void BLEMetronomeServerClass::requestClockInterval()
+{
+    // 7.5 - 15 ms (1.25 ms units), no slave latency, 4 s supervision timeout.
+    // The central decides and the outcome isn't reported back, so flush at
+    // the shortest interval we asked for.
+    pServer->updateConnParams(connHandle, 6, 12, 0, 400);
+    setFlushInterval(BLE_MIDI_FLUSH_INTERVAL_US);
+}
 
-void CharacteristicCallback::onWrite(BLECharacteristic *pCharacteristic)
+void BLEMetronomeServerClass::onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc)
 {
-    std::string rxValue = pCharacteristic->getValue();
+    setMaxPacketSize(MTU - 3);
+}
 
-    if (rxValue.length() > 0 && onWriteCallback != nullptr)
-        onWriteCallback((uint8_t*)rxValue.c_str(), rxValue.length());
+CharacteristicCallback::CharacteristicCallback(std::function<void(const uint8_t*, uint16_t)> onWriteCallback, std::function<void()> onReadCallback) : onWriteCallback(onWriteCallback), onReadCallback(onReadCallback) {}
+
+bool CharacteristicCallback::onWriteData(BLECharacteristic *pCharacteristic, const uint8_t *data, size_t length, ble_gap_conn_desc *desc)
+{
+    if (length > 0 && onWriteCallback != nullptr)
+        onWriteCallback(data, length);
 
     vTaskDelay(0);      // We leave some time for the IDLE task call esp_task_wdt_reset_watchdog
                         // See comment from atanisoft here : https://github.com/espressif/arduino-esp32/issues/2493
-
+    return true;
 }
 
 BLEMetronomeServerClass BLEMetronomeServer;
\ No newline at end of file
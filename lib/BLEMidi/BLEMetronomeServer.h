@@ -0,0 +1,66 @@
+#ifndef BLE_METRONOME_SERVER_H
+#define BLE_METRONOME_SERVER_H
+
+#include "BLEMetronomeBase.h"
+
+
+class BLEMetronomeServerClass : public BLEMetronomeBase, public BLEServerCallbacks {
+public:
+    void begin(const std::string deviceName);
+
+    void setOnConnectCallback(void (*const onConnectCallback)());
+    void setOnDisconnectCallback(void (*const onDisconnectCallback)());
+
+    /**
+     * Clock output mode: the application's timing engine sends clockTick()
+     * and transport; this asks the central for a short connection interval
+     * so clock packets wait less between connection events.
+     * */
+    void setClockOutput(bool enabled);
+    bool isClockOutput();
+    
+
+
+ 
+    
+
+private:
+    virtual bool sendPacket(uint8_t *packet, uint16_t packetSize) override;
+    void onConnect(BLEServer* pServer, ble_gap_conn_desc* desc) override;
+    void onDisconnect(BLEServer* pServer) override;
+    void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) override;
+    
+    void (*onConnectCallback)() = nullptr;
+    void (*onDisconnectCallback)() = nullptr;
+    BLECharacteristic* pCharacteristic = nullptr; 
+    BLEServer* pServer = nullptr;
+    uint16_t connHandle = 0;
+    bool clockOutput = false;
+
+    void requestClockInterval();
+
+};
+
+
+class CharacteristicCallback: public BLECharacteristicCallbacks {
+public:
+    CharacteristicCallback(std::function<void(const uint8_t*, uint16_t)> onWriteCallback, std::function<void()> onReadCallback = nullptr);
+private:
+    /**
+     * Hands the written bytes to the parser where they lie (in the stack's
+     * mbuf); the value isn't stored, so a write costs no allocation or copy.
+     * */
+    bool onWriteData(BLECharacteristic *pCharacteristic, const uint8_t *data, size_t length, ble_gap_conn_desc *desc) override;
+    void onRead(BLECharacteristic *pCharacteristic) {
+        Serial.println("CharacteristicCallback::onRead");
+        if(onReadCallback != nullptr)
+            onReadCallback();
+    }
+    std::function<void(const uint8_t*, uint16_t)> onWriteCallback = nullptr;
+    std::function<void()> onReadCallback = nullptr;
+};
+
+
+extern BLEMetronomeServerClass BLEMetronomeServer;
+
+#endif
\ No newline at end of file
@@ -27,6 +27,20 @@ size_t Debug::write(uint8_t val)
     return 0;
 }
 
+size_t Debug::printf(const char *format, ...)
+{
+    if(stream == nullptr)
+        return 0;
+    char buffer[128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if(length < 0)
+        return 0;
+    return stream->write((const uint8_t *)buffer, min((size_t)length, sizeof(buffer) - 1));
+}
+
 void Debug::enable(Stream& stream)
 {
     this->stream = &stream;
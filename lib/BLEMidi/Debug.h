@@ -13,6 +13,9 @@ public:
     
     void enable(Stream& stream);
     void disable();
+    bool isEnabled() const { return stream != nullptr; }
+    // Skips the formatting when disabled, so the parser's traces cost nothing
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
 
 private:
     Stream *stream = nullptr;
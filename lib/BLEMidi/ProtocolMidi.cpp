@@ -125,12 +125,31 @@ void ProtocolMidi::pitchBend(uint8_t channel, float semitones, float range)
 // ###################################
 // IO
 
-void ProtocolMidi::midi_receivePacket(uint8_t *data, uint16_t size)
-{
-    debug.print("Received data : ");
-    for(uint8_t i=0; i<size; i++)
-        debug.printf("%x ", data[i]);
-    debug.println();
+void ProtocolMidi::midi_receivePacket(const uint8_t *data, uint16_t size)
+{
+    int64_t start = esp_timer_get_time();
+    parsePacket(data, size);
+    uint32_t elapsed = esp_timer_get_time() - start;
+
+    portENTER_CRITICAL(&txLock);
+    rxStats.packets++;
+    rxStats.bytes += size;
+    rxStats.totalParseUs += elapsed;
+    if(elapsed > rxStats.maxParseUs)
+        rxStats.maxParseUs = elapsed;
+    portEXIT_CRITICAL(&txLock);
+}
+
+// data is the characteristic write itself (see CharacteristicCallback) and
+// is only valid during the call
+void ProtocolMidi::parsePacket(const uint8_t *data, uint16_t size)
+{
+    if(debug.isEnabled()) {
+        debug.print("Received data : ");
+        for(uint16_t i=0; i<size; i++)
+            debug.printf("%x ", data[i]);
+        debug.println();
+    }
 
     if(size < 3) {
         debug.println("Invalid packet (size < 3)");
@@ -144,17 +163,28 @@ void ProtocolMidi::midi_receivePacket(uint8_t *data, uint16_t size)
 
     currentTimestamp = ((data[0] & 0b111111) << 7);
 
-    uint8_t *ptr = &data[1];
+    const uint8_t *ptr = &data[1];
+    const uint8_t *end = data + size;
 
     uint8_t runningStatus = 0;
 
-    while(ptr - data < size) {
+    while(ptr < end) {
         if(ptr[0] & 0b10000000) {
             currentTimestamp = (currentTimestamp & 0b1111110000000) | (ptr[0] & 0b1111111);
             ptr++;
+            if(ptr == end) {
+                debug.println("Invalid packet : timestamp without a message");
+                return;
+            }
         }
 
         if(ptr[0] & 0b10000000) {   // Full midi message
+            if(ptr[0] >= 0xF8) {    // Real-time: one byte, leaves running status alone
+                if(ptr[0] == 0xFC && stopCallback != nullptr)
+                    stopCallback();
+                ptr++;
+                continue;
+            }
             runningStatus = *ptr ;
             ptr++;
         }
@@ -162,6 +192,16 @@ void ProtocolMidi::midi_receivePacket(uint8_t *data, uint16_t size)
         uint8_t command = runningStatus >> 4;
         uint8_t channel = runningStatus & 0b1111;
 
+        // Channel messages need all their data bytes in this packet
+        if(command >= 0b1000 && command < 0b1111) {
+            uint8_t dataBytes = (command == 0b1100 || command == 0b1101) ? 1 : 2;
+            if(end - ptr < dataBytes || (ptr[0] & 0b10000000) ||
+               (dataBytes == 2 && (ptr[1] & 0b10000000))) {
+                debug.println("Invalid packet : truncated message");
+                return;
+            }
+        }
+
         switch(command) {
             case 0:
                 debug.println("Invalid packet : a running status message must be preceded by a full midi message");
@@ -240,12 +280,14 @@ void ProtocolMidi::midi_receivePacket(uint8_t *data, uint16_t size)
             }
 
             case 0b1111:
-
-                if(channel == 0xc) {
-                    if(stopCallback != nullptr)
-                        stopCallback();
-                }
-
+                // System common: skip the data bytes (for SysEx also the
+                // timestamp and F7 that end it)
+                while(ptr < end && !(ptr[0] & 0b10000000))
+                    ptr++;
+                if(channel == 0x0 && end - ptr >= 2 && ptr[1] == 0xF7)
+                    ptr += 2;
+                // System messages carry no running status
+                runningStatus = 0;
                 break;
 
             default:
@@ -318,6 +360,42 @@ void ProtocolMidi::mmcRewind(void)
 }
 
 
+void ProtocolMidi::clockTick(uint32_t eventMicros)
+{
+    uint8_t midiMessage[] = { 0xF8 };   // Timing clock, 24 per quarter note
+    sendTimedMessage(midiMessage, sizeof(midiMessage), eventMicros);
+}
+
+void ProtocolMidi::clockStart(uint32_t eventMicros)
+{
+    uint8_t midiMessage[] = { 0xFA };
+    sendTimedMessage(midiMessage, sizeof(midiMessage), eventMicros);
+}
+
+void ProtocolMidi::clockContinue(uint32_t eventMicros)
+{
+    uint8_t midiMessage[] = { 0xFB };
+    sendTimedMessage(midiMessage, sizeof(midiMessage), eventMicros);
+}
+
+void ProtocolMidi::clockStop(uint32_t eventMicros)
+{
+    uint8_t midiMessage[] = { 0xFC };
+    sendTimedMessage(midiMessage, sizeof(midiMessage), eventMicros);
+}
+
+void ProtocolMidi::songPosition(uint16_t position, uint32_t eventMicros)
+{
+    if(position > 16383)
+        return;
+    uint8_t midiMessage[] = {
+        0xF2,    // Song position pointer
+        (uint8_t)(position & 0x7F),
+        (uint8_t)(position >> 7)
+    };
+    sendTimedMessage(midiMessage, sizeof(midiMessage), eventMicros);
+}
+
 void ProtocolMidi::sendMMC(mmc_t command)
 {
     switch(command) 
@@ -355,18 +433,207 @@ void ProtocolMidi::sendMMC(mmc_t command)
 
 void ProtocolMidi::sendMessage(uint8_t *message, uint16_t messageSize)
 {
-    uint8_t packet[messageSize+2];
+    queueMessage(message, messageSize, millis() & 0x1FFF);
+}
+
+void ProtocolMidi::sendTimedMessage(const uint8_t *message, uint16_t messageSize, uint32_t eventMicros)
+{
+    // Widen to the 64 bit clock behind millis(), so both kinds of stamp agree
+    // after micros() wraps
+    int64_t now = esp_timer_get_time();
+    int32_t age = (int32_t)((uint32_t)now - eventMicros);
+    int64_t event = now - age;
+    int64_t stampMs = (event + 500) / 1000;
+
+    portENTER_CRITICAL(&txLock);
+    txStats.timedMessages++;
+    portEXIT_CRITICAL(&txLock);
+
+    queueMessage(message, messageSize, stampMs & 0x1FFF, event);
+}
+
+/*
+Packet layout (BLE-MIDI spec):
+    header (1, timestamp bits 12-7) | timestamp (1, bits 6-0) | message | timestamp | message ...
+A message with the same status as the previous channel message may drop its
+status byte (running status); its timestamp byte stays. A SysEx end (F7) gets
+its own timestamp byte. A packet only holds timestamps with the same high
+bits, in order, so a change of header starts a new packet.
+*/
+void ProtocolMidi::queueMessage(const uint8_t *message, uint16_t messageSize, uint16_t timestamp, int64_t event)
+{
+    uint8_t status = message[0];
+    bool channelMessage = status >= 0x80 && status < 0xF0;
+    bool sysex = status == 0xF0;
+    uint8_t header = 0x80 | ((timestamp >> 7) & 0x3F);
+    uint8_t timestampByte = 0x80 | (timestamp & 0x7F);
+
+    portENTER_CRITICAL(&txLock);
+    for(;;) {
+        bool runningStatus = txLength > 0 && channelMessage && status == txRunningStatus;
+        uint16_t needed = 1 + messageSize - (runningStatus ? 1 : 0) + (sysex ? 1 : 0);
+        bool sameHeader = txLength > 0 && txPacket[0] == header && timestamp >= txLastTimestamp;
+
+        if(txLength > 0 && (!sameHeader || txLength + needed > txMaxPacket)) {
+            // Send what we have before this message goes into a new packet
+            uint8_t taken[BLE_MIDI_MAX_PACKET];
+            int64_t queuedAt = txFirstQueued;
+            int64_t firstEvent = txFirstEvent;
+            uint16_t size = takePacket(taken);
+            portEXIT_CRITICAL(&txLock);
+            sendTaken(taken, size, queuedAt, firstEvent, sameHeader);
+            portENTER_CRITICAL(&txLock);
+            continue;
+        }
+        if(txLength == 0) {
+            if(1 + needed > txMaxPacket)
+                break; // Can't fit even alone
+            txPacket[txLength++] = header;
+            txFirstQueued = esp_timer_get_time();
+            txFirstEvent = 0;
+        }
+        if(txFirstEvent == 0)
+            txFirstEvent = event;
+
+        txPacket[txLength++] = timestampByte;
+        if(sysex) {
+            memcpy(&txPacket[txLength], message, messageSize - 1);
+            txLength += messageSize - 1;
+            txPacket[txLength++] = timestampByte;
+            txPacket[txLength++] = 0xF7;
+        } else {
+            uint16_t skip = runningStatus ? 1 : 0;
+            memcpy(&txPacket[txLength], message + skip, messageSize - skip);
+            txLength += messageSize - skip;
+        }
+        // Real-time messages (F8-FF) leave running status alone
+        if(channelMessage)
+            txRunningStatus = status;
+        else if(status < 0xF8)
+            txRunningStatus = 0;
+        txLastTimestamp = timestamp;
+        txStats.messages++;
+        break;
+    }
+    portEXIT_CRITICAL(&txLock);
+}
+
+// Called with txLock held
+uint16_t ProtocolMidi::takePacket(uint8_t *out)
+{
+    uint16_t size = txLength;
+    memcpy(out, txPacket, size);
+    txLength = 0;
+    txRunningStatus = 0;
+    return size;
+}
+
+void ProtocolMidi::sendTaken(uint8_t *packet, uint16_t packetSize, int64_t queuedAt, int64_t firstEvent, bool full)
+{
+    bool sent = sendPacket(packet, packetSize);
+    int64_t sentAt = esp_timer_get_time();
+    uint32_t latency = sentAt - queuedAt;
+    // Timestamps in a packet ascend, so the first timed message waited longest
+    uint32_t sendLag = firstEvent != 0 && sentAt > firstEvent ? sentAt - firstEvent : 0;
+
+    portENTER_CRITICAL(&txLock);
+    if(sent) {
+        txStats.packets++;
+        if(full)
+            txStats.fullFlushes++;
+        if(latency > txStats.maxLatencyUs)
+            txStats.maxLatencyUs = latency;
+        if(sendLag > txStats.maxSendLagUs)
+            txStats.maxSendLagUs = sendLag;
+    } else {
+        txStats.dropped++;
+    }
+    portEXIT_CRITICAL(&txLock);
+}
+
+void ProtocolMidi::flush()
+{
+    uint8_t taken[BLE_MIDI_MAX_PACKET];
+    uint16_t takenSize = 0;
+    int64_t takenQueuedAt = 0;
+    int64_t takenFirstEvent = 0;
 
-    auto t = millis();
-    uint8_t headerByte = (1 << 7) | ((t >> 7) & ((1 << 6) - 1));
-    uint8_t timestampByte = (1 << 7) | (t & ((1 << 7) - 1));
+    portENTER_CRITICAL(&txLock);
+    if(txLength > 0) {
+        takenQueuedAt = txFirstQueued;
+        takenFirstEvent = txFirstEvent;
+        takenSize = takePacket(taken);
+    }
+    portEXIT_CRITICAL(&txLock);
 
-    packet[0] = headerByte;
-    packet[1] = timestampByte;
-    for(int i = 0; i < messageSize; i++)
-        packet[i+2] = message[i];
-    sendPacket(packet, messageSize + 2); 
+    if(takenSize > 0)
+        sendTaken(taken, takenSize, takenQueuedAt, takenFirstEvent, false);
+}
 
+void ProtocolMidi::flushTimerCallback(void *arg)
+{
+    ((ProtocolMidi*)arg)->flush();
+}
+
+void ProtocolMidi::setMaxPacketSize(uint16_t size)
+{
+    if(size > BLE_MIDI_MAX_PACKET)
+        size = BLE_MIDI_MAX_PACKET;
+    if(size < BLE_MIDI_DEFAULT_PACKET)
+        size = BLE_MIDI_DEFAULT_PACKET;
+    // Shrinking: send the pending packet while it still fits
+    if(size < txMaxPacket)
+        flush();
+    portENTER_CRITICAL(&txLock);
+    txMaxPacket = size;
+    portEXIT_CRITICAL(&txLock);
+}
+
+void ProtocolMidi::setFlushInterval(uint32_t intervalUs)
+{
+    if(flushTimer == nullptr) {
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = flushTimerCallback;
+        timerArgs.arg = this;
+        timerArgs.name = "midi_flush";
+        if(esp_timer_create(&timerArgs, &flushTimer) != ESP_OK) {
+            debug.println("Failed to create MIDI flush timer");
+            return;
+        }
+    } else {
+        esp_timer_stop(flushTimer);
+    }
+    esp_timer_start_periodic(flushTimer, intervalUs);
+}
+
+ProtocolMidi::TxStats ProtocolMidi::getTxStats()
+{
+    portENTER_CRITICAL(&txLock);
+    TxStats stats = txStats;
+    portEXIT_CRITICAL(&txLock);
+    return stats;
+}
+
+void ProtocolMidi::resetTxStats()
+{
+    portENTER_CRITICAL(&txLock);
+    txStats = TxStats();
+    portEXIT_CRITICAL(&txLock);
+}
+
+ProtocolMidi::RxStats ProtocolMidi::getRxStats()
+{
+    portENTER_CRITICAL(&txLock);
+    RxStats stats = rxStats;
+    portEXIT_CRITICAL(&txLock);
+    return stats;
+}
+
+void ProtocolMidi::resetRxStats()
+{
+    portENTER_CRITICAL(&txLock);
+    rxStats = RxStats();
+    portEXIT_CRITICAL(&txLock);
 }
 
 // ###################################
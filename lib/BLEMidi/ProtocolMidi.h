@@ -2,8 +2,13 @@
 #define PROTOCOLMIDI_H
 
 #include <Arduino.h>
+#include <esp_timer.h>
 #include "Debug.h"
 
+// BLE-MIDI packet limits: ATT MTU minus the 3 byte notification header
+#define BLE_MIDI_DEFAULT_PACKET 20      // Default MTU (23)
+#define BLE_MIDI_MAX_PACKET 244         // Largest MTU we accept (247)
+#define BLE_MIDI_FLUSH_INTERVAL_US 7500 // Until the connection interval is known
 
 class ProtocolMidi {
 public:
@@ -39,6 +44,21 @@ public:
     void mmcReset(void);
     void mmcFastForward(void);
     void mmcRewind(void);
+
+    /**
+     * MIDI clock and transport (system real-time).
+     * @param eventMicros micros() at which the event happened (e.g. the tick's
+     * scheduled time); the BLE-MIDI timestamp is taken from it rather than
+     * from the send time, so the receiver can undo the radio's jitter.
+     * */
+    void clockTick(uint32_t eventMicros);
+    void clockStart(uint32_t eventMicros);
+    void clockContinue(uint32_t eventMicros);
+    void clockStop(uint32_t eventMicros);
+    /**
+     * @param position Song position in sixteenth notes (0 to 16383)
+     * */
+    void songPosition(uint16_t position, uint32_t eventMicros);
     
 
     void setNoteOnCallback(void (*callback)(uint8_t channel, uint8_t note, uint8_t velocity, uint16_t timestamp));
@@ -54,9 +74,49 @@ public:
     void enableDebugging(Stream& debugStream = Serial);
     void disableDebugging();
 
+    /**
+     * Outgoing messages are collected into one BLE-MIDI packet (one header,
+     * a timestamp per message, running status) and sent when the flush
+     * timer fires or the packet is full.
+     * */
+    void flush();
+    /**
+     * @param size Largest packet the peer accepts (negotiated MTU - 3)
+     * */
+    void setMaxPacketSize(uint16_t size);
+    /**
+     * Starts or retunes the periodic flush; one flush per connection interval
+     * puts at most one notification in each connection event.
+     * */
+    void setFlushInterval(uint32_t intervalUs);
+
+    struct TxStats {
+        uint32_t messages = 0;      // Messages queued
+        uint32_t packets = 0;       // Notifications sent
+        uint32_t fullFlushes = 0;   // Packets sent early because the next message didn't fit
+        uint32_t dropped = 0;       // Packets not sent (not connected)
+        uint32_t maxLatencyUs = 0;  // Longest wait from queueing a message to its packet's send
+        uint32_t timedMessages = 0; // Clock/transport messages stamped with their event time
+                                    // (rounded to the 1 ms stamp resolution)
+        uint32_t maxSendLagUs = 0;  // Largest event time to notification sent, for packets
+                                    // holding a timed message: the error a send-time stamp
+                                    // would have had
+    };
+    TxStats getTxStats();
+    void resetTxStats();
+
+    struct RxStats {
+        uint32_t packets = 0;       // Packets written by the central
+        uint32_t bytes = 0;
+        uint32_t maxParseUs = 0;    // Longest time to parse a packet and run its callbacks
+        uint64_t totalParseUs = 0;
+    };
+    RxStats getRxStats();
+    void resetRxStats();
+
 protected:
     virtual bool sendPacket(uint8_t *packet, uint16_t packetSize) = 0;
-    void midi_receivePacket(uint8_t *packet, uint16_t packetSize);
+    void midi_receivePacket(const uint8_t *packet, uint16_t packetSize);
     Debug debug;
 
 private:
@@ -76,7 +136,13 @@ private:
         //TODO: Write, Goto, Shuttle
     };
     void sendMessage(uint8_t *message, uint16_t messageSize);
+    void queueMessage(const uint8_t *message, uint16_t messageSize, uint16_t timestamp, int64_t event = 0);
+    void sendTimedMessage(const uint8_t *message, uint16_t messageSize, uint32_t eventMicros);
+    uint16_t takePacket(uint8_t *out);
+    void sendTaken(uint8_t *packet, uint16_t packetSize, int64_t queuedAt, int64_t firstEvent, bool full);
     void sendMMC(mmc_t command);
+    void parsePacket(const uint8_t *data, uint16_t size);
+    static void flushTimerCallback(void *arg);
     void (*noteOnCallback)(uint8_t, uint8_t, uint8_t, uint16_t) = nullptr;
     void (*noteOffCallback)(uint8_t, uint8_t, uint8_t, uint16_t) = nullptr;
     void (*afterTouchPolyCallback)(uint8_t, uint8_t, uint8_t, uint16_t) = nullptr;
@@ -88,7 +154,20 @@ private:
     void (*stopCallback)(void) = nullptr;
 
     uint16_t currentTimestamp = 0;
-    
+
+    // Pending outgoing packet, shared with the flush timer
+    portMUX_TYPE txLock = portMUX_INITIALIZER_UNLOCKED;
+    uint8_t txPacket[BLE_MIDI_MAX_PACKET];
+    uint16_t txLength = 0;
+    uint16_t txMaxPacket = BLE_MIDI_DEFAULT_PACKET;
+    uint8_t txRunningStatus = 0;
+    uint16_t txLastTimestamp = 0;
+    int64_t txFirstQueued = 0;
+    int64_t txFirstEvent = 0;   // Event time of the first timed message, 0 if none
+    TxStats txStats;
+    RxStats rxStats;            // Also under txLock; updated from the BLE host task
+    esp_timer_handle_t flushTimer = nullptr;
+
 };
 
 #endif
@@ -39,6 +39,20 @@ NimBLEAdvertisedDevice::NimBLEAdvertisedDevice() :
 } // NimBLEAdvertisedDevice
 
 
+/**
+ * @brief Clear the device so the scan can reuse it for another advertiser.
+ * @details The payload keeps its capacity.
+ */
+void NimBLEAdvertisedDevice::reset() {
+    m_advType          = 0;
+    m_rssi             = -9999;
+    m_callbackSent     = false;
+    m_timestamp        = 0;
+    m_advLength        = 0;
+    m_payload.clear();
+} // reset
+
+
 /**
  * @brief Get the address of the advertising device.
  * @return The address of the advertised device.
@@ -149,6 +149,7 @@ private:
     void    setAdvType(uint8_t advType, bool isLegacyAdv);
     void    setPayload(const uint8_t *payload, uint8_t length, bool append);
     void    setRSSI(int rssi);
+    void    reset();
 #if CONFIG_BT_NIMBLE_EXT_ADV
     void    setSetId(uint8_t sid)              { m_sid = sid; }
     void    setPrimaryPhy(uint8_t phy)         { m_primPhy = phy; }
@@ -190,6 +191,10 @@ public:
      *
      * As we are scanning, we will find new devices.  When found, this call back is invoked with a reference to the
      * device that was found.  During any individual scan, a device will only be detected one time.
+     *
+     * The device belongs to the scan's pool: with setMaxResults(0) it is released as soon as this returns,
+     * and otherwise it may be reused for another advertiser once CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS devices
+     * are stored. Copy it, rather than the pointer, to keep it.
      */
     virtual void onResult(NimBLEAdvertisedDevice* advertisedDevice) = 0;
 };
@@ -67,6 +67,7 @@ void NimBLEAdvertising::reset() {
     m_advParams.disc_mode            = BLE_GAP_DISC_MODE_GEN;
     m_customAdvData                  = false;
     m_customScanResponseData         = false;
+    m_customScanResponse.clear();
     m_scanResp                       = true;
     m_advDataSet                     = false;
     // Set this to non-zero to prevent auto start if host reset before started by app.
@@ -367,19 +368,23 @@ void NimBLEAdvertising::setAdvertisementData(NimBLEAdvertisementData& advertisem
  * @brief Set the advertisement data that is to be published in a scan response.
  * @param [in] advertisementData The data to be advertised.
  * @details Calling this without also using setAdvertisementData will have no effect.\n
- * When using custom scan response data you must also use custom advertisement data.
+ * When using custom scan response data you must also use custom advertisement data.\n
+ * The data is kept and set again whenever advertising is (re)started.
+ * @return True if the controller accepted the data.
  */
-void NimBLEAdvertising::setScanResponseData(NimBLEAdvertisementData& advertisementData) {
+bool NimBLEAdvertising::setScanResponseData(NimBLEAdvertisementData& advertisementData) {
     NIMBLE_LOGD(LOG_TAG, ">> setScanResponseData");
+    m_customScanResponse = advertisementData.getPayload();
     int rc = ble_gap_adv_rsp_set_data(
-        (uint8_t*)advertisementData.getPayload().data(),
-        advertisementData.getPayload().length());
+        (uint8_t*)m_customScanResponse.data(),
+        m_customScanResponse.length());
     if (rc != 0) {
         NIMBLE_LOGE(LOG_TAG, "ble_gap_adv_rsp_set_data: %d %s",
                     rc,  NimBLEUtils::returnCodeToString(rc));
     }
     m_customScanResponseData = true;   // Set the flag that indicates we are using custom scan response data.
     NIMBLE_LOGD(LOG_TAG, "<< setScanResponseData");
+    return rc == 0;
 } // setScanResponseData
 
 
@@ -623,6 +628,17 @@ bool NimBLEAdvertising::start(uint32_t duration, void (*advCompleteCB)(NimBLEAdv
         m_advDataSet = true;
     }
 
+    // The controller may have lost it in a host reset; set what was last given
+    if(m_scanResp && m_customScanResponseData) {
+        rc = ble_gap_adv_rsp_set_data((uint8_t*)m_customScanResponse.data(),
+                                      m_customScanResponse.length());
+        if(rc != 0) {
+            NIMBLE_LOGE(LOG_TAG, "Error setting scan response data; rc=%d, %s",
+                        rc, NimBLEUtils::returnCodeToString(rc));
+            return false;
+        }
+    }
+
 #if defined(CONFIG_BT_NIMBLE_ROLE_PERIPHERAL)
     rc = ble_gap_adv_start(NimBLEDevice::m_own_addr_type, NULL, duration,
                            &m_advParams,
@@ -102,7 +102,7 @@ public:
     void setMinInterval(uint16_t mininterval);
     void setAdvertisementData(NimBLEAdvertisementData& advertisementData);
     void setScanFilter(bool scanRequestWhitelistOnly, bool connectWhitelistOnly);
-    void setScanResponseData(NimBLEAdvertisementData& advertisementData);
+    bool setScanResponseData(NimBLEAdvertisementData& advertisementData);
     void setScanResponse(bool);
     void setMinPreferred(uint16_t);
     void setMaxPreferred(uint16_t);
@@ -124,6 +124,7 @@ private:
     std::vector<NimBLEUUID> m_serviceUUIDs;
     bool                    m_customAdvData;
     bool                    m_customScanResponseData;
+    std::string             m_customScanResponse;
     bool                    m_scanResp;
     bool                    m_advDataSet;
     void                    (*m_advCompCB)(NimBLEAdvertising *pAdv);
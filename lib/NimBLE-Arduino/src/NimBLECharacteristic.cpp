@@ -297,12 +297,18 @@ int NimBLECharacteristic::handleGapEvent(uint16_t conn_handle, uint16_t attr_han
                     return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
                 }
 
+                // A write that fits one mbuf is used in place; only chained
+                // mbufs (long writes) are flattened into the stack buffer.
                 uint8_t buf[att_max_len];
+                const uint8_t *data = ctxt->om->om_data;
                 size_t len = ctxt->om->om_len;
-                memcpy(buf, ctxt->om->om_data,len);
 
                 os_mbuf *next;
                 next = SLIST_NEXT(ctxt->om, om_next);
+                if(next != NULL) {
+                    memcpy(buf, ctxt->om->om_data, len);
+                    data = buf;
+                }
                 while(next != NULL){
                     if((len + next->om_len) > att_max_len) {
                         return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
@@ -313,7 +319,10 @@ int NimBLECharacteristic::handleGapEvent(uint16_t conn_handle, uint16_t attr_han
                 }
                 rc = ble_gap_conn_find(conn_handle, &desc);
                 assert(rc == 0);
-                pCharacteristic->setValue(buf, len);
+                if(pCharacteristic->m_pCallbacks->onWriteData(pCharacteristic, data, len, &desc)) {
+                    return 0;
+                }
+                pCharacteristic->setValue(data, len);
                 pCharacteristic->m_pCallbacks->onWrite(pCharacteristic);
                 pCharacteristic->m_pCallbacks->onWrite(pCharacteristic, &desc);
                 return 0;
@@ -516,6 +525,138 @@ void NimBLECharacteristic::notify(const uint8_t* value, size_t length, bool is_n
 } // Notify
 
 
+/**
+ * @brief Send a notification or indication from an mbuf chain.
+ * @param[in] om The value to send, e.g. from ble_hs_mbuf_from_flat() or written into
+ * ble_hs_mbuf_att_pkt(). It is always consumed.
+ * @param[in] is_notification if true sends a notification, false sends an indication.
+ * @details For values the caller builds in an mbuf itself. The host consumes every
+ * chain it is given, so the last subscriber gets om and the others a copy: with one
+ * subscriber nothing is copied, with several it costs about what notify(value, length)
+ * does (test/host/nimble_notify_bench.c).
+ */
+void NimBLECharacteristic::notify(os_mbuf* om, bool is_notification) {
+    uint16_t length = OS_MBUF_PKTLEN(om);
+    NIMBLE_LOGD(LOG_TAG, ">> notify: length: %d", length);
+
+    if(!(m_properties & NIMBLE_PROPERTY::NOTIFY) &&
+       !(m_properties & NIMBLE_PROPERTY::INDICATE))
+    {
+        NIMBLE_LOGE(LOG_TAG,
+                    "<< notify-Error; Notify/indicate not enabled for characteristic: %s",
+                    std::string(getUUID()).c_str());
+    }
+
+    if (m_subscribedVec.size() == 0) {
+        NIMBLE_LOGD(LOG_TAG, "<< notify: No clients subscribed.");
+        os_mbuf_free_chain(om);
+        return;
+    }
+
+    m_pCallbacks->onNotify(this);
+
+    bool reqSec = (m_properties & BLE_GATT_CHR_F_READ_AUTHEN) ||
+                  (m_properties & BLE_GATT_CHR_F_READ_AUTHOR) ||
+                  (m_properties & BLE_GATT_CHR_F_READ_ENC);
+    int rc = 0;
+
+    // Each subscriber is sent to once the next one is found, so that the
+    // last one can take om without a copy.
+    uint16_t pendingHandle = BLE_HS_CONN_HANDLE_NONE;
+    bool pendingNotify = true;
+
+    for (auto &it : m_subscribedVec) {
+        uint16_t _mtu = getService()->getServer()->getPeerMTU(it.first) - 3;
+
+        // check if connected and subscribed
+        if(_mtu == 0 || it.second == 0) {
+            continue;
+        }
+
+        // check if security requirements are satisfied
+        if(reqSec) {
+            struct ble_gap_conn_desc desc;
+            rc = ble_gap_conn_find(it.first, &desc);
+            if(rc != 0 || !desc.sec_state.encrypted) {
+                continue;
+            }
+        }
+
+        if (length > _mtu) {
+            NIMBLE_LOGW(LOG_TAG, "- Truncating to %d bytes (maximum notify size)", _mtu);
+        }
+
+        bool notifyThis = is_notification;
+        if(notifyThis && (!(it.second & NIMBLE_SUB_NOTIFY))) {
+            NIMBLE_LOGW(LOG_TAG,
+            "Sending notification to client subscribed to indications, sending indication instead");
+            notifyThis = false;
+        }
+
+        if(!notifyThis && (!(it.second & NIMBLE_SUB_INDICATE))) {
+            NIMBLE_LOGW(LOG_TAG,
+            "Sending indication to client subscribed to notification, sending notification instead");
+            notifyThis = true;
+        }
+
+        if (pendingHandle != BLE_HS_CONN_HANDLE_NONE) {
+            // Not os_mbuf_dup(): its copy loses the leading space reserved
+            // for the ATT and L2CAP headers.
+            os_mbuf *copy = ble_hs_mbuf_att_pkt();
+            if (copy != nullptr && os_mbuf_appendfrom(copy, om, 0, length) != 0) {
+                os_mbuf_free_chain(copy);
+                copy = nullptr;
+            }
+
+            if (copy == nullptr) {
+                NIMBLE_LOGE(LOG_TAG, "- No mbufs to copy the value for conn %d", pendingHandle);
+            } else if (!sendValue(pendingHandle, copy, pendingNotify)) {
+                os_mbuf_free_chain(om);
+                return;
+            }
+        }
+
+        pendingHandle = it.first;
+        pendingNotify = notifyThis;
+    }
+
+    if (pendingHandle != BLE_HS_CONN_HANDLE_NONE) {
+        sendValue(pendingHandle, om, pendingNotify);
+    } else {
+        os_mbuf_free_chain(om);
+    }
+
+    NIMBLE_LOGD(LOG_TAG, "<< notify");
+} // Notify
+
+
+/**
+ * @brief Hand the value to the host for one subscriber.
+ * @param[in] conn_handle The subscriber's connection.
+ * @param[in] om The value; consumed.
+ * @param[in] is_notification if true sends a notification, false sends an indication.
+ * @return False if a prior indication to this subscriber is still in progress.
+ */
+bool NimBLECharacteristic::sendValue(uint16_t conn_handle, os_mbuf* om, bool is_notification) {
+    if(!is_notification && (m_properties & NIMBLE_PROPERTY::INDICATE)) {
+        if(!NimBLEDevice::getServer()->setIndicateWait(conn_handle)) {
+            NIMBLE_LOGE(LOG_TAG, "prior Indication in progress");
+            os_mbuf_free_chain(om);
+            return false;
+        }
+
+        if(ble_gattc_indicate_custom(conn_handle, m_handle, om) != 0) {
+            NIMBLE_LOGE(LOG_TAG, "- Indication failed for conn %d", conn_handle);
+            NimBLEDevice::getServer()->clearIndicateWait(conn_handle);
+        }
+    } else {
+        ble_gattc_notify_custom(conn_handle, m_handle, om);
+    }
+
+    return true;
+} // sendValue
+
+
 /**
  * @brief Set the callback handlers for this characteristic.
  * @param [in] pCallbacks An instance of a NimBLECharacteristicCallbacks class\n
@@ -621,6 +762,21 @@ void NimBLECharacteristicCallbacks::onWrite(NimBLECharacteristic* pCharacteristi
     NIMBLE_LOGD("NimBLECharacteristicCallbacks", "onWrite: default");
 } // onWrite
 
+/**
+ * @brief Callback function to handle written data before it is stored.\n
+ * The data points into the received mbuf (or a stack buffer for long writes)
+ * and is only valid during the call.
+ * @param [in] pCharacteristic The characteristic that is the source of the event.
+ * @param [in] data The written bytes.
+ * @param [in] length The number of bytes written.
+ * @param [in] desc The connection description struct that is associated with the peer that performed the write.
+ * @return True if the data was consumed; the value is then not stored and onWrite() is not called.
+ */
+bool NimBLECharacteristicCallbacks::onWriteData(NimBLECharacteristic* pCharacteristic, const uint8_t* data,
+                                                size_t length, ble_gap_conn_desc* desc) {
+    return false;
+} // onWriteData
+
 /**
  * @brief Callback function to support a Notify request.
  * @param [in] pCharacteristic The characteristic that is the source of the event.
@@ -86,6 +86,7 @@ public:
     void              notify(bool is_notification = true);
     void              notify(const uint8_t* value, size_t length, bool is_notification = true);
     void              notify(const std::vector<uint8_t>& value, bool is_notification = true);
+    void              notify(os_mbuf* om, bool is_notification = true);
     size_t            getSubscribedCount();
     void              addDescriptor(NimBLEDescriptor *pDescriptor);
     NimBLEDescriptor* getDescriptorByUUID(const char* uuid);
@@ -175,6 +176,7 @@ private:
 
     void            setService(NimBLEService *pService);
     void            setSubscribe(struct ble_gap_event *event);
+    bool            sendValue(uint16_t conn_handle, os_mbuf* om, bool is_notification);
     static int      handleGapEvent(uint16_t conn_handle, uint16_t attr_handle,
                                    struct ble_gatt_access_ctxt *ctxt, void *arg);
 
@@ -222,6 +224,8 @@ public:
     virtual void onRead(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc);
     virtual void onWrite(NimBLECharacteristic* pCharacteristic);
     virtual void onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc);
+    virtual bool onWriteData(NimBLECharacteristic* pCharacteristic, const uint8_t* data, size_t length,
+                             ble_gap_conn_desc* desc);
     virtual void onNotify(NimBLECharacteristic* pCharacteristic);
     virtual void onStatus(NimBLECharacteristic* pCharacteristic, Status s, int code);
     virtual void onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc, uint16_t subValue);
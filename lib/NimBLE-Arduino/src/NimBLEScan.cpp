@@ -21,9 +21,24 @@
 
 #include <string>
 #include <climits>
+#include <cstring>
 
 static const char* LOG_TAG = "NimBLEScan";
 
+#define NIMBLE_SCAN_INDEX_MASK (NIMBLE_SCAN_INDEX_SIZE - 1)
+
+
+/**
+ * @brief Home slot of an address in the device index.
+ */
+static uint16_t scanIndexHash(const NimBLEAddress &address) {
+    const uint8_t *addr = address.getNative();
+    uint32_t key = ((uint32_t)addr[0] | (uint32_t)addr[1] << 8 |
+                    (uint32_t)addr[2] << 16 | (uint32_t)addr[3] << 24) ^
+                   ((uint32_t)addr[4] << 5 | (uint32_t)addr[5] << 13);
+    return (key * 0x9E3779B1u) >> (32 - NIMBLE_SCAN_INDEX_BITS);
+}
+
 
 /**
  * @brief Scan constuctor.
@@ -40,6 +55,8 @@ NimBLEScan::NimBLEScan() {
     m_pTaskData                      = nullptr;
     m_duration                       = BLE_HS_FOREVER; // make sure this is non-zero in the event of a host reset
     m_maxResults                     = 0xFF;
+    m_scanResults.m_advertisedDevicesVector.reserve(CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS);
+    resetDevices();
 }
 
 
@@ -84,22 +101,15 @@ NimBLEScan::~NimBLEScan() {
                 return 0;
             }
 
-            NimBLEAdvertisedDevice* advertisedDevice = nullptr;
-
-            // If we've seen this device before get a pointer to it from the vector
-            for(auto &it: pScan->m_scanResults.m_advertisedDevicesVector) {
+            // If we've seen this device before get a pointer to it from the index.
 #if CONFIG_BT_NIMBLE_EXT_ADV
-                // Same address but different set ID should create a new advertised device.
-                if (it->getAddress() == advertisedAddress && it->getSetId() == disc.sid) {
+            // Same address but different set ID should create a new advertised device.
+            NimBLEAdvertisedDevice* advertisedDevice = pScan->findDevice(advertisedAddress, disc.sid);
 #else
-                if (it->getAddress() == advertisedAddress) {
+            NimBLEAdvertisedDevice* advertisedDevice = pScan->findDevice(advertisedAddress, -1);
 #endif
-                    advertisedDevice = it;
-                    break;
-                }
-            }
 
-            // If we haven't seen this device before; create a new instance and insert it in the vector.
+            // If we haven't seen this device before; take one from the pool, which adds it to the results.
             // Otherwise just update the relevant parameters of the already known device.
             if (advertisedDevice == nullptr &&
                 (!isLegacyAdv || event_type != BLE_HCI_ADV_RPT_EVTYPE_SCAN_RSP)) {
@@ -110,8 +120,17 @@ NimBLEScan::~NimBLEScan() {
                     return 0;
                 }
 
-                advertisedDevice = new NimBLEAdvertisedDevice();
-                advertisedDevice->setAddress(advertisedAddress);
+                // Reported before it was dropped from a full pool; looked up first, so the
+                // device dropped for this one can take its place in the seen filter
+#if CONFIG_BT_NIMBLE_EXT_ADV
+                const bool seen = pScan->m_scan_params.filter_duplicates &&
+                                  pScan->takeSeen(advertisedAddress, disc.sid);
+#else
+                const bool seen = pScan->m_scan_params.filter_duplicates &&
+                                  pScan->takeSeen(advertisedAddress, 0);
+#endif
+
+                advertisedDevice = pScan->allocDevice(advertisedAddress);
                 advertisedDevice->setAdvType(event_type, isLegacyAdv);
 #if CONFIG_BT_NIMBLE_EXT_ADV
                 advertisedDevice->setSetId(disc.sid);
@@ -119,9 +138,10 @@ NimBLEScan::~NimBLEScan() {
                 advertisedDevice->setSecondaryPhy(disc.sec_phy);
                 advertisedDevice->setPeriodicInterval(disc.periodic_adv_itvl);
 #endif
-                pScan->m_scanResults.m_advertisedDevicesVector.push_back(advertisedDevice);
+                advertisedDevice->m_callbackSent = seen;
                 NIMBLE_LOGI(LOG_TAG, "New advertiser: %s", advertisedAddress.toString().c_str());
             } else if (advertisedDevice != nullptr) {
+                pScan->touchDevice(advertisedDevice);
                 NIMBLE_LOGI(LOG_TAG, "Updated advertiser: %s", advertisedAddress.toString().c_str());
             } else {
                 // Scan response from unknown device
@@ -154,7 +174,7 @@ NimBLEScan::~NimBLEScan() {
                 }
                 // If not storing results and we have invoked the callback, delete the device.
                 if(pScan->m_maxResults == 0 && advertisedDevice->m_callbackSent) {
-                    pScan->erase(advertisedAddress);
+                    pScan->releaseDevice(advertisedDevice);
                 }
             }
 
@@ -255,6 +275,9 @@ void NimBLEScan::setFilterPolicy(uint8_t filter) {
  * @brief Sets the max number of results to store.
  * @param [in] maxResults The number of results to limit storage to\n
  * 0 == none (callbacks only) 0xFF == unlimited, any other value is the limit.
+ * @details No more than CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS are ever stored; past that
+ * a new advertiser replaces the one heard from least recently, and pointers to that
+ * device then refer to the new one.
  */
 void NimBLEScan::setMaxResults(uint8_t maxResults) {
     m_maxResults = maxResults;
@@ -466,13 +489,237 @@ void NimBLEScan::clearDuplicateCache() {
 void NimBLEScan::erase(const NimBLEAddress &address) {
     NIMBLE_LOGD(LOG_TAG, "erase device: %s", address.toString().c_str());
 
-    for(auto it = m_scanResults.m_advertisedDevicesVector.begin(); it != m_scanResults.m_advertisedDevicesVector.end(); ++it) {
-        if((*it)->getAddress() == address) {
-            delete *it;
-            m_scanResults.m_advertisedDevicesVector.erase(it);
-            break;
+    NimBLEAdvertisedDevice* pDevice = findDevice(address, -1);
+    if(pDevice != nullptr) {
+        releaseDevice(pDevice);
+    }
+}
+
+
+/**
+ * @brief Return every pooled device to the free list and empty the index and results.
+ */
+void NimBLEScan::resetDevices() {
+    m_scanResults.m_advertisedDevicesVector.clear();
+    memset(m_deviceIndex, NIMBLE_SCAN_NO_DEVICE, sizeof(m_deviceIndex));
+    for(uint8_t i = 0; i < CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS; i++) {
+        m_lruNext[i] = (i + 1 < CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS) ? i + 1 : NIMBLE_SCAN_NO_DEVICE;
+    }
+    m_freeHead = 0;
+    m_lruHead = NIMBLE_SCAN_NO_DEVICE;
+    m_lruTail = NIMBLE_SCAN_NO_DEVICE;
+    memset(m_seen, 0, sizeof(m_seen));
+    m_seenCount = 0;
+}
+
+
+/**
+ * @brief Find a stored device by address.
+ * @param [in] address The advertiser's address.
+ * @param [in] sid The advertising set ID to match, or -1 for any.
+ * @return The device or nullptr if it is not stored.
+ */
+NimBLEAdvertisedDevice* NimBLEScan::findDevice(const NimBLEAddress &address, int sid) {
+    for(uint16_t i = scanIndexHash(address); ; i = (i + 1) & NIMBLE_SCAN_INDEX_MASK) {
+        uint8_t slot = m_deviceIndex[i];
+        if(slot == NIMBLE_SCAN_NO_DEVICE) {
+            return nullptr;
+        }
+
+        NimBLEAdvertisedDevice* pDevice = &m_devices[slot];
+#if CONFIG_BT_NIMBLE_EXT_ADV
+        if(pDevice->m_address == address && (sid < 0 || pDevice->m_sid == sid)) {
+#else
+        (void)sid;
+        if(pDevice->m_address == address) {
+#endif
+            return pDevice;
+        }
+    }
+}
+
+
+/**
+ * @brief Take a device from the pool for a new advertiser and add it to the results.
+ * @param [in] address The advertiser's address.
+ * @return The cleared device; when the pool is empty, the one heard from least recently.
+ */
+NimBLEAdvertisedDevice* NimBLEScan::allocDevice(const NimBLEAddress &address) {
+    if(m_freeHead == NIMBLE_SCAN_NO_DEVICE) {
+        NimBLEAdvertisedDevice* pOldest = &m_devices[m_lruTail];
+        NIMBLE_LOGD(LOG_TAG, "Scan results full, dropping %s",
+                    pOldest->m_address.toString().c_str());
+        if(m_scan_params.filter_duplicates && pOldest->m_callbackSent) {
+            markSeen(pOldest);
         }
+        releaseDevice(pOldest);
+    }
+
+    uint8_t slot = m_freeHead;
+    m_freeHead = m_lruNext[slot];
+
+    NimBLEAdvertisedDevice* pDevice = &m_devices[slot];
+    pDevice->reset();
+    pDevice->setAddress(address);
+
+    uint16_t i = scanIndexHash(address);
+    while(m_deviceIndex[i] != NIMBLE_SCAN_NO_DEVICE) {
+        i = (i + 1) & NIMBLE_SCAN_INDEX_MASK;
     }
+    m_deviceIndex[i] = slot;
+
+    m_lruPrev[slot] = NIMBLE_SCAN_NO_DEVICE;
+    m_lruNext[slot] = m_lruHead;
+    if(m_lruHead != NIMBLE_SCAN_NO_DEVICE) {
+        m_lruPrev[m_lruHead] = slot;
+    } else {
+        m_lruTail = slot;
+    }
+    m_lruHead = slot;
+
+    m_resultPos[slot] = m_scanResults.m_advertisedDevicesVector.size();
+    m_scanResults.m_advertisedDevicesVector.push_back(pDevice);
+    return pDevice;
+}
+
+
+/**
+ * @brief Remove a device from the results and return it to the pool.
+ * @details The last result takes its place in the results vector.
+ */
+void NimBLEScan::releaseDevice(NimBLEAdvertisedDevice* pDevice) {
+    uint8_t slot = pDevice - m_devices;
+
+    // Backward-shift deletion keeps every probe sequence unbroken
+    uint16_t hole = scanIndexHash(pDevice->m_address);
+    while(m_deviceIndex[hole] != slot) {
+        hole = (hole + 1) & NIMBLE_SCAN_INDEX_MASK;
+    }
+    for(uint16_t i = (hole + 1) & NIMBLE_SCAN_INDEX_MASK;
+        m_deviceIndex[i] != NIMBLE_SCAN_NO_DEVICE;
+        i = (i + 1) & NIMBLE_SCAN_INDEX_MASK) {
+        uint16_t home = scanIndexHash(m_devices[m_deviceIndex[i]].m_address);
+        if(((i - home) & NIMBLE_SCAN_INDEX_MASK) >= ((i - hole) & NIMBLE_SCAN_INDEX_MASK)) {
+            m_deviceIndex[hole] = m_deviceIndex[i];
+            hole = i;
+        }
+    }
+    m_deviceIndex[hole] = NIMBLE_SCAN_NO_DEVICE;
+
+    if(m_lruPrev[slot] != NIMBLE_SCAN_NO_DEVICE) {
+        m_lruNext[m_lruPrev[slot]] = m_lruNext[slot];
+    } else {
+        m_lruHead = m_lruNext[slot];
+    }
+    if(m_lruNext[slot] != NIMBLE_SCAN_NO_DEVICE) {
+        m_lruPrev[m_lruNext[slot]] = m_lruPrev[slot];
+    } else {
+        m_lruTail = m_lruPrev[slot];
+    }
+
+    std::vector<NimBLEAdvertisedDevice*> &results = m_scanResults.m_advertisedDevicesVector;
+    NimBLEAdvertisedDevice* pLast = results.back();
+    results[m_resultPos[slot]] = pLast;
+    m_resultPos[pLast - m_devices] = m_resultPos[slot];
+    results.pop_back();
+
+    m_lruNext[slot] = m_freeHead;
+    m_freeHead = slot;
+}
+
+
+/**
+ * @brief Mark a stored device as the most recently heard.
+ */
+void NimBLEScan::touchDevice(NimBLEAdvertisedDevice* pDevice) {
+    uint8_t slot = pDevice - m_devices;
+    if(slot == m_lruHead) {
+        return;
+    }
+
+    m_lruNext[m_lruPrev[slot]] = m_lruNext[slot];
+    if(m_lruNext[slot] != NIMBLE_SCAN_NO_DEVICE) {
+        m_lruPrev[m_lruNext[slot]] = m_lruPrev[slot];
+    } else {
+        m_lruTail = m_lruPrev[slot];
+    }
+
+    m_lruPrev[slot] = NIMBLE_SCAN_NO_DEVICE;
+    m_lruNext[slot] = m_lruHead;
+    m_lruPrev[m_lruHead] = slot;
+    m_lruHead = slot;
+}
+
+
+/**
+ * @brief Hash of an address, its type and the set ID for the seen filter; never 0.
+ */
+static uint32_t scanSeenHash(const NimBLEAddress &address, uint8_t sid) {
+    const uint8_t *addr = address.getNative();
+    uint32_t key = ((uint32_t)addr[0] | (uint32_t)addr[1] << 8 |
+                    (uint32_t)addr[2] << 16 | (uint32_t)addr[3] << 24);
+    key ^= ((uint32_t)addr[4] | (uint32_t)addr[5] << 8 |
+            (uint32_t)address.getType() << 16 | (uint32_t)sid << 24) * 0x85EBCA6Bu;
+    key ^= key >> 15;
+    key *= 0x2C1B3C6Du;
+    key ^= key >> 12;
+    return key != 0 ? key : 1;
+}
+
+
+/**
+ * @brief Remember a device dropped after its callback, for the duplicate filter.
+ */
+void NimBLEScan::markSeen(NimBLEAdvertisedDevice* pDevice) {
+#if CONFIG_BT_NIMBLE_EXT_ADV
+    uint32_t key = scanSeenHash(pDevice->m_address, pDevice->m_sid);
+#else
+    uint32_t key = scanSeenHash(pDevice->m_address, 0);
+#endif
+    uint16_t i = key & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1);
+    if(m_seenCount >= CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE * 3 / 4 && m_seen[i] != 0) {
+        m_seen[i] = key;
+        return;
+    }
+
+    while(m_seen[i] != 0) {
+        i = (i + 1) & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1);
+    }
+    m_seen[i] = key;
+    m_seenCount++;
+}
+
+
+/**
+ * @brief Check whether a new advertiser was reported before it was dropped, and forget it.
+ * @param [in] address The advertiser's address.
+ * @param [in] sid The advertising set ID, 0 without extended advertising.
+ * @return True if its callback was already sent.
+ */
+bool NimBLEScan::takeSeen(const NimBLEAddress &address, uint8_t sid) {
+    uint32_t key = scanSeenHash(address, sid);
+    uint16_t hole = key & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1);
+    while(m_seen[hole] != key) {
+        if(m_seen[hole] == 0) {
+            return false;
+        }
+        hole = (hole + 1) & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1);
+    }
+
+    // Backward-shift deletion, as for the device index
+    for(uint16_t i = (hole + 1) & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1);
+        m_seen[i] != 0;
+        i = (i + 1) & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1)) {
+        uint16_t home = m_seen[i] & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1);
+        if(((i - home) & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1)) >=
+           ((i - hole) & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1))) {
+            m_seen[hole] = m_seen[i];
+            hole = i;
+        }
+    }
+    m_seen[hole] = 0;
+    m_seenCount--;
+    return true;
 }
 
 
@@ -499,6 +746,10 @@ void NimBLEScan::onHostSync() {
 /**
  * @brief Get the results of the scan.
  * @return NimBLEScanResults object.
+ * @details The results hold pointers into the scan's device pool. A pointer is valid until
+ * the device is erased or the results are cleared (including by a new scan), and once
+ * CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS devices are stored it may be reused for a new
+ * advertiser. Copy the device to keep it.
  */
 NimBLEScanResults NimBLEScan::getResults() {
     return m_scanResults;
@@ -509,10 +760,7 @@ NimBLEScanResults NimBLEScan::getResults() {
  * @brief Clear the results of the scan.
  */
 void NimBLEScan::clearResults() {
-    for(auto &it: m_scanResults.m_advertisedDevicesVector) {
-        delete it;
-    }
-    m_scanResults.m_advertisedDevicesVector.clear();
+    resetDevices();
     clearDuplicateCache();
 }
 
@@ -28,6 +28,37 @@
 
 #include <vector>
 
+#if !defined(CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS)
+#    define CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS 64
+#elif CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS > 255
+#    error CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS cannot be larger than 255
+#elif CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS < 1
+#    error CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS cannot be less than 1; Range = 1 : 255
+#endif
+
+/* The address index is open addressed and kept at most half full. */
+#if CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS <= 8
+#    define NIMBLE_SCAN_INDEX_BITS 4
+#elif CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS <= 16
+#    define NIMBLE_SCAN_INDEX_BITS 5
+#elif CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS <= 32
+#    define NIMBLE_SCAN_INDEX_BITS 6
+#elif CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS <= 64
+#    define NIMBLE_SCAN_INDEX_BITS 7
+#elif CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS <= 128
+#    define NIMBLE_SCAN_INDEX_BITS 8
+#else
+#    define NIMBLE_SCAN_INDEX_BITS 9
+#endif
+#define NIMBLE_SCAN_INDEX_SIZE (1 << NIMBLE_SCAN_INDEX_BITS)
+#define NIMBLE_SCAN_NO_DEVICE  0xFF
+
+#if !defined(CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE)
+#    define CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE 512
+#elif CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE & (CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE - 1)
+#    error CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE must be a power of 2
+#endif
+
 class NimBLEDevice;
 class NimBLEScan;
 class NimBLEAdvertisedDevice;
@@ -88,6 +119,13 @@ private:
     static int          handleGapEvent(ble_gap_event*  event, void* arg);
     void                onHostReset();
     void                onHostSync();
+    void                resetDevices();
+    NimBLEAdvertisedDevice* findDevice(const NimBLEAddress &address, int sid);
+    NimBLEAdvertisedDevice* allocDevice(const NimBLEAddress &address);
+    void                releaseDevice(NimBLEAdvertisedDevice* pDevice);
+    void                touchDevice(NimBLEAdvertisedDevice* pDevice);
+    void                markSeen(NimBLEAdvertisedDevice* pDevice);
+    bool                takeSeen(const NimBLEAddress &address, uint8_t sid);
 
     NimBLEAdvertisedDeviceCallbacks*    m_pAdvertisedDeviceCallbacks = nullptr;
     void                                (*m_scanCompleteCB)(NimBLEScanResults scanResults);
@@ -97,6 +135,31 @@ private:
     uint32_t                            m_duration;
     ble_task_data_t                     *m_pTaskData;
     uint8_t                             m_maxResults;
+
+    /*
+     * Advertised devices come from a fixed pool, are found by address through
+     * m_deviceIndex and are kept in order of the last report (m_lruHead is the
+     * most recent) so a full pool can reuse the one heard from least recently.
+     * Unused devices are linked through m_lruNext from m_freeHead.
+     */
+    NimBLEAdvertisedDevice              m_devices[CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS];
+    uint8_t                             m_lruPrev[CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS];
+    uint8_t                             m_lruNext[CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS];
+    uint8_t                             m_resultPos[CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS];
+    uint8_t                             m_deviceIndex[NIMBLE_SCAN_INDEX_SIZE];
+    uint8_t                             m_lruHead;
+    uint8_t                             m_lruTail;
+    uint8_t                             m_freeHead;
+
+    /*
+     * With the duplicate filter on, advertisers reported and then dropped for
+     * a new one are remembered here by a 32-bit hash of their address (0 is
+     * empty, linear probing), so coming back does not report them again.
+     * Past 3/4 full a new one replaces the entry in its home slot, and the
+     * advertiser replaced may be reported again.
+     */
+    uint32_t                            m_seen[CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE];
+    uint16_t                            m_seenCount;
 };
 
 #endif /* CONFIG_BT_ENABLED CONFIG_BT_NIMBLE_ROLE_OBSERVER */
@@ -58,6 +58,14 @@ static uint16_t ble_att_svr_id;
 static void *ble_att_svr_entry_mem;
 static struct os_mempool ble_att_svr_entry_pool;
 
+/* Visible entries indexed by handle.  Handles are assigned consecutively
+ * from ble_att_svr_index_base as attributes are registered, so the array
+ * (one slot per pool entry) is dense and sorted; hidden entries read as NULL.
+ */
+static struct ble_att_svr_entry **ble_att_svr_index;
+static uint16_t ble_att_svr_index_base;
+static uint16_t ble_att_svr_index_size;
+
 static os_membuf_t ble_att_svr_prep_entry_mem[
     OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_ATT_SVR_MAX_PREP_ENTRIES),
                     sizeof (struct ble_att_prep_entry))
@@ -84,6 +92,41 @@ ble_att_svr_entry_free(struct ble_att_svr_entry *entry)
     os_memblock_put(&ble_att_svr_entry_pool, entry);
 }
 
+static void
+ble_att_svr_index_set(uint16_t handle_id, struct ble_att_svr_entry *entry)
+{
+    uint16_t slot;
+
+    slot = handle_id - ble_att_svr_index_base;
+    if (handle_id >= ble_att_svr_index_base && slot < ble_att_svr_index_size) {
+        ble_att_svr_index[slot] = entry;
+    }
+}
+
+/**
+ * Find the first visible attribute with a handle at or above start_handle.
+ * Range requests begin here and continue along the (sorted) list.
+ */
+static struct ble_att_svr_entry *
+ble_att_svr_find_first(uint16_t start_handle)
+{
+    uint16_t slot;
+
+    if (start_handle < ble_att_svr_index_base) {
+        start_handle = ble_att_svr_index_base;
+    }
+    for (slot = start_handle - ble_att_svr_index_base;
+         slot < ble_att_svr_index_size;
+         slot++) {
+
+        if (ble_att_svr_index[slot] != NULL) {
+            return ble_att_svr_index[slot];
+        }
+    }
+
+    return NULL;
+}
+
 /**
  * Allocate the next handle id and return it.
  *
@@ -128,6 +171,7 @@ ble_att_svr_register(const ble_uuid_t *uuid, uint8_t flags,
     entry->ha_cb_arg = cb_arg;
 
     STAILQ_INSERT_TAIL(&ble_att_svr_list, entry, ha_next);
+    ble_att_svr_index_set(entry->ha_handle_id, entry);
 
     if (handle_id != NULL) {
         *handle_id = entry->ha_handle_id;
@@ -159,18 +203,14 @@ ble_att_svr_prev_handle(void)
 struct ble_att_svr_entry *
 ble_att_svr_find_by_handle(uint16_t handle_id)
 {
-    struct ble_att_svr_entry *entry;
-
-    for (entry = STAILQ_FIRST(&ble_att_svr_list);
-         entry != NULL;
-         entry = STAILQ_NEXT(entry, ha_next)) {
+    uint16_t slot;
 
-        if (entry->ha_handle_id == handle_id) {
-            return entry;
-        }
+    slot = handle_id - ble_att_svr_index_base;
+    if (handle_id < ble_att_svr_index_base || slot >= ble_att_svr_index_size) {
+        return NULL;
     }
 
-    return NULL;
+    return ble_att_svr_index[slot];
 }
 
 /**
@@ -188,6 +228,22 @@ ble_att_svr_find_by_handle(uint16_t handle_id)
  *
  * @return                      0 on success; BLE_HS_ENOENT on not found.
  */
+static struct ble_att_svr_entry *
+ble_att_svr_find_by_uuid_from(struct ble_att_svr_entry *entry,
+                              const ble_uuid_t *uuid, uint16_t end_handle)
+{
+    for (;
+         entry != NULL && entry->ha_handle_id <= end_handle;
+         entry = STAILQ_NEXT(entry, ha_next)) {
+
+        if (uuid == NULL || ble_uuid_cmp(entry->ha_uuid, uuid) == 0) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
 struct ble_att_svr_entry *
 ble_att_svr_find_by_uuid(struct ble_att_svr_entry *prev, const ble_uuid_t *uuid,
                          uint16_t end_handle)
@@ -200,16 +256,7 @@ ble_att_svr_find_by_uuid(struct ble_att_svr_entry *prev, const ble_uuid_t *uuid,
         entry = STAILQ_NEXT(prev, ha_next);
     }
 
-    for (;
-         entry != NULL && entry->ha_handle_id <= end_handle;
-         entry = STAILQ_NEXT(entry, ha_next)) {
-
-        if (uuid == NULL || ble_uuid_cmp(entry->ha_uuid, uuid) == 0) {
-            return entry;
-        }
-    }
-
-    return NULL;
+    return ble_att_svr_find_by_uuid_from(entry, uuid, end_handle);
 }
 
 static int
@@ -797,7 +844,10 @@ ble_att_svr_fill_info(uint16_t start_handle, uint16_t end_handle,
     num_entries = 0;
     rc = 0;
 
-    STAILQ_FOREACH(ha, &ble_att_svr_list, ha_next) {
+    for (ha = ble_att_svr_find_first(start_handle);
+         ha != NULL;
+         ha = STAILQ_NEXT(ha, ha_next)) {
+
         if (ha->ha_handle_id > end_handle) {
             rc = 0;
             goto done;
@@ -1082,10 +1132,9 @@ ble_att_svr_fill_type_value(uint16_t conn_handle,
      * matching group.  For each attribute entry, determine if data needs to be
      * written to the response.
      */
-    STAILQ_FOREACH(ha, &ble_att_svr_list, ha_next) {
-        if (ha->ha_handle_id < start_handle) {
-            continue;
-        }
+    for (ha = ble_att_svr_find_first(start_handle);
+         ha != NULL;
+         ha = STAILQ_NEXT(ha, ha_next)) {
 
         /* Continue to look for end of group in case group is in progress. */
         if (!first && ha->ha_handle_id > end_handle) {
@@ -1307,7 +1356,12 @@ ble_att_svr_build_read_type_rsp(uint16_t conn_handle,
     /* Find all matching attributes, writing a record for each. */
     entry = NULL;
     while (1) {
-        entry = ble_att_svr_find_by_uuid(entry, uuid, end_handle);
+        if (entry == NULL) {
+            entry = ble_att_svr_find_by_uuid_from(
+                ble_att_svr_find_first(start_handle), uuid, end_handle);
+        } else {
+            entry = ble_att_svr_find_by_uuid(entry, uuid, end_handle);
+        }
         if (entry == NULL) {
             rc = BLE_HS_ENOENT;
             break;
@@ -1734,10 +1788,10 @@ ble_att_svr_build_read_group_type_rsp(uint16_t conn_handle,
 
     start_group_handle = 0;
     rsp->bagp_length = 0;
-    STAILQ_FOREACH(entry, &ble_att_svr_list, ha_next) {
-        if (entry->ha_handle_id < start_handle) {
-            continue;
-        }
+    for (entry = ble_att_svr_find_first(start_handle);
+         entry != NULL;
+         entry = STAILQ_NEXT(entry, ha_next)) {
+
         if (entry->ha_handle_id > end_handle) {
             /* The full input range has been searched. */
             rc = 0;
@@ -2618,6 +2672,10 @@ ble_att_svr_move_entries(struct ble_att_svr_entry_list *src,
             STAILQ_REMOVE_AFTER(src, remove, ha_next);
         }
 
+        /* Only entries in the main list are visible by handle */
+        ble_att_svr_index_set(entry->ha_handle_id,
+                              dst == &ble_att_svr_list ? entry : NULL);
+
         /* Insert current element */
         if (insert == NULL) {
             STAILQ_INSERT_HEAD(dst, entry, ha_next);
@@ -2665,6 +2723,11 @@ ble_att_svr_reset(void)
         ble_att_svr_entry_free(entry);
     }
 
+    if (ble_att_svr_index != NULL) {
+        memset(ble_att_svr_index, 0,
+               ble_att_svr_index_size * sizeof *ble_att_svr_index);
+    }
+
     /* Note: prep entries do not get freed here because it is assumed there are
      * no established connections.
      */
@@ -2679,6 +2742,14 @@ ble_att_svr_free_start_mem(void)
     free(ble_att_svr_entry_mem);
 #endif
     ble_att_svr_entry_mem = NULL;
+
+#ifdef ESP_PLATFORM
+    nimble_platform_mem_free(ble_att_svr_index);
+#else
+    free(ble_att_svr_index);
+#endif
+    ble_att_svr_index = NULL;
+    ble_att_svr_index_size = 0;
 }
 
 int
@@ -2708,6 +2779,20 @@ ble_att_svr_start(void)
             rc = BLE_HS_EOS;
             goto err;
         }
+
+        /* The attributes registered next take the following handles. */
+#ifdef ESP_PLATFORM
+        ble_att_svr_index = nimble_platform_mem_calloc(
+#else
+        ble_att_svr_index = calloc(
+#endif
+            ble_hs_max_attrs, sizeof *ble_att_svr_index);
+        if (ble_att_svr_index == NULL) {
+            rc = BLE_HS_ENOMEM;
+            goto err;
+        }
+        ble_att_svr_index_base = ble_att_svr_id + 1;
+        ble_att_svr_index_size = ble_hs_max_attrs;
     }
 
     return 0;
@@ -38,6 +38,135 @@ static os_membuf_t ble_hs_conn_elem_mem[
 
 static const uint8_t ble_hs_conn_null_addr[6];
 
+/**
+ * Open-addressed indexes over ble_hs_conns, so the lookups done for every HCI
+ * event and ACL packet don't walk the list.  Tables are at most half full
+ * (the address index holds up to two keys per connection: peer address and
+ * peer RPA) and use linear probing.
+ */
+#if MYNEWT_VAL(BLE_MAX_CONNECTIONS) <= 4
+#define BLE_HS_CONN_INDEX_SIZE      8
+#elif MYNEWT_VAL(BLE_MAX_CONNECTIONS) <= 8
+#define BLE_HS_CONN_INDEX_SIZE      16
+#elif MYNEWT_VAL(BLE_MAX_CONNECTIONS) <= 16
+#define BLE_HS_CONN_INDEX_SIZE      32
+#else
+#define BLE_HS_CONN_INDEX_SIZE      64
+#endif
+#define BLE_HS_CONN_ADDR_INDEX_SIZE (2 * BLE_HS_CONN_INDEX_SIZE)
+
+static struct ble_hs_conn *ble_hs_conn_handle_index[BLE_HS_CONN_INDEX_SIZE];
+static struct ble_hs_conn *ble_hs_conn_addr_index[BLE_HS_CONN_ADDR_INDEX_SIZE];
+
+static int
+ble_hs_conn_handle_slot(uint16_t conn_handle)
+{
+    /* Controllers hand out small, mostly sequential handles. */
+    return conn_handle & (BLE_HS_CONN_INDEX_SIZE - 1);
+}
+
+static int
+ble_hs_conn_addr_slot(const uint8_t *val)
+{
+    uint32_t hash;
+
+    /* Multiplicative hash of the address value; the type isn't hashed, so
+     * lookups by identity and by over-the-air type land in the same bucket.
+     */
+    hash = ((uint32_t)val[0] | (uint32_t)val[1] << 8 |
+            (uint32_t)val[2] << 16 | (uint32_t)val[3] << 24) ^
+           ((uint32_t)val[4] | (uint32_t)val[5] << 8);
+    hash *= 2654435761u;
+
+    return (hash >> 24) & (BLE_HS_CONN_ADDR_INDEX_SIZE - 1);
+}
+
+static void
+ble_hs_conn_handle_index_add(struct ble_hs_conn *conn)
+{
+    int slot;
+
+    slot = ble_hs_conn_handle_slot(conn->bhc_handle);
+    while (ble_hs_conn_handle_index[slot] != NULL) {
+        slot = (slot + 1) & (BLE_HS_CONN_INDEX_SIZE - 1);
+    }
+    ble_hs_conn_handle_index[slot] = conn;
+}
+
+static void
+ble_hs_conn_handle_index_remove(struct ble_hs_conn *conn)
+{
+    struct ble_hs_conn *cur;
+    int slot;
+    int next;
+    int home;
+
+    slot = ble_hs_conn_handle_slot(conn->bhc_handle);
+    while (ble_hs_conn_handle_index[slot] != conn) {
+        if (ble_hs_conn_handle_index[slot] == NULL) {
+            return;
+        }
+        slot = (slot + 1) & (BLE_HS_CONN_INDEX_SIZE - 1);
+    }
+
+    /* Backward-shift deletion: pull later entries of the probe run into the
+     * hole if their home slot allows it, so no tombstones are needed.
+     */
+    next = slot;
+    for (;;) {
+        ble_hs_conn_handle_index[slot] = NULL;
+        for (;;) {
+            next = (next + 1) & (BLE_HS_CONN_INDEX_SIZE - 1);
+            cur = ble_hs_conn_handle_index[next];
+            if (cur == NULL) {
+                return;
+            }
+            home = ble_hs_conn_handle_slot(cur->bhc_handle);
+            if (((next - home) & (BLE_HS_CONN_INDEX_SIZE - 1)) >=
+                ((next - slot) & (BLE_HS_CONN_INDEX_SIZE - 1))) {
+                break;
+            }
+        }
+        ble_hs_conn_handle_index[slot] = cur;
+        slot = next;
+    }
+}
+
+static void
+ble_hs_conn_addr_index_add_key(struct ble_hs_conn *conn, const uint8_t *val)
+{
+    int slot;
+
+    slot = ble_hs_conn_addr_slot(val);
+    while (ble_hs_conn_addr_index[slot] != NULL) {
+        if (ble_hs_conn_addr_index[slot] == conn) {
+            return;
+        }
+        slot = (slot + 1) & (BLE_HS_CONN_ADDR_INDEX_SIZE - 1);
+    }
+    ble_hs_conn_addr_index[slot] = conn;
+}
+
+/**
+ * Rebuilds the address index from the connection list.  Connections come and
+ * go rarely and pairing or privacy may rewrite a peer address in place, so the
+ * index is rebuilt rather than maintained entry by entry.
+ */
+static void
+ble_hs_conn_addr_index_rebuild(void)
+{
+    struct ble_hs_conn *conn;
+
+    memset(ble_hs_conn_addr_index, 0, sizeof ble_hs_conn_addr_index);
+    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
+        ble_hs_conn_addr_index_add_key(conn, conn->bhc_peer_addr.val);
+        if (memcmp(conn->bhc_peer_rpa_addr.val, ble_hs_conn_null_addr,
+                   6) != 0) {
+            ble_hs_conn_addr_index_add_key(conn, conn->bhc_peer_rpa_addr.val);
+        }
+    }
+}
+
 int
 ble_hs_conn_can_alloc(void)
 {
@@ -275,6 +404,8 @@ ble_hs_conn_insert(struct ble_hs_conn *conn)
 
     BLE_HS_DBG_ASSERT_EVAL(ble_hs_conn_find(conn->bhc_handle) == NULL);
     SLIST_INSERT_HEAD(&ble_hs_conns, conn, bhc_next);
+    ble_hs_conn_handle_index_add(conn);
+    ble_hs_conn_addr_index_rebuild();
 }
 
 void
@@ -287,6 +418,21 @@ ble_hs_conn_remove(struct ble_hs_conn *conn)
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
     SLIST_REMOVE(&ble_hs_conns, conn, ble_hs_conn, bhc_next);
+    ble_hs_conn_handle_index_remove(conn);
+    ble_hs_conn_addr_index_rebuild();
+}
+
+void
+ble_hs_conn_addr_changed(struct ble_hs_conn *conn)
+{
+#if !NIMBLE_BLE_CONNECT
+    return;
+#endif
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    (void)conn;
+    ble_hs_conn_addr_index_rebuild();
 }
 
 struct ble_hs_conn *
@@ -297,13 +443,16 @@ ble_hs_conn_find(uint16_t conn_handle)
 #endif
 
     struct ble_hs_conn *conn;
+    int slot;
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
-    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
+    slot = ble_hs_conn_handle_slot(conn_handle);
+    while ((conn = ble_hs_conn_handle_index[slot]) != NULL) {
         if (conn->bhc_handle == conn_handle) {
             return conn;
         }
+        slot = (slot + 1) & (BLE_HS_CONN_INDEX_SIZE - 1);
     }
 
     return NULL;
@@ -320,6 +469,26 @@ ble_hs_conn_find_assert(uint16_t conn_handle)
     return conn;
 }
 
+static int
+ble_hs_conn_addr_matches(const struct ble_hs_conn *conn, const ble_addr_t *addr)
+{
+    struct ble_hs_conn_addrs addrs;
+
+    if (BLE_ADDR_IS_RPA(addr)) {
+        return ble_addr_cmp(&conn->bhc_peer_rpa_addr, addr) == 0;
+    }
+
+    if (ble_addr_cmp(&conn->bhc_peer_addr, addr) == 0) {
+        return 1;
+    }
+    if (conn->bhc_peer_addr.type < BLE_OWN_ADDR_RPA_PUBLIC_DEFAULT) {
+        return 0;
+    }
+    /*If type 0x02 or 0x03 is used, let's double check if address is good */
+    ble_hs_conn_addrs(conn, &addrs);
+    return ble_addr_cmp(&addrs.peer_id_addr, addr) == 0;
+}
+
 struct ble_hs_conn *
 ble_hs_conn_find_by_addr(const ble_addr_t *addr)
 {
@@ -328,7 +497,7 @@ ble_hs_conn_find_by_addr(const ble_addr_t *addr)
 #endif
 
     struct ble_hs_conn *conn;
-    struct ble_hs_conn_addrs addrs;
+    int slot;
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
@@ -336,25 +505,27 @@ ble_hs_conn_find_by_addr(const ble_addr_t *addr)
         return NULL;
     }
 
-    SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
-        if (BLE_ADDR_IS_RPA(addr)) {
-            if (ble_addr_cmp(&conn->bhc_peer_rpa_addr, addr) == 0) {
-                return conn;
-            }
-        } else {
-            if (ble_addr_cmp(&conn->bhc_peer_addr, addr) == 0) {
-                return conn;
-            }
-            if (conn->bhc_peer_addr.type < BLE_OWN_ADDR_RPA_PUBLIC_DEFAULT) {
-                continue;
-            }
-            /*If type 0x02 or 0x03 is used, let's double check if address is good */
-            ble_hs_conn_addrs(conn, &addrs);
-            if (ble_addr_cmp(&addrs.peer_id_addr, addr) == 0) {
+    slot = ble_hs_conn_addr_slot(addr->val);
+    while ((conn = ble_hs_conn_addr_index[slot]) != NULL) {
+        if (ble_hs_conn_addr_matches(conn, addr)) {
+            return conn;
+        }
+        slot = (slot + 1) & (BLE_HS_CONN_ADDR_INDEX_SIZE - 1);
+    }
+
+#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
+    /* The identity address of a resolved peer comes from the resolving list
+     * and isn't stored in the connection; check those connections directly.
+     */
+    if (!BLE_ADDR_IS_RPA(addr)) {
+        SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
+            if (conn->bhc_peer_addr.type >= BLE_OWN_ADDR_RPA_PUBLIC_DEFAULT &&
+                ble_hs_conn_addr_matches(conn, addr)) {
                 return conn;
             }
         }
     }
+#endif
 
     return NULL;
 }
@@ -598,6 +769,8 @@ ble_hs_conn_init(void)
     }
 
     SLIST_INIT(&ble_hs_conns);
+    memset(ble_hs_conn_handle_index, 0, sizeof ble_hs_conn_handle_index);
+    memset(ble_hs_conn_addr_index, 0, sizeof ble_hs_conn_addr_index);
 
     return 0;
 }
@@ -210,6 +210,7 @@ ble_rpa_replace_id_with_rand_addr(uint8_t *addr_type, uint8_t *peer_addr)
                 memcpy(&conn->bhc_peer_rpa_addr.val[0], p_dev_rec->rand_addr, BLE_DEV_ADDR_LEN);
                 conn->bhc_peer_addr.type = p_dev_rec->rand_addr_type;
                 memcpy(&conn->bhc_peer_addr.val[0], p_dev_rec->rand_addr, BLE_DEV_ADDR_LEN);
+                ble_hs_conn_addr_changed(conn);
                 BLE_HS_LOG(DEBUG, "\n Replace Identity addr with random addr received at"
                                   " start of the connection\n");
             }
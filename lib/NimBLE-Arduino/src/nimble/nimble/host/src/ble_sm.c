@@ -582,6 +582,8 @@ ble_sm_persist_keys(struct ble_sm_proc *proc)
             }
 #endif
         }
+
+        ble_hs_conn_addr_changed(conn);
     } else {
         peer_addr = conn->bhc_peer_addr;
         peer_addr.type =
@@ -38,6 +38,122 @@ struct ble_store_value_cccd
     ble_store_config_cccds[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
 int ble_store_config_num_cccds;
 
+/*****************************************************************************
+ * $index                                                                    *
+ *****************************************************************************/
+
+/**
+ * Hash chains over the peer address of each record array, so a reconnecting
+ * peer's keys and CCCDs are found without scanning every bond.  A chain lists
+ * array indices in ascending order, so walking it sees matches in the same
+ * order as a linear scan and the key's idx (skip count) keeps its meaning.
+ * Chains are rebuilt whenever records are added, removed or restored.
+ */
+#define BLE_STORE_CONFIG_INDEX_BUCKETS  16
+
+struct ble_store_config_index {
+    int16_t head[BLE_STORE_CONFIG_INDEX_BUCKETS];
+    int16_t *next;
+};
+
+static int16_t ble_store_config_our_sec_next[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static struct ble_store_config_index ble_store_config_our_sec_index = {
+    .next = ble_store_config_our_sec_next,
+};
+
+static int16_t ble_store_config_peer_sec_next[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+static struct ble_store_config_index ble_store_config_peer_sec_index = {
+    .next = ble_store_config_peer_sec_next,
+};
+
+static int16_t ble_store_config_cccd_next[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+static struct ble_store_config_index ble_store_config_cccd_index = {
+    .next = ble_store_config_cccd_next,
+};
+
+static int
+ble_store_config_addr_bucket(const ble_addr_t *addr)
+{
+    uint32_t hash;
+
+    hash = ((uint32_t)addr->val[0] | (uint32_t)addr->val[1] << 8 |
+            (uint32_t)addr->val[2] << 16 | (uint32_t)addr->val[3] << 24) ^
+           ((uint32_t)addr->val[4] | (uint32_t)addr->val[5] << 8 |
+            (uint32_t)addr->type << 16);
+    hash *= 2654435761u;
+
+    return (hash >> 24) & (BLE_STORE_CONFIG_INDEX_BUCKETS - 1);
+}
+
+/**
+ * Rebuilds an index over an array of store values.  Both value types start
+ * with the peer address.
+ */
+static void
+ble_store_config_index_rebuild(struct ble_store_config_index *index,
+                               const void *values, int value_size,
+                               int num_values)
+{
+    const ble_addr_t *addr;
+    int bucket;
+    int i;
+
+    for (i = 0; i < BLE_STORE_CONFIG_INDEX_BUCKETS; i++) {
+        index->head[i] = -1;
+    }
+
+    for (i = num_values - 1; i >= 0; i--) {
+        addr = (const ble_addr_t *)((const uint8_t *)values + i * value_size);
+        bucket = ble_store_config_addr_bucket(addr);
+        index->next[i] = index->head[bucket];
+        index->head[bucket] = i;
+    }
+}
+
+/**
+ * First candidate for a lookup: the head of the address's chain, or the
+ * first record if the key matches any address.
+ */
+static int
+ble_store_config_index_first(const struct ble_store_config_index *index,
+                             const ble_addr_t *addr, int num_values)
+{
+    if (ble_addr_cmp(addr, BLE_ADDR_ANY)) {
+        return index->head[ble_store_config_addr_bucket(addr)];
+    }
+
+    return num_values > 0 ? 0 : -1;
+}
+
+static int
+ble_store_config_index_next(const struct ble_store_config_index *index,
+                            const ble_addr_t *addr, int cur, int num_values)
+{
+    if (ble_addr_cmp(addr, BLE_ADDR_ANY)) {
+        return index->next[cur];
+    }
+
+    return cur + 1 < num_values ? cur + 1 : -1;
+}
+
+/* Rebuilds all indexes after the arrays were loaded wholesale. */
+static void
+ble_store_config_reindex(void)
+{
+    ble_store_config_index_rebuild(&ble_store_config_our_sec_index,
+                                   ble_store_config_our_secs,
+                                   sizeof *ble_store_config_our_secs,
+                                   ble_store_config_num_our_secs);
+    ble_store_config_index_rebuild(&ble_store_config_peer_sec_index,
+                                   ble_store_config_peer_secs,
+                                   sizeof *ble_store_config_peer_secs,
+                                   ble_store_config_num_peer_secs);
+    ble_store_config_index_rebuild(&ble_store_config_cccd_index,
+                                   ble_store_config_cccds,
+                                   sizeof *ble_store_config_cccds,
+                                   ble_store_config_num_cccds);
+}
+
 /*****************************************************************************
  * $sec                                                                      *
  *****************************************************************************/
@@ -83,7 +199,8 @@ ble_store_config_print_key_sec(const struct ble_store_key_sec *key_sec)
 static int
 ble_store_config_find_sec(const struct ble_store_key_sec *key_sec,
                           const struct ble_store_value_sec *value_secs,
-                          int num_value_secs)
+                          int num_value_secs,
+                          const struct ble_store_config_index *index)
 {
     const struct ble_store_value_sec *cur;
     int skipped;
@@ -91,7 +208,11 @@ ble_store_config_find_sec(const struct ble_store_key_sec *key_sec,
 
     skipped = 0;
 
-    for (i = 0; i < num_value_secs; i++) {
+    for (i = ble_store_config_index_first(index, &key_sec->peer_addr,
+                                          num_value_secs);
+         i != -1;
+         i = ble_store_config_index_next(index, &key_sec->peer_addr, i,
+                                         num_value_secs)) {
         cur = value_secs + i;
 
         if (ble_addr_cmp(&key_sec->peer_addr, BLE_ADDR_ANY)) {
@@ -128,7 +249,8 @@ ble_store_config_read_our_sec(const struct ble_store_key_sec *key_sec,
     int idx;
 
     idx = ble_store_config_find_sec(key_sec, ble_store_config_our_secs,
-                                    ble_store_config_num_our_secs);
+                                    ble_store_config_num_our_secs,
+                                    &ble_store_config_our_sec_index);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
@@ -150,7 +272,8 @@ ble_store_config_write_our_sec(const struct ble_store_value_sec *value_sec)
 
     ble_store_key_from_value_sec(&key_sec, value_sec);
     idx = ble_store_config_find_sec(&key_sec, ble_store_config_our_secs,
-                                    ble_store_config_num_our_secs);
+                                    ble_store_config_num_our_secs,
+                                    &ble_store_config_our_sec_index);
     if (idx == -1) {
         if (ble_store_config_num_our_secs >= MYNEWT_VAL(BLE_STORE_MAX_BONDS)) {
             BLE_HS_LOG(DEBUG, "error persisting our sec; too many entries "
@@ -160,10 +283,15 @@ ble_store_config_write_our_sec(const struct ble_store_value_sec *value_sec)
 
         idx = ble_store_config_num_our_secs;
         ble_store_config_num_our_secs++;
+        ble_store_config_our_secs[idx] = *value_sec;
+        ble_store_config_index_rebuild(&ble_store_config_our_sec_index,
+                                       ble_store_config_our_secs,
+                                       sizeof *ble_store_config_our_secs,
+                                       ble_store_config_num_our_secs);
+    } else {
+        ble_store_config_our_secs[idx] = *value_sec;
     }
 
-    ble_store_config_our_secs[idx] = *value_sec;
-
     rc = ble_store_config_persist_our_secs();
     if (rc != 0) {
         return rc;
@@ -196,12 +324,14 @@ ble_store_config_delete_obj(void *values, int value_size, int idx,
 static int
 ble_store_config_delete_sec(const struct ble_store_key_sec *key_sec,
                             struct ble_store_value_sec *value_secs,
-                            int *num_value_secs)
+                            int *num_value_secs,
+                            struct ble_store_config_index *index)
 {
     int idx;
     int rc;
 
-    idx = ble_store_config_find_sec(key_sec, value_secs, *num_value_secs);
+    idx = ble_store_config_find_sec(key_sec, value_secs, *num_value_secs,
+                                    index);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
@@ -212,6 +342,8 @@ ble_store_config_delete_sec(const struct ble_store_key_sec *key_sec,
         return rc;
     }
 
+    ble_store_config_index_rebuild(index, value_secs, sizeof *value_secs,
+                                   *num_value_secs);
     return 0;
 }
 
@@ -221,7 +353,8 @@ ble_store_config_delete_our_sec(const struct ble_store_key_sec *key_sec)
     int rc;
 
     rc = ble_store_config_delete_sec(key_sec, ble_store_config_our_secs,
-                                     &ble_store_config_num_our_secs);
+                                     &ble_store_config_num_our_secs,
+                                     &ble_store_config_our_sec_index);
     if (rc != 0) {
         return rc;
     }
@@ -240,7 +373,8 @@ ble_store_config_delete_peer_sec(const struct ble_store_key_sec *key_sec)
     int rc;
 
     rc = ble_store_config_delete_sec(key_sec, ble_store_config_peer_secs,
-                                  &ble_store_config_num_peer_secs);
+                                  &ble_store_config_num_peer_secs,
+                                  &ble_store_config_peer_sec_index);
     if (rc != 0) {
         return rc;
     }
@@ -260,7 +394,8 @@ ble_store_config_read_peer_sec(const struct ble_store_key_sec *key_sec,
     int idx;
 
     idx = ble_store_config_find_sec(key_sec, ble_store_config_peer_secs,
-                             ble_store_config_num_peer_secs);
+                             ble_store_config_num_peer_secs,
+                             &ble_store_config_peer_sec_index);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
@@ -281,7 +416,8 @@ ble_store_config_write_peer_sec(const struct ble_store_value_sec *value_sec)
 
     ble_store_key_from_value_sec(&key_sec, value_sec);
     idx = ble_store_config_find_sec(&key_sec, ble_store_config_peer_secs,
-                                 ble_store_config_num_peer_secs);
+                                 ble_store_config_num_peer_secs,
+                                 &ble_store_config_peer_sec_index);
     if (idx == -1) {
         if (ble_store_config_num_peer_secs >= MYNEWT_VAL(BLE_STORE_MAX_BONDS)) {
             BLE_HS_LOG(DEBUG, "error persisting peer sec; too many entries "
@@ -291,10 +427,15 @@ ble_store_config_write_peer_sec(const struct ble_store_value_sec *value_sec)
 
         idx = ble_store_config_num_peer_secs;
         ble_store_config_num_peer_secs++;
+        ble_store_config_peer_secs[idx] = *value_sec;
+        ble_store_config_index_rebuild(&ble_store_config_peer_sec_index,
+                                       ble_store_config_peer_secs,
+                                       sizeof *ble_store_config_peer_secs,
+                                       ble_store_config_num_peer_secs);
+    } else {
+        ble_store_config_peer_secs[idx] = *value_sec;
     }
 
-    ble_store_config_peer_secs[idx] = *value_sec;
-
     rc = ble_store_config_persist_peer_secs();
     if (rc != 0) {
         return rc;
@@ -315,7 +456,13 @@ ble_store_config_find_cccd(const struct ble_store_key_cccd *key)
     int i;
 
     skipped = 0;
-    for (i = 0; i < ble_store_config_num_cccds; i++) {
+    for (i = ble_store_config_index_first(&ble_store_config_cccd_index,
+                                          &key->peer_addr,
+                                          ble_store_config_num_cccds);
+         i != -1;
+         i = ble_store_config_index_next(&ble_store_config_cccd_index,
+                                         &key->peer_addr, i,
+                                         ble_store_config_num_cccds)) {
         cccd = ble_store_config_cccds + i;
 
         if (ble_addr_cmp(&key->peer_addr, BLE_ADDR_ANY)) {
@@ -360,6 +507,11 @@ ble_store_config_delete_cccd(const struct ble_store_key_cccd *key_cccd)
         return rc;
     }
 
+    ble_store_config_index_rebuild(&ble_store_config_cccd_index,
+                                   ble_store_config_cccds,
+                                   sizeof *ble_store_config_cccds,
+                                   ble_store_config_num_cccds);
+
     rc = ble_store_config_persist_cccds();
     if (rc != 0) {
         return rc;
@@ -401,10 +553,15 @@ ble_store_config_write_cccd(const struct ble_store_value_cccd *value_cccd)
 
         idx = ble_store_config_num_cccds;
         ble_store_config_num_cccds++;
+        ble_store_config_cccds[idx] = *value_cccd;
+        ble_store_config_index_rebuild(&ble_store_config_cccd_index,
+                                       ble_store_config_cccds,
+                                       sizeof *ble_store_config_cccds,
+                                       ble_store_config_num_cccds);
+    } else {
+        ble_store_config_cccds[idx] = *value_cccd;
     }
 
-    ble_store_config_cccds[idx] = *value_cccd;
-
     rc = ble_store_config_persist_cccds();
     if (rc != 0) {
         return rc;
@@ -528,4 +685,5 @@ ble_store_config_init(void)
     ble_store_config_num_cccds = 0;
 
     ble_store_config_conf_init();
+    ble_store_config_reindex();
 }
@@ -42,49 +42,53 @@
 #define NIMBLE_NVS_PEER_RECORDS_KEY              "p_dev_rec"
 #define NIMBLE_NVS_NAMESPACE                     "nimble_bond"
 
+/* Each record array is persisted as one blob under "<key>_db": the used
+ * records back to back, so the record count is the blob size divided by the
+ * record size.  Older firmware stored one blob per record under "<key>_<n>";
+ * those are migrated on the first restore.
+ */
+#define NIMBLE_NVS_DB_SUFFIX                     "_db"
+#define NIMBLE_NVS_DB_VERSION_KEY                "db_ver"
+#define NIMBLE_NVS_DB_VERSION                    1
+
 typedef uint32_t nvs_handle_t;
 
 static const char *TAG = "NIMBLE_NVS";
 
+/* Stored format; below NIMBLE_NVS_DB_VERSION, per-record blobs may remain */
+static uint8_t nvs_db_version;
+
 /*****************************************************************************
  * $ MISC                                                                    *
  *****************************************************************************/
 
-static void
-get_nvs_key_string(int obj_type, int index, char *key_string)
+static const char *
+get_nvs_key_prefix(int obj_type)
 {
-    if (obj_type == BLE_STORE_OBJ_TYPE_PEER_DEV_REC) {
-        sprintf(key_string, "%s_%d", NIMBLE_NVS_PEER_RECORDS_KEY, index);
-    } else {
-        if (obj_type == BLE_STORE_OBJ_TYPE_PEER_SEC) {
-            sprintf(key_string, "%s_%d", NIMBLE_NVS_PEER_SEC_KEY, index);
-        } else if (obj_type == BLE_STORE_OBJ_TYPE_OUR_SEC) {
-            sprintf(key_string, "%s_%d", NIMBLE_NVS_OUR_SEC_KEY, index);
-        } else {
-            sprintf(key_string, "%s_%d", NIMBLE_NVS_CCCD_SEC_KEY, index);
-        }
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_PEER_DEV_REC:
+        return NIMBLE_NVS_PEER_RECORDS_KEY;
+    case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        return NIMBLE_NVS_PEER_SEC_KEY;
+    case BLE_STORE_OBJ_TYPE_OUR_SEC:
+        return NIMBLE_NVS_OUR_SEC_KEY;
+    default:
+        return NIMBLE_NVS_CCCD_SEC_KEY;
     }
 }
 
-/* compares values at two addresses of size = item_size
-* @Returns               index if entries match
-*                       -1 if mismatch
-*/
-static int
-get_nvs_matching_index(void *nvs_val, void *db_list, int db_num, size_t
-                       item_size)
+/* Key of a per-record blob written by older firmware */
+static void
+get_nvs_key_string(int obj_type, int index, char *key_string)
 {
-    uint8_t *db_item = (uint8_t *)db_list;
-    int i;
+    sprintf(key_string, "%s_%d", get_nvs_key_prefix(obj_type), index);
+}
 
-    for (i = 0; i < db_num; i++) {
-        if (memcmp(nvs_val, db_item, item_size) == 0) {
-            /* Key matches with the one in RAM database */
-            return i;
-        }
-        db_item += item_size;
-    }
-    return -1;
+static void
+get_nvs_db_key_string(int obj_type, char *key_string)
+{
+    sprintf(key_string, "%s%s", get_nvs_key_prefix(obj_type),
+            NIMBLE_NVS_DB_SUFFIX);
 }
 
 static int
@@ -102,167 +106,34 @@ get_nvs_max_obj_value(int obj_type)
     }
 }
 
-/*****************************************************************************
- * $ NVS                                                                     *
- *****************************************************************************/
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
-static int
-get_nvs_peer_record(char *key_string, struct ble_hs_dev_records *p_dev_rec)
+static size_t
+get_nvs_obj_size(int obj_type)
 {
-    esp_err_t err;
-    size_t required_size = 0;
-    nvs_handle_t nimble_handle;
-
-    err = nvs_open(NIMBLE_NVS_NAMESPACE, NVS_READWRITE, &nimble_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "NVS open operation failed");
-        return BLE_HS_ESTORE_FAIL;
-    }
-
-    err = nvs_get_blob(nimble_handle, key_string, NULL, &required_size);
-
-    /* if Address pointer for value is NULL, filling of value not needed */
-    if (err != ESP_OK || p_dev_rec == NULL) {
-        goto end;
+#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
+    if (obj_type == BLE_STORE_OBJ_TYPE_PEER_DEV_REC) {
+        return sizeof(struct ble_hs_dev_records);
     }
-
-    err = nvs_get_blob(nimble_handle, key_string, p_dev_rec,
-                       &required_size);
-
-end:
-    nvs_close(nimble_handle);
-    return err;
-}
 #endif
-
-static int
-get_nvs_db_value(int obj_type, char *key_string, union ble_store_value *val)
-{
-    esp_err_t err;
-    size_t required_size = 0;
-    nvs_handle_t nimble_handle;
-
-    err = nvs_open(NIMBLE_NVS_NAMESPACE, NVS_READWRITE, &nimble_handle);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "NVS open operation failed");
-        return BLE_HS_ESTORE_FAIL;
-    }
-
-    err = nvs_get_blob(nimble_handle, key_string, NULL, &required_size);
-
-    /* if Address pointer for value is NULL, filling of value not needed */
-    if (err != ESP_OK || val == NULL) {
-        goto end;
-    }
-
     if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
-        err = nvs_get_blob(nimble_handle, key_string, &val->cccd,
-                           &required_size);
-    } else {
-        err = nvs_get_blob(nimble_handle, key_string, &val->sec,
-                           &required_size);
+        return sizeof(struct ble_store_value_cccd);
     }
-
-end:
-    nvs_close(nimble_handle);
-    return err;
+    return sizeof(struct ble_store_value_sec);
 }
 
-/* Finds empty index or total count or index to be deleted in NVS database
-* This function serves 3 different purposes depending upon 'empty' and `value`
-* arguments.
-* @ returns             - empty NVS index, if empty = 1
-*                       - count of NVS database, if empty = 0, value = NULL
-*                       - index that does not match with RAM db, if empty = 0 &
-*                         value has valid database address.
-*/
-static int
-get_nvs_db_attribute(int obj_type, bool empty, void *value, int num_value)
-{
-    union ble_store_value cur = {0};
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
-    struct ble_hs_dev_records p_dev_rec = {0};
-#endif
-    esp_err_t err;
-    int i, count = 0, max_limit = 0;
-    char key_string[NIMBLE_NVS_STR_NAME_MAX_LEN];
-
-    max_limit = get_nvs_max_obj_value(obj_type);
-
-    for (i = 1; i <= max_limit; i++) {
-        get_nvs_key_string(obj_type, i, key_string);
-
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
-        if (obj_type != BLE_STORE_OBJ_TYPE_PEER_DEV_REC) {
-#endif
-            err = get_nvs_db_value(obj_type, key_string, &cur);
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
-        } else {
-            err = get_nvs_peer_record(key_string, &p_dev_rec);
-        }
-#endif
-        /* Check if the user is searching for empty index to write to */
-        if (err == ESP_ERR_NVS_NOT_FOUND) {
-            if (empty) {
-                ESP_LOGD(TAG, "Empty NVS index found = %d for obj_type = %d", i, obj_type);
-                return i;
-            }
-        } else if (err == ESP_OK) {
-            count++;
-            /* If user has provided value, then the purpose is to find
-             * non-matching entry from NVS */
-            if (value) {
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
-                if (obj_type == BLE_STORE_OBJ_TYPE_PEER_DEV_REC) {
-                    err = get_nvs_matching_index(&p_dev_rec.peer_sec,
-                                                 &((struct ble_hs_dev_records *)value)->peer_sec,
-                                                 num_value,
-                                                 sizeof(struct ble_hs_peer_sec));
-                } else
-#endif
-                {
-                    if (obj_type != BLE_STORE_OBJ_TYPE_CCCD) {
-                        err = get_nvs_matching_index(&cur.sec, value, num_value,
-                                                     sizeof(struct ble_store_value_sec));
-                    } else {
-                        err = get_nvs_matching_index(&cur.cccd, value, num_value,
-                                                     sizeof(struct ble_store_value_cccd));
-                    }
-                }
-                /* If found non-matching/odd entry of NVS with entries in the
-                 * internal database, return NVS index so can be deleted */
-                if (err == -1 && !empty) {
-                    return i;
-                }
-            }
-        } else {
-            ESP_LOGE(TAG, "NVS read operation failed while fetching size !!");
-            return -1;
-        }
-    }
-
-    if (empty == 0) {
-        return count;
-    } else {
-        return (max_limit + 1);
-    }
-}
+/*****************************************************************************
+ * $ NVS                                                                     *
+ *****************************************************************************/
 
-/* Deletes NVS value at given index
-* @Returns               0 on success,
-*                       -1 on NVS memory access failure
+/* Writes a record array as one blob, or erases the blob if it is empty.
+* @Returns              0 if success
+*                       BLE_HS_ESTORE_FAIL if failure
 */
 static int
-ble_nvs_delete_value(int obj_type, int8_t index)
+ble_nvs_write_db(int obj_type, const void *values, int num_values)
 {
-    esp_err_t err;
-    nvs_handle_t nimble_handle;
     char key_string[NIMBLE_NVS_STR_NAME_MAX_LEN];
-
-    if (index > get_nvs_max_obj_value(obj_type)) {
-        ESP_LOGE(TAG, "Invalid index provided to delete");
-        return BLE_HS_EUNKNOWN;
-    }
+    nvs_handle_t nimble_handle;
+    esp_err_t err;
 
     err = nvs_open(NIMBLE_NVS_NAMESPACE, NVS_READWRITE, &nimble_handle);
     if (err != ESP_OK) {
@@ -270,15 +141,27 @@ ble_nvs_delete_value(int obj_type, int8_t index)
         return BLE_HS_ESTORE_FAIL;
     }
 
-    get_nvs_key_string(obj_type, index, key_string);
+    get_nvs_db_key_string(obj_type, key_string);
 
-    /* Erase the key with given index */
-    err = nvs_erase_key(nimble_handle, key_string);
+    if (num_values > 0) {
+        /* NVS leaves the flash alone if the blob didn't change */
+        err = nvs_set_blob(nimble_handle, key_string, values,
+                           num_values * get_nvs_obj_size(obj_type));
+    } else {
+        err = nvs_erase_key(nimble_handle, key_string);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
     if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS write operation failed !!");
         goto error;
     }
+
+    /* NVS commit and close */
     err = nvs_commit(nimble_handle);
     if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS commit operation failed !!");
         goto error;
     }
 
@@ -289,163 +172,131 @@ error:
     return BLE_HS_ESTORE_FAIL;
 }
 
-static int
-ble_nvs_write_key_value(char *key, const void *value, size_t required_size)
+/* Reads a record array blob.
+* @Returns              ESP_OK with *num_values set if the blob was read
+*                       ESP_ERR_NVS_NOT_FOUND if there is no blob
+*                       other NVS errors on failure
+*/
+static esp_err_t
+ble_nvs_read_db(nvs_handle_t nimble_handle, int obj_type, void *values,
+                int *num_values)
 {
-    nvs_handle_t nimble_handle;
+    char key_string[NIMBLE_NVS_STR_NAME_MAX_LEN];
+    size_t obj_size;
+    size_t size;
     esp_err_t err;
 
-    err = nvs_open(NIMBLE_NVS_NAMESPACE, NVS_READWRITE, &nimble_handle);
+    get_nvs_db_key_string(obj_type, key_string);
+    obj_size = get_nvs_obj_size(obj_type);
+
+    err = nvs_get_blob(nimble_handle, key_string, NULL, &size);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "NVS open operation failed !!");
-        return BLE_HS_ESTORE_FAIL;
+        return err;
     }
 
-    err = nvs_set_blob(nimble_handle, key, value, required_size);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "NVS write operation failed !!");
-        goto error;
+    if (size % obj_size != 0 ||
+        (int)(size / obj_size) > get_nvs_max_obj_value(obj_type)) {
+        /* Written by a build with another record layout or capacity */
+        ESP_LOGE(TAG, "Discarding '%s': %d bytes", key_string, (int)size);
+        *num_values = 0;
+        return ESP_OK;
     }
 
-    /* NVS commit and close */
-    err = nvs_commit(nimble_handle);
+    err = nvs_get_blob(nimble_handle, key_string, values, &size);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "NVS commit operation failed !!");
-        goto error;
+        return err;
     }
 
-    nvs_close(nimble_handle);
-    return 0;
-error:
-    nvs_close(nimble_handle);
-    return BLE_HS_ESTORE_FAIL;
+    *num_values = size / obj_size;
+    return ESP_OK;
 }
 
-/* To write key value in NVS.
-* @Returns              0 if success
-*                       BLE_HS_ESTORE_FAIL if failure
-*                       BLE_HS_ESTORE_CAP if no space in NVS
-*/
+/* Loads the per-record blobs of older firmware into the RAM database, then
+ * replaces them with a single blob.
+ * @Returns              0 on success, -1 on NVS memory access failure
+ */
 static int
-ble_store_nvs_write(int obj_type, const union ble_store_value *val)
+ble_nvs_migrate_db(nvs_handle_t nimble_handle, int obj_type, void *values,
+                   int *num_values)
 {
     char key_string[NIMBLE_NVS_STR_NAME_MAX_LEN];
-    int8_t write_key_index = 0;
+    uint8_t *db_item = (uint8_t *)values;
+    size_t obj_size;
+    size_t size;
+    esp_err_t err;
+    int i;
 
-    write_key_index = get_nvs_db_attribute(obj_type, 1, NULL, 0);
-    if (write_key_index == -1) {
-        ESP_LOGE(TAG, "NVS operation failed !!");
-        return BLE_HS_ESTORE_FAIL;
-    } else if (write_key_index > get_nvs_max_obj_value(obj_type)) {
+    obj_size = get_nvs_obj_size(obj_type);
+    *num_values = 0;
 
-        /* bare-bone config code will take care of capacity overflow event,
-         * however another check added for consistency */
-        ESP_LOGD(TAG, "NVS size overflow.");
-        return BLE_HS_ESTORE_CAP;
-    }
+    for (i = 1; i <= get_nvs_max_obj_value(obj_type); i++) {
+        get_nvs_key_string(obj_type, i, key_string);
 
-    get_nvs_key_string(obj_type, write_key_index, key_string);
+        size = obj_size;
+        err = nvs_get_blob(nimble_handle, key_string, db_item, &size);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            continue;
+        } else if (err != ESP_OK || size != obj_size) {
+            ESP_LOGE(TAG, "NVS read operation failed !!");
+            return -1;
+        }
 
-    if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
-        return ble_nvs_write_key_value(key_string, &val->cccd, sizeof(struct
-                                       ble_store_value_cccd));
-    } else {
-        return ble_nvs_write_key_value(key_string, &val->sec, sizeof(struct
-                                       ble_store_value_sec));
+        ESP_LOGD(TAG, "Migrating '%s'", key_string);
+        db_item += obj_size;
+        (*num_values)++;
     }
-}
-
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
-/* If Host based privacy is enabled */
-static int
-ble_store_nvs_peer_records(int obj_type, const struct ble_hs_dev_records *p_dev_rec)
-{
-    char key_string[NIMBLE_NVS_STR_NAME_MAX_LEN];
-    int8_t write_key_index = 0;
 
-    write_key_index = get_nvs_db_attribute(obj_type, 1, NULL, 0);
-    if (write_key_index == -1) {
-        ESP_LOGE(TAG, "NVS operation failed !!");
-        return BLE_HS_ESTORE_FAIL;
-    } else if (write_key_index > get_nvs_max_obj_value(obj_type)) {
+    if (*num_values == 0) {
+        return 0;
+    }
 
-        /* bare-bone config code will take care of capacity overflow event,
-         * however another check added for consistency */
-        ESP_LOGD(TAG, "NVS size overflow.");
-        return BLE_HS_ESTORE_CAP;
+    if (ble_nvs_write_db(obj_type, values, *num_values) != 0) {
+        return -1;
     }
 
-    get_nvs_key_string(obj_type, write_key_index, key_string);
+    for (i = 1; i <= get_nvs_max_obj_value(obj_type); i++) {
+        get_nvs_key_string(obj_type, i, key_string);
+        nvs_erase_key(nimble_handle, key_string);
+    }
+    nvs_commit(nimble_handle);
 
-    return ble_nvs_write_key_value(key_string, p_dev_rec, sizeof(struct
-                                   ble_hs_dev_records));
+    return 0;
 }
-#endif
 
 static int
 populate_db_from_nvs(int obj_type, void *dst, int *db_num)
 {
-    uint8_t *db_item = (uint8_t *)dst;
-    union ble_store_value cur = {0};
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
-    struct ble_hs_dev_records p_dev_rec = {0};
-#endif
-
+    nvs_handle_t nimble_handle;
     esp_err_t err;
-    int i;
-    char key_string[NIMBLE_NVS_STR_NAME_MAX_LEN];
+    int rc;
 
-    for (i = 1; i <= get_nvs_max_obj_value(obj_type); i++) {
-        get_nvs_key_string(obj_type, i, key_string);
+    err = nvs_open(NIMBLE_NVS_NAMESPACE, NVS_READWRITE, &nimble_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "NVS open operation failed");
+        return -1;
+    }
 
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
-        if (obj_type != BLE_STORE_OBJ_TYPE_PEER_DEV_REC) {
-#endif
-            err = get_nvs_db_value(obj_type, key_string, &cur);
-            if (err == ESP_ERR_NVS_NOT_FOUND) {
-                continue;
-            } else if (err != ESP_OK) {
-                ESP_LOGE(TAG, "NVS read operation failed !!");
-                return -1;
-            }
-#if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
+    err = ble_nvs_read_db(nimble_handle, obj_type, dst, db_num);
+    if (err == ESP_OK) {
+        rc = 0;
+    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+        if (nvs_db_version >= NIMBLE_NVS_DB_VERSION) {
+            *db_num = 0;
+            rc = 0;
         } else {
-            err = get_nvs_peer_record(key_string, &p_dev_rec);
-            if (err == ESP_ERR_NVS_NOT_FOUND) {
-                continue;
-            } else if (err != ESP_OK) {
-                ESP_LOGE(TAG, "NVS read operation failed !!");
-                return -1;
-            }
-        }
-
-        /* NVS index has data, fill up the ram db with it */
-        if (obj_type == BLE_STORE_OBJ_TYPE_PEER_DEV_REC) {
-            ESP_LOGD(TAG, "Peer dev records filled from NVS index = %d", i);
-            memcpy(db_item, &p_dev_rec, sizeof(struct ble_hs_dev_records));
-            db_item += sizeof(struct ble_hs_dev_records);
-            (*db_num)++;
-        } else
-#endif
-        {
-            if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
-                ESP_LOGD(TAG, "CCCD in RAM is filled up from NVS index = %d", i);
-                memcpy(db_item, &cur.cccd, sizeof(struct ble_store_value_cccd));
-                db_item += sizeof(struct ble_store_value_cccd);
-                (*db_num)++;
-            } else {
-                ESP_LOGD(TAG, "KEY in RAM is filled up from NVS index = %d", i);
-                memcpy(db_item, &cur.sec, sizeof(struct ble_store_value_sec));
-                db_item += sizeof(struct ble_store_value_sec);
-                (*db_num)++;
-            }
+            rc = ble_nvs_migrate_db(nimble_handle, obj_type, dst, db_num);
         }
+    } else {
+        ESP_LOGE(TAG, "NVS read operation failed !!");
+        rc = -1;
     }
-    return 0;
+
+    nvs_close(nimble_handle);
+    return rc;
 }
 
-/* Gets the database in RAM filled up with keys stored in NVS. The sequence of
- * the keys in database may get lost.
+/* Gets the database in RAM filled up with keys stored in NVS, in the order
+ * they were stored.
  */
 static int
 ble_nvs_restore_sec_keys(void)
@@ -505,147 +356,71 @@ ble_nvs_restore_peer_records(void)
 
 int ble_store_config_persist_cccds(void)
 {
-    int nvs_count, nvs_idx;
-    union ble_store_value val;
-
-    nvs_count = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_CCCD, 0, NULL, 0);
-    if (nvs_count == -1) {
-        ESP_LOGE(TAG, "NVS operation failed while persisting CCCD");
-        return BLE_HS_ESTORE_FAIL;
-    }
-
-    if (nvs_count < ble_store_config_num_cccds) {
-
-        /* NVS db count less than RAM count, write operation */
-        ESP_LOGD(TAG, "Persisting CCCD value in NVS...");
-        val.cccd = ble_store_config_cccds[ble_store_config_num_cccds - 1];
-        return ble_store_nvs_write(BLE_STORE_OBJ_TYPE_CCCD, &val);
-    } else if (nvs_count > ble_store_config_num_cccds) {
-        /* NVS db count more than RAM count, delete operation */
-        nvs_idx = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_CCCD, 0,
-                                       ble_store_config_cccds, ble_store_config_num_cccds);
-        if (nvs_idx == -1) {
-            ESP_LOGE(TAG, "NVS delete operation failed for CCCD");
-            return BLE_HS_ESTORE_FAIL;
-        }
-        ESP_LOGD(TAG, "Deleting CCCD, nvs idx = %d", nvs_idx);
-        return ble_nvs_delete_value(BLE_STORE_OBJ_TYPE_CCCD, nvs_idx);
-    }
-    return 0;
+    ESP_LOGD(TAG, "Persisting %d CCCDs", ble_store_config_num_cccds);
+    return ble_nvs_write_db(BLE_STORE_OBJ_TYPE_CCCD, ble_store_config_cccds,
+                            ble_store_config_num_cccds);
 }
 
 int ble_store_config_persist_peer_secs(void)
 {
-    int nvs_count, nvs_idx;
-    union ble_store_value val;
-
-    nvs_count = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_PEER_SEC, 0, NULL, 0);
-    if (nvs_count == -1) {
-        ESP_LOGE(TAG, "NVS operation failed while persisting peer sec");
-        return BLE_HS_ESTORE_FAIL;
-    }
-
-    if (nvs_count < ble_store_config_num_peer_secs) {
-
-        /* NVS db count less than RAM count, write operation */
-        ESP_LOGD(TAG, "Persisting peer sec value in NVS...");
-        val.sec = ble_store_config_peer_secs[ble_store_config_num_peer_secs - 1];
-        return ble_store_nvs_write(BLE_STORE_OBJ_TYPE_PEER_SEC, &val);
-    } else if (nvs_count > ble_store_config_num_peer_secs) {
-        /* NVS db count more than RAM count, delete operation */
-        nvs_idx = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_PEER_SEC, 0,
-                                       ble_store_config_peer_secs, ble_store_config_num_peer_secs);
-        if (nvs_idx == -1) {
-            ESP_LOGE(TAG, "NVS delete operation failed for peer sec");
-            return BLE_HS_ESTORE_FAIL;
-        }
-        ESP_LOGD(TAG, "Deleting peer sec, nvs idx = %d", nvs_idx);
-        return ble_nvs_delete_value(BLE_STORE_OBJ_TYPE_PEER_SEC, nvs_idx);
-    }
-    return 0;
+    ESP_LOGD(TAG, "Persisting %d peer secs", ble_store_config_num_peer_secs);
+    return ble_nvs_write_db(BLE_STORE_OBJ_TYPE_PEER_SEC, ble_store_config_peer_secs,
+                            ble_store_config_num_peer_secs);
 }
 
 int ble_store_config_persist_our_secs(void)
 {
-    int nvs_count, nvs_idx;
-    union ble_store_value val;
-
-    nvs_count = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_OUR_SEC, 0, NULL, 0);
-    if (nvs_count == -1) {
-        ESP_LOGE(TAG, "NVS operation failed while persisting our sec");
-        return BLE_HS_ESTORE_FAIL;
-    }
-
-    if (nvs_count < ble_store_config_num_our_secs) {
-
-        /* NVS db count less than RAM count, write operation */
-        ESP_LOGD(TAG, "Persisting our sec value to NVS...");
-        val.sec = ble_store_config_our_secs[ble_store_config_num_our_secs - 1];
-        return ble_store_nvs_write(BLE_STORE_OBJ_TYPE_OUR_SEC, &val);
-    } else if (nvs_count > ble_store_config_num_our_secs) {
-        /* NVS db count more than RAM count, delete operation */
-        nvs_idx = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_OUR_SEC, 0,
-                                       ble_store_config_our_secs, ble_store_config_num_our_secs);
-        if (nvs_idx == -1) {
-            ESP_LOGE(TAG, "NVS delete operation failed for our sec");
-            return BLE_HS_ESTORE_FAIL;
-        }
-        ESP_LOGD(TAG, "Deleting our sec, nvs idx = %d", nvs_idx);
-        return ble_nvs_delete_value(BLE_STORE_OBJ_TYPE_OUR_SEC, nvs_idx);
-    }
-    return 0;
+    ESP_LOGD(TAG, "Persisting %d our secs", ble_store_config_num_our_secs);
+    return ble_nvs_write_db(BLE_STORE_OBJ_TYPE_OUR_SEC, ble_store_config_our_secs,
+                            ble_store_config_num_our_secs);
 }
 
 #if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
 int ble_store_persist_peer_records(void)
 {
-    int nvs_count, nvs_idx;
-    struct ble_hs_dev_records peer_rec;
-    int ble_store_num_peer_dev_rec = ble_rpa_get_num_peer_dev_records();
-    struct ble_hs_dev_records *peer_dev_rec = ble_rpa_get_peer_dev_records();
-
-    nvs_count = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_PEER_DEV_REC, 0, NULL, 0);
-    if (nvs_count == -1) {
-        ESP_LOGE(TAG, "NVS operation failed while persisting peer_dev_rec");
-        return BLE_HS_ESTORE_FAIL;
-    }
-
-    if (nvs_count < ble_store_num_peer_dev_rec) {
-
-        /* NVS db count less than RAM count, write operation */
-        ESP_LOGD(TAG, "Persisting peer dev record to NVS...");
-        peer_rec = peer_dev_rec[ble_store_num_peer_dev_rec - 1];
-        return ble_store_nvs_peer_records(BLE_STORE_OBJ_TYPE_PEER_DEV_REC, &peer_rec);
-    } else if (nvs_count > ble_store_num_peer_dev_rec) {
-        /* NVS db count more than RAM count, delete operation */
-        nvs_idx = get_nvs_db_attribute(BLE_STORE_OBJ_TYPE_PEER_DEV_REC, 0,
-                                       peer_dev_rec,
-                                       ble_store_num_peer_dev_rec);
-        if (nvs_idx == -1) {
-            ESP_LOGE(TAG, "NVS delete operation failed for peer records");
-            return BLE_HS_ESTORE_FAIL;
-        }
-        ESP_LOGD(TAG, "Deleting peer record, nvs idx = %d", nvs_idx);
-        return ble_nvs_delete_value(BLE_STORE_OBJ_TYPE_PEER_DEV_REC, nvs_idx);
-    }
-    return 0;
+    ESP_LOGD(TAG, "Persisting %d peer dev records", ble_rpa_get_num_peer_dev_records());
+    return ble_nvs_write_db(BLE_STORE_OBJ_TYPE_PEER_DEV_REC,
+                            ble_rpa_get_peer_dev_records(),
+                            ble_rpa_get_num_peer_dev_records());
 }
 #endif
 
 void ble_store_config_conf_init(void)
 {
+    nvs_handle_t nimble_handle;
+    int migrated = 1;
     int err;
 
+    nvs_db_version = 0;
+    err = nvs_open(NIMBLE_NVS_NAMESPACE, NVS_READWRITE, &nimble_handle);
+    if (err == ESP_OK) {
+        nvs_get_u8(nimble_handle, NIMBLE_NVS_DB_VERSION_KEY, &nvs_db_version);
+        nvs_close(nimble_handle);
+    }
+
     err = ble_nvs_restore_sec_keys();
     if (err != 0) {
         ESP_LOGE(TAG, "NVS operation failed, can't retrieve the bonding info");
+        migrated = 0;
     }
 #if MYNEWT_VAL(BLE_HOST_BASED_PRIVACY)
     err = ble_nvs_restore_peer_records();
     if (err != 0) {
         ESP_LOGE(TAG, "NVS operation failed, can't retrieve the peer records");
+        migrated = 0;
     }
 #endif
+
+    /* Later boots skip probing for per-record blobs */
+    if (migrated && nvs_db_version < NIMBLE_NVS_DB_VERSION &&
+        nvs_open(NIMBLE_NVS_NAMESPACE, NVS_READWRITE, &nimble_handle) == ESP_OK) {
+        if (nvs_set_u8(nimble_handle, NIMBLE_NVS_DB_VERSION_KEY,
+                       NIMBLE_NVS_DB_VERSION) == ESP_OK &&
+            nvs_commit(nimble_handle) == ESP_OK) {
+            nvs_db_version = NIMBLE_NVS_DB_VERSION;
+        }
+        nvs_close(nimble_handle);
+    }
 }
 
 /***************************************************************************************/
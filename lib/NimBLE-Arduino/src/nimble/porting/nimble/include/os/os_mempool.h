@@ -71,6 +71,8 @@ struct os_mempool {
     SLIST_HEAD(,os_memblock);
     /** Name for memory block */
     const char *name;
+    /** The number of gets that failed because the pool was empty */
+    uint32_t mp_num_fails;
 };
 
 /**
@@ -125,6 +127,8 @@ struct os_mempool_info {
     int omi_num_free;
     /** Minimum number of free memory blocks ever */
     int omi_min_free;
+    /** Number of failed allocations */
+    int omi_num_fails;
     /** Name of the memory pool */
     char omi_name[OS_MEMPOOL_INFO_NAME_LEN];
 };
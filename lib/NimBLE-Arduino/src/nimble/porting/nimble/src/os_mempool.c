@@ -174,6 +174,8 @@ os_mempool_init_internal(struct os_mempool *mp, uint16_t blocks,
         SLIST_NEXT(block_ptr, mb_next) = NULL;
     }
 
+    mp->mp_num_fails = 0;
+
     STAILQ_INSERT_TAIL(&g_os_mempool_list, mp, mp_list);
 
     return OS_OK;
@@ -280,6 +282,8 @@ os_mempool_clear(struct os_mempool *mp)
     /* Last one in the list should be NULL */
     SLIST_NEXT(block_ptr, mb_next) = NULL;
 
+    mp->mp_num_fails = 0;
+
     return OS_OK;
 }
 
@@ -362,6 +366,8 @@ os_memblock_get(struct os_mempool *mp)
             if (mp->mp_min_free > mp->mp_num_free) {
                 mp->mp_min_free = mp->mp_num_free;
             }
+        } else {
+            mp->mp_num_fails++;
         }
         OS_EXIT_CRITICAL(sr);
 
@@ -473,6 +479,7 @@ os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
     omi->omi_num_blocks = cur->mp_num_blocks;
     omi->omi_num_free = cur->mp_num_free;
     omi->omi_min_free = cur->mp_min_free;
+    omi->omi_num_fails = cur->mp_num_fails;
     strncpy(omi->omi_name, cur->name, sizeof(omi->omi_name) - 1);
     omi->omi_name[sizeof(omi->omi_name) - 1] = '\0';
 
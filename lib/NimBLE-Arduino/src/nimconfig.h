@@ -31,6 +31,19 @@
  */
 // #define CONFIG_NIMBLE_CPP_ATT_VALUE_INIT_LENGTH 20
 
+/** @brief Un-comment to change the number of advertised devices a scan can hold.\n
+ *  They are allocated once with the scan object; when all are in use the device\n
+ *  heard from least recently is reused for a new advertiser.\n
+ *  Default value is 64. Range: 1 : 255
+ */
+// #define CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS 64
+
+/** @brief Un-comment to change how many advertisers reused out of a full scan are\n
+ *  remembered, so the duplicate filter does not report them again (4 bytes each).\n
+ *  Default value is 512. Must be a power of 2.
+ */
+// #define CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE 512
+
 
 /****************************************************
  *         Extended advertising settings            *
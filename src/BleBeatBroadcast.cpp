@@ -0,0 +1,213 @@
+#include "BleBeatBroadcast.h"
+
+// Off by default; without it NimBLE is left out of the build
+#if ENABLE_BLE_BEAT_BROADCAST
+
+#include <NimBLEDevice.h>
+
+// Name and anchor must fit one legacy advertising PDU
+#define BEAT_NAME_LEN (sizeof(BLE_MIDI_NAME) - 1)
+#define BEAT_AD_LEN (2 + BEAT_NAME_LEN + 2 + sizeof(BleBeatAnchor))
+static_assert(BEAT_AD_LEN <= BLE_HS_ADV_MAX_SZ, "BLE_MIDI_NAME is too long for the beat scan response");
+
+// Name AD followed by the anchor AD; returns the length
+static size_t buildAdvertisingData(uint8_t *out, const BleBeatAnchor &anchor) {
+  size_t len = 0;
+  out[len++] = 1 + BEAT_NAME_LEN;
+  out[len++] = BLE_HS_ADV_TYPE_COMP_NAME;
+  memcpy(&out[len], BLE_MIDI_NAME, BEAT_NAME_LEN);
+  len += BEAT_NAME_LEN;
+  out[len++] = 1 + sizeof(anchor);
+  out[len++] = BLE_HS_ADV_TYPE_MFG_DATA;
+  memcpy(&out[len], &anchor, sizeof(anchor));
+  return len + sizeof(anchor);
+}
+
+BleBeatBroadcast::BleBeatBroadcast(MetronomeState &state, Timing &timing, WirelessSync &wirelessSync)
+  : state(state), timing(timing), wirelessSync(wirelessSync) {}
+
+bool BleBeatBroadcast::isLeader() const {
+  return !wirelessSync.isInitialized() || wirelessSync.isLeader();
+}
+
+#if CONFIG_BT_NIMBLE_ENABLE_PERIODIC_ADV
+
+// Extended advertising carries the name (and the sync info the controller
+// adds); the anchor goes in the periodic train
+void BleBeatBroadcast::begin() {
+  if (!NimBLEDevice::getInitialized()) {
+    NimBLEDevice::init(BLE_MIDI_NAME);
+  }
+
+  ble_gap_ext_adv_params params = {};
+  params.own_addr_type = BLE_OWN_ADDR_PUBLIC;
+  params.primary_phy = BLE_HCI_LE_PHY_1M;
+  params.secondary_phy = BLE_HCI_LE_PHY_1M;
+  params.itvl_min = BLE_BEAT_ADV_INTERVAL_MS * 8 / 5;   // 0.625 ms units
+  params.itvl_max = params.itvl_min;
+  params.tx_power = 127;                                // No preference
+  params.sid = BLE_BEAT_ADV_SID;
+  int rc = ble_gap_ext_adv_configure(BLE_BEAT_ADV_INSTANCE, &params, nullptr, nullptr, nullptr);
+  if (rc != 0) {
+    Serial.printf("BLE beat broadcast: extended advertising failed (%d)\n", rc);
+    return;
+  }
+
+  uint8_t name[2 + BEAT_NAME_LEN];
+  name[0] = 1 + BEAT_NAME_LEN;
+  name[1] = BLE_HS_ADV_TYPE_COMP_NAME;
+  memcpy(&name[2], BLE_MIDI_NAME, BEAT_NAME_LEN);
+  os_mbuf *data = os_msys_get_pkthdr(sizeof(name), 0);
+  if (data == nullptr || os_mbuf_append(data, name, sizeof(name)) != 0 ||
+      ble_gap_ext_adv_set_data(BLE_BEAT_ADV_INSTANCE, data) != 0) {
+    Serial.println("BLE beat broadcast: could not set advertising data");
+    return;
+  }
+
+  ble_gap_periodic_adv_params periodic = {};
+  periodic.itvl_min = BLE_BEAT_PERIODIC_INTERVAL_MS * 4 / 5;   // 1.25 ms units
+  periodic.itvl_max = periodic.itvl_min;
+  rc = ble_gap_periodic_adv_configure(BLE_BEAT_ADV_INSTANCE, &periodic);
+  if (rc != 0) {
+    Serial.printf("BLE beat broadcast: periodic advertising failed (%d)\n", rc);
+    return;
+  }
+
+  started = true;
+  Serial.printf("BLE beat broadcast: periodic advertising, SID %d\n", BLE_BEAT_ADV_SID);
+}
+
+// Periodic data goes out unchanged on every event until replaced
+bool BleBeatBroadcast::publish(const uint8_t *data, size_t len) {
+  // From the mbuf pool, not the heap; the stack frees it
+  os_mbuf *om = os_msys_get_pkthdr(len, 0);
+  if (om == nullptr) return false;
+  if (os_mbuf_append(om, data, len) != 0) {
+    os_mbuf_free_chain(om);
+    return false;
+  }
+  if (ble_gap_periodic_adv_set_data(BLE_BEAT_ADV_INSTANCE, om) != 0) return false;
+
+  if (!publishing) {
+    if (ble_gap_periodic_adv_start(BLE_BEAT_ADV_INSTANCE) != 0 ||
+        ble_gap_ext_adv_start(BLE_BEAT_ADV_INSTANCE, 0, 0) != 0) {
+      return false;
+    }
+    publishing = true;
+  }
+  return true;
+}
+
+void BleBeatBroadcast::withdraw() {
+  ble_gap_ext_adv_stop(BLE_BEAT_ADV_INSTANCE);
+  ble_gap_periodic_adv_stop(BLE_BEAT_ADV_INSTANCE);
+  publishing = false;
+}
+
+#else
+
+// Legacy advertising: one advertiser, shared with the BLE-MIDI server. The
+// anchor replaces its scan response (the name stays in it). The scan
+// response goes through NimBLEAdvertising, which keeps the last one set and
+// sets it again on every start, so a restart after a BLE-MIDI disconnect or
+// a host reset keeps the current anchor.
+static bool setScanResponse(const uint8_t *data, size_t len) {
+  NimBLEAdvertisementData response;
+  response.addData((char *)data, len);
+  return NimBLEDevice::getAdvertising()->setScanResponseData(response);
+}
+
+// Name AD only, while there is no anchor to publish
+static bool setNameScanResponse() {
+  uint8_t name[2 + BEAT_NAME_LEN];
+  name[0] = 1 + BEAT_NAME_LEN;
+  name[1] = BLE_HS_ADV_TYPE_COMP_NAME;
+  memcpy(&name[2], BLE_MIDI_NAME, BEAT_NAME_LEN);
+  return setScanResponse(name, sizeof(name));
+}
+
+void BleBeatBroadcast::begin() {
+  if (!NimBLEDevice::getInitialized()) {
+    NimBLEDevice::init(BLE_MIDI_NAME);
+  }
+
+  NimBLEAdvertising *advertising = NimBLEDevice::getAdvertising();
+  if (!advertising->isAdvertising()) {
+    // Nobody else advertises: scannable, not connectable
+    advertising->setAdvertisementType(BLE_GAP_CONN_MODE_NON);
+    advertising->setMinInterval(BLE_BEAT_ADV_INTERVAL_MS * 8 / 5);
+    advertising->setMaxInterval(BLE_BEAT_ADV_INTERVAL_MS * 8 / 5);
+  }
+  advertising->setScanResponse(true);
+  setNameScanResponse();
+
+  started = true;
+  Serial.println("BLE beat broadcast: legacy advertising (scan response)");
+}
+
+bool BleBeatBroadcast::publish(const uint8_t *data, size_t len) {
+  // Allowed while advertising; the controller keeps a copy
+  if (!setScanResponse(data, len)) return false;
+
+  // A BLE-MIDI connection stops advertising; restart it
+  NimBLEAdvertising *advertising = NimBLEDevice::getAdvertising();
+  if (!advertising->isAdvertising()) {
+    advertising->start();
+  }
+  publishing = true;
+  return true;
+}
+
+// The advertiser may belong to the BLE-MIDI server: keep it, drop the anchor
+void BleBeatBroadcast::withdraw() {
+  setNameScanResponse();
+  publishing = false;
+}
+
+#endif
+
+void BleBeatBroadcast::update() {
+  if (!started) return;
+
+  if (!isLeader()) {
+    if (publishing) withdraw();
+    return;
+  }
+
+  BleBeatAnchor anchor;
+  uint32_t beat;
+  uint32_t beatMicros;
+  timing.getBeatAnchor(beat, beatMicros);
+  anchor.flags = (state.isRunning ? BLE_BEAT_FLAG_RUNNING : 0) |
+                 (state.isPaused ? BLE_BEAT_FLAG_PAUSED : 0);
+  anchor.bpmCenti = state.bpm * 100;
+
+  // New beat, tempo or transport; otherwise refresh once a second, which
+  // also retries after an error and restarts stopped legacy advertising
+  uint32_t now = millis();
+  if (beat == lastBeat && anchor.bpmCenti == lastBpmCenti && anchor.flags == lastFlags &&
+      now - lastPublish < 1000) {
+    return;
+  }
+  lastBeat = beat;
+  lastBpmCenti = anchor.bpmCenti;
+  lastFlags = anchor.flags;
+  lastPublish = now;
+
+  anchor.companyId = BLE_BEAT_COMPANY_ID;
+  anchor.magic = BLE_BEAT_MAGIC;
+  anchor.seq = ++seq;
+  anchor.beat = beat;
+  anchor.anchorMicros = beatMicros;
+  anchor.sentMicros = micros();
+
+  uint8_t data[BEAT_AD_LEN];
+  size_t len = buildAdvertisingData(data, anchor);
+  if (publish(data, len)) {
+    updatesSent++;
+  } else {
+    updateErrors++;
+  }
+}
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+#include <Arduino.h>
+#include "MetronomeState.h"
+#include "Timing.h"
+#include "WirelessSync.h"
+#include "config.h"
+
+// Timeline anchor carried in manufacturer-specific advertising data
+// (AD type 0xFF). Multi-byte fields are little-endian.
+#define BLE_BEAT_MAGIC 0xB1
+
+#define BLE_BEAT_FLAG_RUNNING 0x01
+#define BLE_BEAT_FLAG_PAUSED 0x02
+
+struct __attribute__((packed)) BleBeatAnchor {
+  uint16_t companyId;    // BLE_BEAT_COMPANY_ID
+  uint8_t magic;         // BLE_BEAT_MAGIC (format version)
+  uint8_t seq;           // Bumped on every update
+  uint8_t flags;         // BLE_BEAT_FLAG_*
+  uint16_t bpmCenti;     // Tempo in 1/100 BPM
+  uint16_t beat;         // Quarter note number of the anchor (wraps)
+  uint32_t anchorMicros; // Leader micros() at that quarter note
+  uint32_t sentMicros;   // Leader micros() when this update was handed to the radio
+};
+
+// Connectionless beat broadcast: the sync leader publishes its timeline
+// anchor (tempo, beat number, beat time) in BLE advertising, so any number
+// of phones and receivers can follow without connecting.
+//
+// With extended advertising (CONFIG_BT_NIMBLE_ENABLE_PERIODIC_ADV, ESP32-S3
+// and C3) the anchor goes out in periodic advertising on BLE_BEAT_ADV_SID;
+// receivers sync to the train once and then get every update at a fixed
+// interval. On the original ESP32 it goes in the scan response of the
+// legacy advertiser, shared with the BLE-MIDI server when that is enabled,
+// so receivers must scan actively.
+//
+// Receivers don't share the leader's clock: the smallest (receive time -
+// sentMicros) over many updates approximates the clock offset, and beat n
+// falls at anchorMicros + offset + (n - beat) * 6000000000 / bpmCenti us.
+class BleBeatBroadcast {
+private:
+  MetronomeState &state;
+  Timing &timing;
+  WirelessSync &wirelessSync;
+
+  bool started = false;
+  bool publishing = false;
+  uint8_t seq = 0;
+  uint32_t lastBeat = 0;
+  uint16_t lastBpmCenti = 0;
+  uint8_t lastFlags = 0;
+  uint32_t lastPublish = 0;
+
+  uint32_t updatesSent = 0;
+  uint32_t updateErrors = 0;
+
+  bool isLeader() const;
+  // Hand advertising data (name and anchor ADs) to the radio
+  bool publish(const uint8_t *data, size_t len);
+  void withdraw();
+
+public:
+  BleBeatBroadcast(MetronomeState &state, Timing &timing, WirelessSync &wirelessSync);
+
+  // Set up advertising (after the BLE-MIDI server, if any)
+  void begin();
+
+  // Publish a new anchor on every beat or tempo/transport change; call from loop()
+  void update();
+
+  uint32_t getUpdatesSent() const { return updatesSent; }
+  uint32_t getUpdateErrors() const { return updateErrors; }
+};
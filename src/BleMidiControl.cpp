@@ -0,0 +1,283 @@
+#include "BleMidiControl.h"
+
+// Off by default; without it lib/BLEMidi and NimBLE are left out of the build
+#if ENABLE_BLE_MIDI
+
+#include <BLEMetronomeServer.h>
+
+static_assert((BLE_MIDI_CONTROL_QUEUE_SIZE & (BLE_MIDI_CONTROL_QUEUE_SIZE - 1)) == 0,
+              "BLE_MIDI_CONTROL_QUEUE_SIZE must be a power of two");
+static_assert((BLE_MIDI_CLOCK_QUEUE_SIZE & (BLE_MIDI_CLOCK_QUEUE_SIZE - 1)) == 0,
+              "BLE_MIDI_CLOCK_QUEUE_SIZE must be a power of two");
+
+// MIDI channels on the wire are 0-based
+#define CONTROL_CHANNEL (BLE_MIDI_CONTROL_CHANNEL - 1)
+#define STATUS_CHANNEL (BLE_MIDI_STATUS_CHANNEL - 1)
+
+BleMidiControl *BleMidiControl::instance = nullptr;
+
+BleMidiControl::BleMidiControl(MetronomeState &state, Timing &timing)
+  : state(state), timing(timing) {}
+
+void BleMidiControl::begin() {
+  instance = this;
+  BLEMetronomeServer.begin(BLE_MIDI_NAME);
+  BLEMetronomeServer.setControlChangeCallback(onControlChange);
+  BLEMetronomeServer.setOnConnectCallback(onConnected);
+  BLEMetronomeServer.setClockOutput(BLE_MIDI_CLOCK_OUTPUT);
+  timing.setClockListener(onSync24);
+  Serial.printf("BLE MIDI advertising as %s\n", BLE_MIDI_NAME);
+}
+
+// NimBLE host task: decode and queue, nothing else
+void BleMidiControl::onControlChange(uint8_t channel, uint8_t controller, uint8_t value, uint16_t timestamp) {
+  if (instance && channel == CONTROL_CHANNEL) {
+    instance->handleControlChange(controller, value);
+  }
+}
+
+void BleMidiControl::onConnected() {
+  if (instance) {
+    instance->pushCommand(PARAM_STATUS, 0, 0);
+  }
+}
+
+// uClock callback context: queue only
+void BleMidiControl::onSync24(uint32_t tick) {
+  BleMidiControl *self = instance;
+  if (!self || !BLEMetronomeServer.isClockOutput()) return;
+
+  uint32_t head = self->pulseHead.load(std::memory_order_relaxed);
+  if (head - self->pulseTail.load(std::memory_order_acquire) >= BLE_MIDI_CLOCK_QUEUE_SIZE) {
+    self->pulsesDropped++;
+    return;
+  }
+  ClockPulse &pulse = self->pulses[head & (BLE_MIDI_CLOCK_QUEUE_SIZE - 1)];
+  pulse.tick = tick;
+  pulse.micros = micros();
+  self->pulseHead.store(head + 1, std::memory_order_release);
+}
+
+void BleMidiControl::handleControlChange(uint8_t controller, uint8_t value) {
+  switch (controller) {
+    // NRPN select and data entry
+    case 99:
+      nrpnParam = (nrpnParam & 0x7F) | (value << 7);
+      return;
+    case 98:
+      nrpnParam = (nrpnParam & 0x3F80) | value;
+      return;
+    case 6:
+      nrpnMsb = value;
+      handleNrpn(nrpnParam, value << 7);
+      return;
+    case 38:
+      handleNrpn(nrpnParam, (nrpnMsb << 7) | value);
+      return;
+
+    case CC_STATUS_REQUEST:
+      pushCommand(PARAM_STATUS, 0, 0);
+      return;
+    case CC_BPM:
+      pushCommand(PARAM_BPM, 0, map(value, 0, 127, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM));
+      return;
+    case CC_MULTIPLIER:
+      pushCommand(PARAM_MULTIPLIER, 0, value * MULTIPLIER_COUNT / 128);
+      return;
+    case CC_RHYTHM_MODE:
+      pushCommand(PARAM_RHYTHM_MODE, 0, value >= 64);
+      return;
+    case CC_CLOCK_OUTPUT:
+      pushCommand(PARAM_CLOCK_OUTPUT, 0, value >= 64);
+      return;
+    case CC_TRANSPORT:
+      pushCommand(PARAM_TRANSPORT, 0, value == 0 ? 0 : (value < 64 ? 1 : 2));
+      return;
+  }
+
+  if (controller >= CC_CH_ENABLED && controller < CC_CH_ENABLED + MetronomeState::CHANNEL_COUNT) {
+    pushCommand(PARAM_CH_ENABLED, controller - CC_CH_ENABLED, value >= 64);
+  } else if (controller >= CC_CH_LENGTH && controller < CC_CH_LENGTH + MetronomeState::CHANNEL_COUNT) {
+    pushCommand(PARAM_CH_LENGTH, controller - CC_CH_LENGTH, map(value, 0, 127, 1, MAX_BEATS));
+  } else if (controller >= CC_CH_EUCLID && controller < CC_CH_EUCLID + MetronomeState::CHANNEL_COUNT) {
+    pushCommand(PARAM_CH_EUCLID, controller - CC_CH_EUCLID, map(value, 0, 127, 1, MAX_BEATS));
+  }
+}
+
+void BleMidiControl::handleNrpn(uint16_t param, uint16_t value) {
+  if (param == NRPN_BPM) {
+    pushCommand(PARAM_BPM, 0, value);
+  } else if (param == NRPN_MULTIPLIER) {
+    pushCommand(PARAM_MULTIPLIER, 0, value);
+  } else if (param == NRPN_RHYTHM_MODE) {
+    pushCommand(PARAM_RHYTHM_MODE, 0, value);
+  } else if (param >= NRPN_CH_ENABLED && param < NRPN_CH_ENABLED + MetronomeState::CHANNEL_COUNT) {
+    pushCommand(PARAM_CH_ENABLED, param - NRPN_CH_ENABLED, value != 0);
+  } else if (param >= NRPN_CH_LENGTH && param < NRPN_CH_LENGTH + MetronomeState::CHANNEL_COUNT) {
+    pushCommand(PARAM_CH_LENGTH, param - NRPN_CH_LENGTH, value);
+  } else if (param >= NRPN_CH_PATTERN && param < NRPN_CH_PATTERN + MetronomeState::CHANNEL_COUNT) {
+    pushCommand(PARAM_CH_PATTERN, param - NRPN_CH_PATTERN, value);
+  } else if (param >= NRPN_CH_EUCLID && param < NRPN_CH_EUCLID + MetronomeState::CHANNEL_COUNT) {
+    pushCommand(PARAM_CH_EUCLID, param - NRPN_CH_EUCLID, value);
+  }
+}
+
+// Single producer (NimBLE task), never blocks: a full queue drops
+void BleMidiControl::pushCommand(uint8_t param, uint8_t channel, uint16_t value) {
+  uint32_t head = commandHead.load(std::memory_order_relaxed);
+  if (head - commandTail.load(std::memory_order_acquire) >= BLE_MIDI_CONTROL_QUEUE_SIZE) {
+    commandsDropped++;
+    return;
+  }
+  Command &command = commands[head & (BLE_MIDI_CONTROL_QUEUE_SIZE - 1)];
+  command.param = param;
+  command.channel = channel;
+  command.value = value;
+  commandHead.store(head + 1, std::memory_order_release);
+}
+
+void BleMidiControl::update() {
+  uint32_t tail = commandTail.load(std::memory_order_relaxed);
+  while (tail != commandHead.load(std::memory_order_acquire)) {
+    Command command = commands[tail & (BLE_MIDI_CONTROL_QUEUE_SIZE - 1)];
+    commandTail.store(++tail, std::memory_order_release);
+    applyCommand(command);
+    commandsApplied++;
+  }
+
+  // Transport before clock, so Continue/Stop precede the pulses after them
+  updateTransport();
+  sendClock();
+}
+
+void BleMidiControl::applyCommand(const Command &command) {
+  switch (command.param) {
+    case PARAM_STATUS:
+      sendStatus();
+      break;
+
+    case PARAM_BPM:
+      if (command.value < MIN_GLOBAL_BPM || command.value > MAX_GLOBAL_BPM) return;
+      state.bpm = command.value;
+      timing.setTempo(state.bpm);
+      sendStatusCC(CC_BPM, map(state.bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM, 0, 127));
+      break;
+
+    case PARAM_MULTIPLIER:
+      if (command.value >= MULTIPLIER_COUNT) return;
+      state.currentMultiplierIndex = command.value;
+      sendStatusCC(CC_MULTIPLIER, state.currentMultiplierIndex * 128 / MULTIPLIER_COUNT);
+      break;
+
+    case PARAM_RHYTHM_MODE:
+      state.rhythmMode = command.value ? POLYRHYTHM : POLYMETER;
+      sendStatusCC(CC_RHYTHM_MODE, command.value ? 127 : 0);
+      break;
+
+    case PARAM_CLOCK_OUTPUT:
+      if (!command.value && clockRunning) {
+        BLEMetronomeServer.clockStop(micros());
+        clockRunning = false;
+      }
+      BLEMetronomeServer.setClockOutput(command.value != 0);
+      sendStatusCC(CC_CLOCK_OUTPUT, command.value ? 127 : 0);
+      break;
+
+    case PARAM_TRANSPORT:
+      if (command.value == 2) {
+        timing.play();
+      } else if (command.value == 1) {
+        timing.pausePlayback();
+      } else {
+        timing.stopPlayback();
+      }
+      break;
+
+    case PARAM_CH_ENABLED: {
+      MetronomeChannel &channel = state.getChannel(command.channel);
+      if (channel.isEnabled() != (command.value != 0)) {
+        channel.toggleEnabled();
+      }
+      sendStatusCC(CC_CH_ENABLED + command.channel, channel.isEnabled() ? 127 : 0);
+      break;
+    }
+
+    case PARAM_CH_LENGTH: {
+      if (command.value < 1 || command.value > MAX_BEATS) return;
+      MetronomeChannel &channel = state.getChannel(command.channel);
+      channel.setBarLength(command.value);
+      channel.setPattern(channel.getPattern() & channel.getMaxPattern());
+      sendStatusCC(CC_CH_LENGTH + command.channel, map(command.value, 1, MAX_BEATS, 0, 127));
+      break;
+    }
+
+    case PARAM_CH_PATTERN: {
+      MetronomeChannel &channel = state.getChannel(command.channel);
+      channel.setPattern(command.value & channel.getMaxPattern());
+      break;
+    }
+
+    case PARAM_CH_EUCLID:
+      state.getChannel(command.channel).generateEuclidean(command.value);
+      break;
+  }
+}
+
+// Follow transport changes from any source (encoder, OSC, serial, BLE)
+void BleMidiControl::updateTransport() {
+  bool running = state.isRunning;
+  bool paused = state.isPaused;
+  if (running == wasRunning && paused == wasPaused) return;
+
+  uint32_t now = micros();
+  if (clockRunning) {
+    if (!running && wasRunning) {
+      BLEMetronomeServer.clockStop(now);
+    } else if (running && wasPaused) {
+      BLEMetronomeServer.clockContinue(now);
+    }
+  }
+  // Stopped (not paused): the next pulse starts over with Start
+  if (!running && !paused) {
+    clockRunning = false;
+  }
+  wasRunning = running;
+  wasPaused = paused;
+}
+
+void BleMidiControl::sendClock() {
+  uint32_t tail = pulseTail.load(std::memory_order_relaxed);
+  while (tail != pulseHead.load(std::memory_order_acquire)) {
+    ClockPulse pulse = pulses[tail & (BLE_MIDI_CLOCK_QUEUE_SIZE - 1)];
+    pulseTail.store(++tail, std::memory_order_release);
+
+    // uClock restarts its tick count on start
+    if (pulse.tick == 0 || !clockRunning) {
+      BLEMetronomeServer.songPosition(0, pulse.micros);
+      BLEMetronomeServer.clockStart(pulse.micros);
+      clockRunning = true;
+    }
+    BLEMetronomeServer.clockTick(pulse.micros);
+  }
+}
+
+void BleMidiControl::sendStatus() {
+  sendStatusCC(CC_BPM, map(state.bpm, MIN_GLOBAL_BPM, MAX_GLOBAL_BPM, 0, 127));
+  sendStatusCC(CC_MULTIPLIER, state.currentMultiplierIndex * 128 / MULTIPLIER_COUNT);
+  sendStatusCC(CC_RHYTHM_MODE, state.isPolyrhythm() ? 127 : 0);
+  sendStatusCC(CC_CLOCK_OUTPUT, BLEMetronomeServer.isClockOutput() ? 127 : 0);
+  for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
+    const MetronomeChannel &channel = state.getChannel(i);
+    sendStatusCC(CC_CH_ENABLED + i, channel.isEnabled() ? 127 : 0);
+    sendStatusCC(CC_CH_LENGTH + i, map(channel.getBarLength(), 1, MAX_BEATS, 0, 127));
+  }
+}
+
+// Batched by ProtocolMidi into one notification per connection interval
+void BleMidiControl::sendStatusCC(uint8_t controller, uint8_t value) {
+  if (BLEMetronomeServer.isConnected()) {
+    BLEMetronomeServer.controlChange(STATUS_CHANNEL, controller, value);
+  }
+}
+
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "MetronomeState.h"
+#include "Timing.h"
+#include "config.h"
+
+// BLE-MIDI control surface and clock output (lib/BLEMidi).
+//
+// Controllers change the metronome with CCs on BLE_MIDI_CONTROL_CHANNEL, or
+// with NRPN for full-resolution values. The NimBLE host task only decodes
+// and queues; commands are applied from loop() like every other control
+// path, so controller traffic never reaches the uClock callbacks. Changes
+// are echoed as CCs on BLE_MIDI_STATUS_CHANNEL.
+//
+// With clock output on, every uClock Sync24 pulse is queued with its
+// micros() and sent as MIDI clock stamped with that time; Start goes with
+// the first pulse after a start, Continue and Stop follow transport.
+class BleMidiControl {
+public:
+  // CCs on the control channel (values 0-127, scaled to the parameter)
+  enum ControlCC : uint8_t {
+    CC_STATUS_REQUEST = 1,   // Any value: echo all parameters
+    CC_BPM = 2,              // MIN_GLOBAL_BPM..MAX_GLOBAL_BPM
+    CC_MULTIPLIER = 3,       // Multiplier index
+    CC_RHYTHM_MODE = 4,      // < 64 polymeter, >= 64 polyrhythm
+    CC_CLOCK_OUTPUT = 5,     // >= 64 on
+    CC_TRANSPORT = 9,        // 0 stop, 1-63 pause, 64-127 play
+    CC_CH_ENABLED = 16,      // + channel, >= 64 on
+    CC_CH_LENGTH = 20,       // + channel, 1..MAX_BEATS
+    CC_CH_EUCLID = 24        // + channel, active beats 1..bar length
+  };
+
+  // NRPN parameters (CC 99/98 select, CC 6/38 data entry, 14 bit values)
+  enum ControlNrpn : uint16_t {
+    NRPN_BPM = 0,            // BPM, exact
+    NRPN_MULTIPLIER = 1,
+    NRPN_RHYTHM_MODE = 2,
+    NRPN_CH_ENABLED = 16,    // + channel
+    NRPN_CH_LENGTH = 32,     // + channel
+    NRPN_CH_PATTERN = 48,    // + channel, accent mask (beats 2-15)
+    NRPN_CH_EUCLID = 64      // + channel
+  };
+
+private:
+  // Parameter changes decoded in the NimBLE task
+  enum Param : uint8_t {
+    PARAM_STATUS,
+    PARAM_BPM,
+    PARAM_MULTIPLIER,
+    PARAM_RHYTHM_MODE,
+    PARAM_CLOCK_OUTPUT,
+    PARAM_TRANSPORT,
+    PARAM_CH_ENABLED,
+    PARAM_CH_LENGTH,
+    PARAM_CH_PATTERN,
+    PARAM_CH_EUCLID
+  };
+
+  struct Command {
+    uint8_t param;
+    uint8_t channel;
+    uint16_t value;
+  };
+
+  struct ClockPulse {
+    uint32_t tick;
+    uint32_t micros;
+  };
+
+  static BleMidiControl *instance;
+
+  MetronomeState &state;
+  Timing &timing;
+
+  // NimBLE task -> loop
+  Command commands[BLE_MIDI_CONTROL_QUEUE_SIZE];
+  std::atomic<uint32_t> commandHead{0};
+  std::atomic<uint32_t> commandTail{0};
+
+  // uClock -> loop
+  ClockPulse pulses[BLE_MIDI_CLOCK_QUEUE_SIZE];
+  std::atomic<uint32_t> pulseHead{0};
+  std::atomic<uint32_t> pulseTail{0};
+
+  // NRPN state (NimBLE task only)
+  uint16_t nrpnParam = 0x3FFF;
+  uint8_t nrpnMsb = 0;
+
+  bool wasRunning = false;
+  bool wasPaused = false;
+  bool clockRunning = false;
+
+  // Statistics
+  std::atomic<uint32_t> commandsDropped{0};
+  std::atomic<uint32_t> pulsesDropped{0};
+  uint32_t commandsApplied = 0;
+
+  static void onControlChange(uint8_t channel, uint8_t controller, uint8_t value, uint16_t timestamp);
+  static void onSync24(uint32_t tick);
+  static void onConnected();
+
+  void handleControlChange(uint8_t controller, uint8_t value);
+  void handleNrpn(uint16_t param, uint16_t value);
+  void pushCommand(uint8_t param, uint8_t channel, uint16_t value);
+  void applyCommand(const Command &command);
+  void updateTransport();
+  void sendClock();
+  void sendStatus();
+  void sendStatusCC(uint8_t controller, uint8_t value);
+
+public:
+  BleMidiControl(MetronomeState &state, Timing &timing);
+
+  // Start the BLE-MIDI server and listen for Sync24 pulses
+  void begin();
+
+  // Apply queued commands and send clock; call from loop()
+  void update();
+
+  uint32_t getCommandsApplied() const { return commandsApplied; }
+  uint32_t getCommandsDropped() const { return commandsDropped; }
+  uint32_t getPulsesDropped() const { return pulsesDropped; }
+};
@@ -98,6 +98,16 @@ public:
     return true;
   }
   
+  // Sync group ID; stored apart from the versioned configuration so that
+  // a configuration version change keeps the device in its group
+  static void saveGroupID(uint16_t groupID) {
+    prefs.putUShort("syncGroup", groupID);
+  }
+  
+  static uint16_t loadGroupID() {
+    return prefs.getUShort("syncGroup", SYNC_GROUP_ID);
+  }
+  
   // Clear all stored configuration (reset to factory defaults)
   static bool clearConfig() {
     return prefs.clear();
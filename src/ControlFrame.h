@@ -0,0 +1,264 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "SyncFrame.h"
+
+// Binary control and telemetry frames on the serial console, for test rigs.
+// No Arduino dependencies so host tools can build and share it.
+//
+//   0x00 [COBS( type | seq | payload ... | crc16 hi | crc16 lo )] 0x00
+//
+// COBS removes every 0x00 from the frame, and console text never contains
+// 0x00, so binary frames and text commands share one port. The CRC
+// (CRC-16/CCITT, init 0xFFFF, same as SyncFrame) covers type, seq and
+// payload. Multi-byte payload fields are little-endian.
+
+#define CONTROL_FRAME_MAX_PAYLOAD 64
+#define CONTROL_FRAME_MAX_DECODED (CONTROL_FRAME_MAX_PAYLOAD + 4)
+// COBS adds one byte per 254 plus one; two delimiters
+#define CONTROL_FRAME_MAX_ENCODED (CONTROL_FRAME_MAX_DECODED + CONTROL_FRAME_MAX_DECODED / 254 + 3)
+
+enum ControlFrameType : uint8_t {
+  // Host -> device; every command is answered by CTRL_ACK with its seq
+  CTRL_PING = 0x01,            // (no payload)
+  CTRL_SET_BPM = 0x02,         // CtrlSetBpm
+  CTRL_TRANSPORT = 0x03,       // CtrlTransport
+  CTRL_SET_PATTERN = 0x04,     // CtrlSetPattern
+  CTRL_SET_ENABLED = 0x05,     // CtrlSetEnabled
+  CTRL_SET_MULTIPLIER = 0x06,  // CtrlSetValue (multiplier index)
+  CTRL_SET_MODE = 0x07,        // CtrlSetValue (0 polymeter, 1 polyrhythm)
+  CTRL_SUBSCRIBE = 0x08,       // CtrlSetValue (CTRL_EVENTS_* mask)
+  CTRL_ASSIGN_CHANNELS = 0x09, // CtrlAssignChannels (sync leader only)
+  CTRL_CLEAR_ASSIGNMENTS = 0x0A, // (no payload; sync leader only)
+  CTRL_SET_GROUP = 0x0B,       // CtrlSetGroup (stored in flash)
+  CTRL_GET_SYNC_STATUS = 0x0C, // (no payload), answered by CTRL_SYNC_STATUS
+  CTRL_SEND_LAYOUT = 0x0D,     // CtrlSendLayout + CtrlLayoutSegment[count] (sync leader only)
+
+  // Device -> host
+  CTRL_ACK = 0x80,             // CtrlAck
+  CTRL_SYNC_STATUS = 0x81,     // CtrlSyncStatus, sent before the ack
+  CTRL_EVENT_BEAT = 0x90,      // CtrlBeatEvent
+  CTRL_EVENT_TRACE = 0x91      // TraceRecord[] (see Trace.h)
+};
+
+enum ControlStatus : uint8_t {
+  CTRL_OK = 0,
+  CTRL_ERR_TYPE = 1,     // Unknown command
+  CTRL_ERR_LENGTH = 2,   // Payload size doesn't match the command
+  CTRL_ERR_VALUE = 3,    // Value out of range
+  CTRL_ERR_STATE = 4     // Not possible right now (e.g. not the sync leader)
+};
+
+enum ControlTransportAction : uint8_t {
+  CTRL_PLAY = 0,
+  CTRL_PAUSE = 1,
+  CTRL_STOP = 2
+};
+
+#define CTRL_EVENTS_BEAT 0x01
+
+struct __attribute__((packed)) CtrlSetBpm {
+  uint16_t bpm;
+};
+
+struct __attribute__((packed)) CtrlTransport {
+  uint8_t action;        // ControlTransportAction
+};
+
+struct __attribute__((packed)) CtrlSetPattern {
+  uint8_t channel;
+  uint8_t length;        // Bar length in beats
+  uint16_t pattern;      // Accent bit mask
+};
+
+struct __attribute__((packed)) CtrlSetEnabled {
+  uint8_t channel;
+  uint8_t enabled;
+};
+
+struct __attribute__((packed)) CtrlSetValue {
+  uint8_t value;
+};
+
+struct __attribute__((packed)) CtrlAssignChannels {
+  uint8_t device[6];     // MAC address of the follower
+  uint16_t channelMask;  // Channels it plays (bit n = channel n)
+};
+
+struct __attribute__((packed)) CtrlSendLayout {
+  uint16_t layoutID;     // Layout version; bump it for every new layout
+  uint8_t count;         // Segments that follow (1-8)
+};
+
+struct __attribute__((packed)) CtrlLayoutSegment {
+  uint16_t start;        // First LED
+  uint16_t length;       // Number of LEDs
+  uint8_t channel;       // Channel shown, or 0xFF for the tempo
+  uint8_t flags;         // Bit 0: reversed
+};
+
+struct __attribute__((packed)) CtrlSetGroup {
+  uint16_t groupID;      // Above SYNC_GROUP_RESERVED_MAX (0x00FF)
+};
+
+struct __attribute__((packed)) CtrlSyncStatus {
+  uint16_t groupID;
+  uint8_t isLeader;
+  uint16_t channelMask;  // Channels this device plays
+  uint32_t foreignFrames; // Frames dropped for another group
+  uint32_t legacyFrames; // Frames dropped for having no group ID
+};
+
+struct __attribute__((packed)) CtrlAck {
+  uint8_t command;       // Type of the acknowledged command
+  uint8_t status;        // ControlStatus
+  uint32_t deviceMicros; // micros() when the command was applied
+};
+
+struct __attribute__((packed)) CtrlBeatEvent {
+  uint8_t channel;
+  uint8_t beatState;     // BeatState
+  uint32_t deviceMicros; // micros() at the beat
+  uint32_t dropped;      // Events lost so far to a full queue or TX buffer
+};
+
+// COBS-encode len bytes; out must hold len + len / 254 + 1 bytes.
+// Returns the encoded size (without delimiters).
+inline size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out) {
+  size_t codePos = 0;
+  size_t outPos = 1;
+  uint8_t code = 1;
+
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] != 0) {
+      out[outPos++] = in[i];
+      code++;
+    }
+    if (in[i] == 0 || code == 0xFF) {
+      out[codePos] = code;
+      codePos = outPos++;
+      code = 1;
+    }
+  }
+  out[codePos] = code;
+  return outPos;
+}
+
+// Decode a COBS block (without delimiters). Returns the decoded size, or 0
+// if the block is malformed or doesn't fit in outMax bytes.
+inline size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t outMax) {
+  size_t inPos = 0;
+  size_t outPos = 0;
+
+  while (inPos < len) {
+    uint8_t code = in[inPos++];
+    if (code == 0 || inPos + code - 1 > len) return 0;
+
+    for (uint8_t i = 1; i < code; i++) {
+      if (outPos >= outMax) return 0;
+      out[outPos++] = in[inPos++];
+    }
+    if (code != 0xFF && inPos < len) {
+      if (outPos >= outMax) return 0;
+      out[outPos++] = 0;
+    }
+  }
+  return outPos;
+}
+
+// Build a delimited frame into out (CONTROL_FRAME_MAX_ENCODED bytes).
+// Returns the frame size, or 0 if the payload is too large.
+inline size_t controlFrameEncode(uint8_t type, uint8_t seq, const void *payload, size_t len,
+                                 uint8_t *out) {
+  if (len > CONTROL_FRAME_MAX_PAYLOAD) return 0;
+
+  uint8_t raw[CONTROL_FRAME_MAX_DECODED];
+  raw[0] = type;
+  raw[1] = seq;
+  memcpy(&raw[2], payload, len);
+  uint16_t crc = syncFrameCrc16(0xFFFF, raw, len + 2);
+  raw[len + 2] = crc >> 8;
+  raw[len + 3] = crc & 0xFF;
+
+  out[0] = 0;
+  size_t size = cobsEncode(raw, len + 4, &out[1]);
+  out[size + 1] = 0;
+  return size + 2;
+}
+
+// Splits a byte stream into console text and binary frames. A 0x00 opens a
+// frame and the next 0x00 closes it; everything else is text.
+class ControlFrameReader {
+public:
+  enum Result {
+    TEXT,         // Byte belongs to the text console
+    CONSUMED,     // Byte was part of a frame
+    FRAME_READY   // A complete, CRC-valid frame is available
+  };
+
+private:
+  uint8_t _encoded[CONTROL_FRAME_MAX_ENCODED];
+  uint8_t _decoded[CONTROL_FRAME_MAX_DECODED];
+  size_t _encodedLen = 0;
+  size_t _decodedLen = 0;
+  bool _inFrame = false;
+  bool _overflow = false;
+  uint32_t _crcErrors = 0;
+  uint32_t _framingErrors = 0;
+
+public:
+  Result feed(uint8_t b) {
+    if (b != 0) {
+      if (!_inFrame) return TEXT;
+      if (_encodedLen < sizeof(_encoded)) {
+        _encoded[_encodedLen++] = b;
+      } else {
+        _overflow = true;
+      }
+      return CONSUMED;
+    }
+
+    if (!_inFrame) {
+      _inFrame = true;
+      _encodedLen = 0;
+      _overflow = false;
+      return CONSUMED;
+    }
+
+    // Closing delimiter
+    _inFrame = false;
+    if (_encodedLen == 0) {
+      // Two delimiters in a row: treat the second as an opening one so a
+      // lost byte doesn't shift every following frame
+      _inFrame = true;
+      return CONSUMED;
+    }
+
+    _decodedLen = _overflow ? 0 : cobsDecode(_encoded, _encodedLen, _decoded, sizeof(_decoded));
+    if (_decodedLen < 4) {
+      _framingErrors++;
+      return CONSUMED;
+    }
+    uint16_t crc = syncFrameCrc16(0xFFFF, _decoded, _decodedLen - 2);
+    if (crc != (((uint16_t)_decoded[_decodedLen - 2] << 8) | _decoded[_decodedLen - 1])) {
+      _crcErrors++;
+      return CONSUMED;
+    }
+    return FRAME_READY;
+  }
+
+  // Give up on a partial frame (e.g. after a receive timeout)
+  void reset() {
+    _inFrame = false;
+    _encodedLen = 0;
+  }
+
+  bool inFrame() const { return _inFrame; }
+  uint8_t type() const { return _decoded[0]; }
+  uint8_t seq() const { return _decoded[1]; }
+  const uint8_t *payload() const { return &_decoded[2]; }
+  size_t payloadLength() const { return _decodedLen - 4; }
+  uint32_t crcErrors() const { return _crcErrors; }
+  uint32_t framingErrors() const { return _framingErrors; }
+};
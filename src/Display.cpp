@@ -1,12 +1,12 @@
 #include "Display.h"
 #include "config.h"
+#include "Trace.h"
 
 // Initialize static member
 Display *Display::_instance = nullptr;
 
-Display::Display()
+Display::Display() : display(U8G2_R0, U8X8_PIN_NONE)
 {
-    display = new U8G2_SH1106_128X64_NONAME_F_HW_I2C(U8G2_R0, U8X8_PIN_NONE);
     _instance = this;
     animationRunning = false;
 }
@@ -14,17 +14,17 @@ Display::Display()
 Display::~Display()
 {
     stopAnimation();
-    if (_instance == this)
+    if (animationTimer)
     {
-        _instance = nullptr;
+        esp_timer_delete(animationTimer);
     }
-    if (display)
+    if (_instance == this)
     {
-        delete display;
+        _instance = nullptr;
     }
 }
 
-void Display::animationTickerCallback()
+void Display::animationTimerCallback(void *arg)
 {
     if (_instance)
     {
@@ -34,43 +34,56 @@ void Display::animationTickerCallback()
 
 void Display::begin()
 {
-    display->begin();
-    display->setFont(u8g2_font_t0_11_tr);
+    display.begin();
+    display.setFont(u8g2_font_t0_11_tr);
+
+    // Created once here; start/stop later don't touch the heap
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = animationTimerCallback;
+    timerArgs.name = "display_anim";
+    esp_timer_create(&timerArgs, &animationTimer);
 }
 
 void Display::startAnimation()
 {
-    animationTicker.detach();
+    if (!animationTimer)
+        return;
+    esp_timer_stop(animationTimer);
     animationTick = 0;
     // Update animation at 20ms intervals (50Hz)
-    animationTicker.attach(0.02, animationTickerCallback);
+    esp_timer_start_periodic(animationTimer, 20000);
     animationRunning = true;
 }
 
 void Display::stopAnimation()
 {
-    animationTicker.detach();
+    if (animationTimer)
+        esp_timer_stop(animationTimer);
     animationRunning = false;
 }
 
 void Display::update(const MetronomeState &state)
 {
-    display->clearBuffer();
+#if ENABLE_TRACE
+    uint32_t frameStart = micros();
+#endif
+    display.clearBuffer();
 
-    display->drawFrame(0, 0, 128, 64);
+    display.drawFrame(0, 0, 128, 64);
 
     drawGlobalRow(state);
     drawGlobalProgress(state);
 
-    display->drawHLine(1, 17, 126);
+    display.drawHLine(1, 17, 126);
 
     drawChannelBlock(state, 0, 19);
 
-    display->drawHLine(1, 40, 126);
+    display.drawHLine(1, 40, 126);
 
     drawChannelBlock(state, 1, 42);
 
-    display->sendBuffer();
+    display.sendBuffer();
+    TRACE(TRACE_FRAME, 0, micros() - frameStart);
 }
 
 void Display::drawGlobalRow(const MetronomeState &state)
@@ -87,14 +100,14 @@ void Display::drawGlobalRow(const MetronomeState &state)
 
         if (animTime < flashDuration)
         {
-            display->drawBox(1, 1, 4, 12);
+            display.drawBox(1, 1, 4, 12);
         }
     }
     else if (state.isPaused)
     {
         // Show pause indicator (two vertical bars)
-        display->drawBox(3, 3, 1, 8);
-        display->drawBox(6, 3, 1, 8);
+        display.drawBox(3, 3, 1, 8);
+        display.drawBox(6, 3, 1, 8);
     }
 
     // BPM display with selection frame
@@ -102,39 +115,39 @@ void Display::drawGlobalRow(const MetronomeState &state)
     
     if (state.isBpmSelected())
     {
-        display->drawFrame(7, 1, 45, 12);
+        display.drawFrame(7, 1, 45, 12);
         if (state.isEditing)
         {
-            display->drawBox(7, 1, 45, 12);
-            display->setDrawColor(0);
+            display.drawBox(7, 1, 45, 12);
+            display.setDrawColor(0);
         }
     }
-    display->drawStr(9, 11, buffer);
-    display->setDrawColor(1);
+    display.drawStr(9, 11, buffer);
+    display.setDrawColor(1);
 
     // Multiplier display
     sprintf(buffer, "x%s", state.getCurrentMultiplierName());
     
     if (state.isMultiplierSelected())
     {
-        display->drawFrame(55, 1, 16, 12);
+        display.drawFrame(55, 1, 16, 12);
         if (state.isEditing)
         {
-            display->drawBox(55, 1, 16, 12);
-            display->setDrawColor(0);
+            display.drawBox(55, 1, 16, 12);
+            display.setDrawColor(0);
         }
     }
-    display->drawStr(57, 11, buffer);
-    display->setDrawColor(1);
+    display.drawStr(57, 11, buffer);
+    display.setDrawColor(1);
     
     // Rhythm mode toggle (+ for polymeter, ÷ for polyrhythm)
     if (state.isRhythmModeSelected())
     {
-        display->drawFrame(74, 1, 14, 12);
+        display.drawFrame(74, 1, 14, 12);
         if (state.isEditing)
         {
-            display->drawBox(74, 1, 14, 12);
-            display->setDrawColor(0);
+            display.drawBox(74, 1, 14, 12);
+            display.setDrawColor(0);
         }
     }
     
@@ -142,23 +155,23 @@ void Display::drawGlobalRow(const MetronomeState &state)
     if (state.isPolyrhythm()) {
         // Draw division symbol (÷) with primitives
         // Horizontal line
-        display->drawHLine(76, 6, 10);
+        display.drawHLine(76, 6, 10);
         // Top dot
-        display->drawDisc(80, 3, 1);
+        display.drawDisc(80, 3, 1);
         // Bottom dot
-        display->drawDisc(80, 9, 1);
+        display.drawDisc(80, 9, 1);
     } else {
         // Draw plus symbol (+)
-        display->drawStr(77, 11, "+");
+        display.drawStr(77, 11, "+");
     }
-    display->setDrawColor(1);
+    display.setDrawColor(1);
 
     // Beat counter on the right
     uint32_t totalBeats = state.getTotalBeats();
     float currentPosition = float(state.globalTick % totalBeats) + state.tickFraction;
     uint32_t currentBeat = uint32_t(currentPosition) + 1; // Add 1 for 1-based counting
     sprintf(buffer, "%lu/%lu", currentBeat, totalBeats);
-    display->drawStr(92, 11, buffer);
+    display.drawStr(92, 11, buffer);
 }
 
 void Display::drawGlobalProgress(const MetronomeState &state)
@@ -177,11 +190,11 @@ void Display::drawGlobalProgress(const MetronomeState &state)
         // Draw dashed progress bar when paused
         for (uint8_t x = 1; x < width; x += 4) {
             uint8_t dashWidth = (2 < (width - x)) ? 2 : (width - x);
-            display->drawBox(x, 14, dashWidth, 2);
+            display.drawBox(x, 14, dashWidth, 2);
         }
     } else {
         // Draw solid progress bar when running
-        display->drawBox(1, 14, width, 2);
+        display.drawBox(1, 14, width, 2);
     }
 }
 
@@ -241,7 +254,7 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
             
             if (animTime < flashDuration)
             {
-                display->drawBox(1, y - 1, 4, 12); // Only the height of the upper row
+                display.drawBox(1, y - 1, 4, 12); // Only the height of the upper row
             }
         }
     }
@@ -250,21 +263,21 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
     bool isToggleSelected = state.isToggleSelected(channelIndex);
     if (isToggleSelected)
     {
-        display->drawFrame(7, y - 1, 16, 12);
+        display.drawFrame(7, y - 1, 16, 12);
         if (state.isEditing)
         {
-            display->drawBox(7, y - 1, 16, 12);
-            display->setDrawColor(0);
+            display.drawBox(7, y - 1, 16, 12);
+            display.setDrawColor(0);
         }
     }
     
     // Draw toggle circle
     if (channel.isEnabled()) {
-        display->drawDisc(14, y + 5, 3); // Filled circle when enabled
+        display.drawDisc(14, y + 5, 3); // Filled circle when enabled
     } else {
-        display->drawCircle(14, y + 5, 3); // Empty circle when disabled
+        display.drawCircle(14, y + 5, 3); // Empty circle when disabled
     }
-    display->setDrawColor(1);
+    display.setDrawColor(1);
 
     // Length row
     sprintf(buffer, "%02d", channel.getBarLength());
@@ -273,23 +286,23 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
     // Box for length (shifted right to make room for toggle)
     if (isLengthSelected)
     {
-        display->drawFrame(25, y - 1, 16, 12);
+        display.drawFrame(25, y - 1, 16, 12);
         if (state.isEditing)
         {
-            display->drawBox(25, y - 1, 16, 12);
-            display->setDrawColor(0);
+            display.drawBox(25, y - 1, 16, 12);
+            display.setDrawColor(0);
         }
     }
 
     // Draw length text
-    display->drawStr(27, y + 8, buffer);
-    display->setDrawColor(1);
+    display.drawStr(27, y + 8, buffer);
+    display.setDrawColor(1);
 
     // Add pattern counter (current/total)
     uint16_t currentPattern = channel.getPattern() + 1;
     uint16_t maxPattern = channel.getMaxPattern() + 1;
     sprintf(buffer, "%u/%u", currentPattern, maxPattern);
-    display->drawStr(91, y + 8, buffer);
+    display.drawStr(91, y + 8, buffer);
 
     // Pattern row
     uint8_t patternY = y + 11;
@@ -297,14 +310,14 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
 
     if (isPatternSelected)
     {
-        display->drawFrame(1, patternY, 126, 10);
+        display.drawFrame(1, patternY, 126, 10);
         if (state.isEditing)
         {
-            display->drawBox(1, patternY, 126, 10);
-            display->setDrawColor(0);
+            display.drawBox(1, patternY, 126, 10);
+            display.setDrawColor(0);
         }
     }
-    display->drawHLine(1, patternY, 126);
+    display.drawHLine(1, patternY, 126);
     
     // Get max length for visualization, depends on rhythm mode
     uint8_t maxLength;
@@ -320,7 +333,7 @@ void Display::drawChannelBlock(const MetronomeState &state, uint8_t channelIndex
     }
     
     drawBeatGrid(2, patternY + 1, channel, maxLength, state.isPolyrhythm(), state);
-    display->setDrawColor(1);
+    display.setDrawColor(1);
 }
 
 void Display::drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, uint8_t maxLength, bool isPolyrhythm, const MetronomeState &state)
@@ -392,14 +405,14 @@ void Display::drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, uin
         // Draw edit frame if needed
         if (ch.isEditing() && i == ch.getEditStep())
         {
-            display->drawFrame(cellX, y, cellWidth - 1, 8);
+            display.drawFrame(cellX, y, cellWidth - 1, 8);
         }
 
         // Draw vertical grid lines
-        display->drawVLine(cellX - 1, y, 10);
+        display.drawVLine(cellX - 1, y, 10);
 
         if (i == drawLength - 1) {
-            display->drawVLine(cellX + cellWidth - 1, y, 10); // Closing vertical line for the last beat
+            display.drawVLine(cellX + cellWidth - 1, y, 10); // Closing vertical line for the last beat
         }
 
         // Draw beat indicators
@@ -408,12 +421,12 @@ void Display::drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, uin
             if (isCurrentBeat && ch.isEnabled())
             {
                 // Filled box for active current beat
-                display->drawBox(cellX + 1, y + 1, cellWidth - 3, 7);
+                display.drawBox(cellX + 1, y + 1, cellWidth - 3, 7);
             }
             else
             {
                 // Circle for active non-current beat
-                display->drawDisc(cellX + cellWidth / 2 - 1, y + 4, 2);
+                display.drawDisc(cellX + cellWidth / 2 - 1, y + 4, 2);
             }
         }
         else if (isCurrentBeat && ch.isEnabled())
@@ -421,12 +434,12 @@ void Display::drawBeatGrid(uint8_t x, uint8_t y, const MetronomeChannel &ch, uin
             // Pulsing dot for silent active beat
             float pulse = (millis() % 500) / 500.0f; // 0.0 to 1.0 over 500ms
             uint8_t radius = 1 + uint8_t(pulse);
-            display->drawDisc(cellX + cellWidth / 2 - 1, y + 4, radius);
+            display.drawDisc(cellX + cellWidth / 2 - 1, y + 4, radius);
         }
         else
         {
             // Simple pixel for inactive beat
-            display->drawPixel(cellX + cellWidth / 2 - 1, y + 4);
+            display.drawPixel(cellX + cellWidth / 2 - 1, y + 4);
         }
     }
 }
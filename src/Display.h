@@ -1,21 +1,21 @@
 #pragma once
 #include <U8g2lib.h>
-#include <Ticker.h>
+#include <esp_timer.h>
 #include "MetronomeState.h"
 #include "MetronomeChannel.h"
 
 class Display
 {
 private:
-    U8G2_SH1106_128X64_NONAME_F_HW_I2C *display;
+    U8G2_SH1106_128X64_NONAME_F_HW_I2C display;
 
     // Animation timing variables
     uint32_t animationTick = 0;
-    Ticker animationTicker;
+    esp_timer_handle_t animationTimer = nullptr;
     bool animationRunning = false;
 
     static Display *_instance;
-    static void animationTickerCallback();
+    static void animationTimerCallback(void *arg);
 
     void drawGlobalRow(const MetronomeState &state);
     void drawGlobalProgress(const MetronomeState &state);
@@ -24,7 +24,7 @@ private:
 
 public:
     Display();
-    ~Display(); // Added destructor to prevent memory leaks
+    ~Display();
     void begin();
     void update(const MetronomeState &state);
 
@@ -228,24 +228,7 @@ void EncoderController::handleStartButton()
 
   if (startBtn != lastStartBtn && startBtn == LOW)
   {
-    // If stopped, start playback
-    if (!state.isRunning && !state.isPaused) {
-      state.isRunning = true;
-      state.isPaused = false;
-      timing.start();
-    } 
-    // If running, pause playback
-    else if (state.isRunning && !state.isPaused) {
-      state.isRunning = false;
-      state.isPaused = true;
-      timing.pause();
-    }
-    // If paused, resume playback
-    else if (!state.isRunning && state.isPaused) {
-      state.isRunning = true;
-      state.isPaused = false;
-      timing.pause(); // pause() toggles between pause and resume
-    }
+    timing.togglePlayback();
   }
   lastStartBtn = startBtn;
 }
@@ -269,19 +252,8 @@ void EncoderController::handleStopButton()
       // Clear stored configuration
       state.clearStorage();
       
-      // Reset all state variables
-      state.isRunning = false;
-      state.isPaused = false;
-      state.currentBeat = 0;
-      state.globalTick = 0;
-      state.lastBeatTime = 0;
-      state.tickFraction = 0.0f;
-      state.lastPpqnTick = 0;
-      
-      // Reset all channels
-      for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
-        state.getChannel(i).resetBeat();
-      }
+      // Reset all state variables and channels
+      state.resetPlayback();
       
       // Update tempo
       timing.setTempo(state.bpm);
@@ -310,23 +282,8 @@ void EncoderController::handleStopButton()
   // Normal stop button processing
   if (stopBtn != lastStopBtn && stopBtn == LOW)
   {
-    // Reset all state variables
-    state.isRunning = false;
-    state.isPaused = false;
-    state.currentBeat = 0;
-    state.globalTick = 0;
-    state.lastBeatTime = 0;
-    state.tickFraction = 0.0f;
-    state.lastPpqnTick = 0;
-
-    // Stop the clock
-    timing.stop();
-
-    // Reset all channels
-    for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++)
-    {
-      state.getChannel(i).resetBeat();
-    }
+    // Stop the clock and reset all state variables and channels
+    timing.stopPlayback();
     
     // Debug output
     Serial.println("Metronome stopped and reset");
@@ -0,0 +1,32 @@
+#include "EspNowTransport.h"
+
+bool EspNowTransport::begin(ReceiveCallback onReceive) {
+  // Set device in station mode
+  WiFi.mode(WIFI_STA);
+  
+  // Initialize ESP-NOW
+  if (esp_now_init() != ESP_OK) {
+    Serial.println("Error initializing ESP-NOW");
+    return false;
+  }
+  
+  // Register callback
+  esp_now_register_recv_cb(onReceive);
+  
+  // Register peer (broadcast address)
+  esp_now_peer_info_t peerInfo = {};
+  memcpy(peerInfo.peer_addr, _broadcastAddress, 6);
+  peerInfo.channel = 0;
+  peerInfo.encrypt = false;
+  
+  if (esp_now_add_peer(&peerInfo) != ESP_OK) {
+    Serial.println("Failed to add peer");
+    return false;
+  }
+  
+  return true;
+}
+
+bool EspNowTransport::send(const uint8_t *data, size_t len) {
+  return esp_now_send(_broadcastAddress, data, len) == ESP_OK;
+}
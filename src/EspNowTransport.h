@@ -0,0 +1,16 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_now.h>
+#include <WiFi.h>
+#include "SyncTransport.h"
+
+// ESP-NOW broadcast transport (default WirelessSync backend)
+class EspNowTransport : public SyncTransport {
+private:
+  uint8_t _broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+public:
+  bool begin(ReceiveCallback onReceive) override;
+  bool send(const uint8_t *data, size_t len) override;
+  const char *getName() const override { return "ESP-NOW"; }
+};
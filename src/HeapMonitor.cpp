@@ -0,0 +1,77 @@
+#include "HeapMonitor.h"
+
+// Built only with the --wrap flags of the esp32dev-heapmon environment
+#if ENABLE_HEAP_MONITOR
+
+#include <atomic>
+
+static std::atomic<bool> armed{false};
+static std::atomic<uint32_t> allocationCount{0};
+static volatile uint32_t lastAllocationSize = 0;
+static volatile uintptr_t lastAllocationCaller = 0;
+
+// Safe from any context: no locks, no allocation
+static inline void recordAllocation(size_t size, void *caller) {
+  if (!armed.load(std::memory_order_relaxed)) return;
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  lastAllocationSize = size;
+  lastAllocationCaller = (uintptr_t)caller;
+}
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  recordAllocation(size, __builtin_return_address(0));
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  recordAllocation(count * size, __builtin_return_address(0));
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  // Shrinking or freeing through realloc doesn't take memory
+  if (size > 0) recordAllocation(size, __builtin_return_address(0));
+  return __real_realloc(ptr, size);
+}
+}
+
+void HeapMonitor::arm() {
+  armed.store(true, std::memory_order_relaxed);
+}
+
+uint32_t HeapMonitor::allocations() {
+  return allocationCount.load(std::memory_order_relaxed);
+}
+
+uint32_t HeapMonitor::lastSize() {
+  return lastAllocationSize;
+}
+
+uintptr_t HeapMonitor::lastCaller() {
+  return lastAllocationCaller;
+}
+
+void HeapMonitor::update() {
+  static uint32_t lastReport = 0;
+  static uint32_t reportedCount = 0;
+
+  uint32_t count = allocations();
+  uint32_t now = millis();
+  if (count == reportedCount && now - lastReport < HEAP_REPORT_MS) return;
+
+  // Formatted on the stack: Print::printf() allocates for long lines
+  char line[96];
+  int len = snprintf(line, sizeof(line), "heap: allocations=%u last_size=%u last_caller=0x%08x free=%u\n",
+                     (unsigned)count, (unsigned)lastSize(), (unsigned)lastCaller(),
+                     (unsigned)ESP.getFreeHeap());
+  Serial.write((const uint8_t *)line, len);
+  lastReport = now;
+  reportedCount = count;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Counts heap allocations made after setup().
+//
+// malloc, calloc and realloc are wrapped at link time (-Wl,--wrap in the
+// esp32dev-heapmon environment of platformio.ini), which covers newlib,
+// operator new and the prebuilt IDF components; other builds compile none of
+// this. Direct heap_caps_malloc() calls (e.g. FreeRTOS task stacks)
+// bypass the wrap. The counter is off until arm() so boot-time setup is
+// free to allocate; after that any allocation is a regression in the
+// steady state, reported with its size and caller for addr2line.
+class HeapMonitor {
+public:
+  // Call at the end of setup()
+  static void arm();
+
+  static uint32_t allocations();
+  static uint32_t lastSize();
+  static uintptr_t lastCaller();
+
+  // Print a status line every HEAP_REPORT_MS, and at once on a new allocation
+  static void update();
+};
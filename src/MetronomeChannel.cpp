@@ -1,6 +1,7 @@
 #include "MetronomeChannel.h"
 #include "WirelessSync.h"
 #include "MetronomeState.h"
+#include "Trace.h"
 
 MetronomeChannel::MetronomeChannel(uint8_t channelId)
     : id(channelId), barLength(4), pattern(0), multiplier(1.0), currentBeat(0),
@@ -42,16 +43,10 @@ void MetronomeChannel::generateEuclidean(uint8_t activeBeats) {
     // Reset pattern
     pattern = 0;
     
-    // Debug output
-    Serial.print("Generating Euclidean rhythm: ");
-    Serial.print(activeBeats);
-    Serial.print(" beats in ");
-    Serial.print(barLength);
-    Serial.println(" positions");
-    
     // If we only have one active beat, it should be the first beat
     if (activeBeats <= 1) {
         // First beat is always active and not stored in pattern
+        TRACE(TRACE_EUCLID, (activeBeats << 8) | barLength, pattern);
         return; // pattern remains 0
     }
     
@@ -73,13 +68,6 @@ void MetronomeChannel::generateEuclidean(uint8_t activeBeats) {
         position += beatsPerGroup + (i < remainder ? 1 : 0);
     }
     
-    // Debug output
-    Serial.print("Full pattern: 0b");
-    for (int8_t i = barLength - 1; i >= 0; i--) {
-        Serial.print((fullPattern >> i) & 1);
-    }
-    Serial.println();
-    
     // Now extract the pattern excluding the first beat
     // First, ensure the first beat is active in our pattern
     if (!(fullPattern & 1)) {
@@ -99,13 +87,7 @@ void MetronomeChannel::generateEuclidean(uint8_t activeBeats) {
     
     // Now extract the pattern excluding the first beat
     pattern = (fullPattern >> 1);
-    
-    // Debug output
-    Serial.print("Final pattern: 0b");
-    for (int8_t i = barLength - 2; i >= 0; i--) {
-        Serial.print((pattern >> i) & 1);
-    }
-    Serial.println();
+    TRACE(TRACE_EUCLID, (activeBeats << 8) | barLength, pattern);
 }
 
 uint8_t MetronomeChannel::getId() const { return id; }
@@ -1,5 +1,6 @@
 #include "MetronomeState.h"
 #include "ConfigManager.h"
+#include "Trace.h"
 
 uint32_t MetronomeState::gcd(uint32_t a, uint32_t b) const {
     while (b != 0) {
@@ -138,10 +139,21 @@ void MetronomeState::toggleRhythmMode() {
 
 void MetronomeState::resetBpmToDefault() {
     bpm = DEFAULT_BPM;
-    
-    // Debug output
-    Serial.print("BPM reset to default: ");
-    Serial.println(DEFAULT_BPM);
+    TRACE(TRACE_RESET, TRACE_RESET_BPM, bpm);
+}
+
+void MetronomeState::resetPlayback() {
+    isRunning = false;
+    isPaused = false;
+    currentBeat = 0;
+    globalTick = 0;
+    lastBeatTime = 0;
+    tickFraction = 0.0f;
+    lastPpqnTick = 0;
+
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        getChannel(i).resetBeat();
+    }
 }
 
 void MetronomeState::resetPatternsAndMultiplier() {
@@ -161,9 +173,7 @@ void MetronomeState::resetPatternsAndMultiplier() {
     
     // Reset rhythm mode to default (POLYMETER)
     rhythmMode = POLYMETER;
-    
-    // Debug output
-    Serial.println("Patterns and multiplier reset to defaults");
+    TRACE(TRACE_RESET, TRACE_RESET_PATTERNS);
 }
 
 void MetronomeState::resetChannelPattern(uint8_t channelIndex) {
@@ -172,26 +182,24 @@ void MetronomeState::resetChannelPattern(uint8_t channelIndex) {
         
         // Reset pattern to default (only first beat active)
         channel.setPattern(0);
-        
-        // Debug output
-        Serial.print("Channel ");
-        Serial.print(channelIndex + 1);
-        Serial.println(" pattern reset to default");
+        TRACE(TRACE_RESET, TRACE_RESET_CHANNEL, channelIndex);
     }
 }
 
 // Configuration persistence methods
 bool MetronomeState::saveToStorage() {
-    Serial.println("Saving configuration to storage...");
-    return ConfigManager::saveConfig(*this);
+    bool saved = ConfigManager::saveConfig(*this);
+    TRACE(TRACE_SAVE, 0, saved);
+    return saved;
 }
 
 bool MetronomeState::loadFromStorage() {
-    Serial.println("Loading configuration from storage...");
-    return ConfigManager::loadConfig(*this);
+    bool loaded = ConfigManager::loadConfig(*this);
+    TRACE(TRACE_LOAD, 0, loaded);
+    return loaded;
 }
 
 bool MetronomeState::clearStorage() {
-    Serial.println("Clearing configuration storage...");
+    TRACE(TRACE_RESET, TRACE_RESET_STORAGE);
     return ConfigManager::clearConfig();
 } 
\ No newline at end of file
@@ -91,6 +91,7 @@ public:
     void resetBpmToDefault();
     void resetPatternsAndMultiplier();
     void resetChannelPattern(uint8_t channelIndex);
+    void resetPlayback(); // Stopped, at the first beat of every channel
     
     // Configuration persistence methods
     bool saveToStorage();
@@ -0,0 +1,484 @@
+#include "OscServer.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <sys/time.h>
+#include "ConfigManager.h"
+
+#define OSC_ROUTE(address, handler, param) \
+  { OscServer::hashAddress(address), address, handler, param }
+
+// Seconds between the NTP epoch (1900) used by OSC timetags and the Unix epoch
+#define NTP_UNIX_OFFSET 2208988800UL
+
+// Timetag value meaning "immediately"
+#define OSC_TIMETAG_IMMEDIATE 1ULL
+
+// Compile-time route table. Hashes are constant-initialized, so matching a
+// plain address is one hash compare plus one strcmp.
+const OscServer::Route OscServer::routes[] = {
+  OSC_ROUTE("/metronome/bpm", onBpm, 0),
+  OSC_ROUTE("/metronome/play", onPlay, 0),
+  OSC_ROUTE("/metronome/pause", onPause, 0),
+  OSC_ROUTE("/metronome/stop", onStop, 0),
+  OSC_ROUTE("/metronome/multiplier", onMultiplier, 0),
+  OSC_ROUTE("/metronome/mode", onRhythmMode, 0),
+  OSC_ROUTE("/metronome/ch1/enabled", onChannelEnabled, 0),
+  OSC_ROUTE("/metronome/ch1/length", onChannelLength, 0),
+  OSC_ROUTE("/metronome/ch1/pattern", onChannelPattern, 0),
+  OSC_ROUTE("/metronome/ch1/euclid", onChannelEuclid, 0),
+  OSC_ROUTE("/metronome/ch2/enabled", onChannelEnabled, 1),
+  OSC_ROUTE("/metronome/ch2/length", onChannelLength, 1),
+  OSC_ROUTE("/metronome/ch2/pattern", onChannelPattern, 1),
+  OSC_ROUTE("/metronome/ch2/euclid", onChannelEuclid, 1),
+  OSC_ROUTE("/metronome/config/save", onConfigSave, 0),
+  OSC_ROUTE("/metronome/config/load", onConfigLoad, 0),
+};
+const uint8_t OscServer::ROUTE_COUNT = sizeof(OscServer::routes) / sizeof(OscServer::routes[0]);
+
+// Big-endian readers (OSC is network byte order)
+static inline uint32_t readBE32(const uint8_t *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint64_t readBE64(const uint8_t *p) {
+  return ((uint64_t)readBE32(p) << 32) | readBE32(p + 4);
+}
+
+// Read a null-terminated, 4-byte padded OSC string in place.
+// Returns the offset just past it, or -1 if it runs off the buffer.
+static int32_t readString(const uint8_t *data, int32_t len, int32_t offset, const char **str) {
+  int32_t end = offset;
+  while (end < len && data[end] != 0) {
+    end++;
+  }
+  if (end >= len) {
+    return -1;
+  }
+  *str = (const char *)&data[offset];
+  return (end + 4) & ~3;
+}
+
+int32_t OscArgs::getInt(uint8_t index, int32_t fallback) const {
+  if (index >= count) return fallback;
+  return types[index] == 'f' ? (int32_t)lroundf(values[index].f) : values[index].i;
+}
+
+float OscArgs::getFloat(uint8_t index, float fallback) const {
+  if (index >= count) return fallback;
+  return types[index] == 'f' ? values[index].f : (float)values[index].i;
+}
+
+OscServer::OscServer(MetronomeState &state, Timing &timing, uint16_t port)
+    : state(state), timing(timing), port(port) {
+  memset(pending, 0, sizeof(pending));
+}
+
+bool OscServer::begin() {
+  // Join the show-control network (ESP-NOW keeps working on the AP's channel)
+  WiFi.begin(OSC_WIFI_SSID, OSC_WIFI_PASSWORD);
+  
+  // Bundle timetags are wall-clock (NTP) times; SNTP sets the clock once
+  // the network is up, until then bundles are applied on arrival
+  configTime(0, 0, OSC_NTP_SERVER);
+  
+  socketFd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (socketFd < 0) {
+    Serial.println("Error creating OSC socket");
+    return false;
+  }
+  
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(socketFd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    Serial.println("Error binding OSC socket");
+    close(socketFd);
+    socketFd = -1;
+    return false;
+  }
+  
+  socklen_t addrLen = sizeof(addr);
+  getsockname(socketFd, (struct sockaddr *)&addr, &addrLen);
+  port = ntohs(addr.sin_port);
+  
+  Serial.printf("OSC server listening on UDP port %d\n", port);
+  return true;
+}
+
+void OscServer::update() {
+  if (socketFd < 0) return;
+  
+  // Bounded drain so a flood of packets can't starve the rest of loop()
+  for (uint8_t i = 0; i < OSC_MAX_PACKETS_PER_UPDATE; i++) {
+    int len = recv(socketFd, rxBuffer, sizeof(rxBuffer), MSG_DONTWAIT);
+    if (len <= 0) break;
+    handlePacket(rxBuffer, len);
+  }
+  
+  runPending();
+}
+
+bool OscServer::handlePacket(const uint8_t *data, int32_t len) {
+  if ((len & 3) != 0 || !handlePacket(data, len, 0)) {
+    packetsMalformed++;
+    return false;
+  }
+  return true;
+}
+
+bool OscServer::handlePacket(const uint8_t *data, int32_t len, uint8_t depth) {
+  if (len < 4) return false;
+  if (data[0] == '#') return handleBundle(data, len, depth);
+  if (data[0] == '/') return handleMessage(data, len, OSC_TIMETAG_IMMEDIATE);
+  return false;
+}
+
+bool OscServer::handleBundle(const uint8_t *data, int32_t len, uint8_t depth) {
+  if (depth >= 4 || len < 16 || memcmp(data, "#bundle", 8) != 0) {
+    return false;
+  }
+  
+  uint64_t timetag = readBE64(&data[8]);
+  int32_t offset = 16;
+  
+  while (offset + 4 <= len) {
+    int32_t size = (int32_t)readBE32(&data[offset]);
+    offset += 4;
+    if (size <= 0 || (size & 3) != 0 || size > len - offset) {
+      return false;
+    }
+    
+    const uint8_t *element = &data[offset];
+    bool ok = element[0] == '#' ? handleBundle(element, size, depth + 1)
+                                : handleMessage(element, size, timetag);
+    if (!ok) return false;
+    offset += size;
+  }
+  
+  return offset == len;
+}
+
+bool OscServer::handleMessage(const uint8_t *data, int32_t len, uint64_t timetag) {
+  const char *address;
+  int32_t offset = readString(data, len, 0, &address);
+  if (offset < 0 || address[0] != '/') return false;
+  
+  // Type tags are optional in very old senders; no tags means no arguments
+  const char *typeTags = ",";
+  if (offset < len) {
+    offset = readString(data, len, offset, &typeTags);
+    if (offset < 0 || typeTags[0] != ',') return false;
+  }
+  
+  OscArgs args;
+  for (const char *tag = typeTags + 1; *tag; tag++) {
+    switch (*tag) {
+      case 'i':
+      case 'f':
+        if (offset + 4 > len) return false;
+        if (args.count < OSC_MAX_ARGS) {
+          args.types[args.count] = *tag;
+          args.values[args.count].i = (int32_t)readBE32(&data[offset]);
+          args.count++;
+        }
+        offset += 4;
+        break;
+      
+      case 'h':
+      case 'd':
+      case 't':
+        if (offset + 8 > len) return false;
+        if (args.count < OSC_MAX_ARGS && *tag != 't') {
+          uint64_t raw = readBE64(&data[offset]);
+          if (*tag == 'd') {
+            double d;
+            memcpy(&d, &raw, sizeof(d));
+            args.types[args.count] = 'f';
+            args.values[args.count].f = (float)d;
+          } else {
+            args.types[args.count] = 'i';
+            args.values[args.count].i = (int32_t)raw;
+          }
+          args.count++;
+        }
+        offset += 8;
+        break;
+      
+      case 'T':
+      case 'F':
+        if (args.count < OSC_MAX_ARGS) {
+          args.types[args.count] = 'i';
+          args.values[args.count].i = (*tag == 'T') ? 1 : 0;
+          args.count++;
+        }
+        break;
+      
+      case 's':
+      case 'S': {
+        const char *ignored;
+        offset = readString(data, len, offset, &ignored);
+        if (offset < 0) return false;
+        break;
+      }
+      
+      case 'b': {
+        if (offset + 4 > len) return false;
+        int32_t size = (int32_t)readBE32(&data[offset]);
+        if (size < 0 || size > len - offset - 4) return false;
+        offset += 4 + ((size + 3) & ~3);
+        break;
+      }
+      
+      case 'N':
+      case 'I':
+        break;
+      
+      default:
+        return false;
+    }
+  }
+  
+  bool matched = false;
+  if (!hasWildcards(address)) {
+    uint32_t hash = hashAddress(address);
+    for (uint8_t i = 0; i < ROUTE_COUNT; i++) {
+      if (routes[i].hash == hash && strcmp(routes[i].address, address) == 0) {
+        dispatch(i, args, timetag);
+        matched = true;
+        break;
+      }
+    }
+  } else {
+    // A pattern may address several routes at once
+    for (uint8_t i = 0; i < ROUTE_COUNT; i++) {
+      if (matchPattern(address, routes[i].address)) {
+        dispatch(i, args, timetag);
+        matched = true;
+      }
+    }
+  }
+  
+  if (!matched) {
+    messagesUnmatched++;
+  }
+  return true;
+}
+
+void OscServer::dispatch(uint8_t route, const OscArgs &args, uint64_t timetag) {
+  uint32_t dueMicros;
+  if (timetag != OSC_TIMETAG_IMMEDIATE && timetagToMicros(timetag, dueMicros)) {
+    schedule(route, args, dueMicros);
+    return;
+  }
+  
+  routes[route].handler(*this, routes[route].param, args);
+  messagesHandled++;
+}
+
+// Insert in due order; equal times keep arrival (bundle) order. A full
+// queue drops the message: applying it now would be early.
+void OscServer::schedule(uint8_t route, const OscArgs &args, uint32_t dueMicros) {
+  if (pendingCount == OSC_MAX_PENDING) {
+    messagesDropped++;
+    return;
+  }
+  
+  // Due times are at most OSC_MAX_SCHEDULE_AHEAD_MS apart, so the wrapping
+  // difference orders them
+  uint8_t i = pendingCount;
+  while (i > 0 && (int32_t)(pending[i - 1].dueMicros - dueMicros) > 0) {
+    pending[i] = pending[i - 1];
+    i--;
+  }
+  pending[i].dueMicros = dueMicros;
+  pending[i].route = route;
+  pending[i].args = args;
+  pendingCount++;
+  messagesScheduled++;
+}
+
+// Everything due, earliest first, so a later timetag wins
+void OscServer::runPending() {
+  uint32_t now = micros();
+  uint8_t due = 0;
+  while (due < pendingCount && (int32_t)(now - pending[due].dueMicros) >= 0) {
+    const PendingMessage &message = pending[due++];
+    routes[message.route].handler(*this, routes[message.route].param, message.args);
+    messagesHandled++;
+  }
+  
+  if (due > 0) {
+    pendingCount -= due;
+    memmove(pending, &pending[due], pendingCount * sizeof(pending[0]));
+  }
+}
+
+// Convert an NTP timetag to a local micros() deadline.
+// Returns false if it is due now (or the wall clock isn't set).
+bool OscServer::timetagToMicros(uint64_t timetag, uint32_t &dueMicros) {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec < 1600000000) {
+    return false; // No SNTP time yet, can't place the timetag
+  }
+  
+  uint64_t now = ((uint64_t)(tv.tv_sec + NTP_UNIX_OFFSET) << 32) |
+                 (((uint64_t)tv.tv_usec << 32) / 1000000);
+  if (timetag <= now) {
+    return false;
+  }
+  
+  uint64_t ahead = timetag - now;
+  const uint64_t maxAhead = ((uint64_t)OSC_MAX_SCHEDULE_AHEAD_MS << 32) / 1000;
+  if (ahead > maxAhead) {
+    ahead = maxAhead;
+  }
+  
+  dueMicros = micros() + (uint32_t)((ahead * 1000000) >> 32);
+  return true;
+}
+
+bool OscServer::hasWildcards(const char *pattern) {
+  return strpbrk(pattern, "?*[{") != nullptr;
+}
+
+// OSC 1.0 address pattern matching: ? * [abc] [a-z] [!abc] {foo,bar}.
+// Wildcards never match across '/'.
+bool OscServer::matchPattern(const char *pattern, const char *address) {
+  while (*pattern) {
+    switch (*pattern) {
+      case '?':
+        if (!*address || *address == '/') return false;
+        pattern++;
+        address++;
+        break;
+      
+      case '*':
+        pattern++;
+        for (;;) {
+          if (matchPattern(pattern, address)) return true;
+          if (!*address || *address == '/') return false;
+          address++;
+        }
+      
+      case '[': {
+        pattern++;
+        bool negate = (*pattern == '!');
+        if (negate) pattern++;
+        bool matched = false;
+        while (*pattern && *pattern != ']') {
+          char lo = *pattern;
+          char hi = lo;
+          if (pattern[1] == '-' && pattern[2] && pattern[2] != ']') {
+            hi = pattern[2];
+            pattern += 3;
+          } else {
+            pattern++;
+          }
+          if (*address >= lo && *address <= hi) matched = true;
+        }
+        if (*pattern != ']' || !*address || *address == '/' || matched == negate) return false;
+        pattern++;
+        address++;
+        break;
+      }
+      
+      case '{': {
+        const char *end = strchr(pattern, '}');
+        if (!end) return false;
+        const char *alternative = pattern + 1;
+        while (alternative <= end) {
+          const char *comma = alternative;
+          while (comma < end && *comma != ',') comma++;
+          size_t length = comma - alternative;
+          if (strncmp(alternative, address, length) == 0 && matchPattern(end + 1, address + length)) {
+            return true;
+          }
+          alternative = comma + 1;
+        }
+        return false;
+      }
+      
+      default:
+        if (*pattern != *address) return false;
+        pattern++;
+        address++;
+        break;
+    }
+  }
+  return *address == 0;
+}
+
+// ###################################
+// Route handlers
+
+void OscServer::onBpm(OscServer &server, uint8_t param, const OscArgs &args) {
+  if (args.count < 1) return;
+  server.state.bpm = constrain((int32_t)lroundf(args.getFloat(0)), MIN_GLOBAL_BPM, MAX_GLOBAL_BPM);
+  server.timing.setTempo(server.state.bpm);
+}
+
+void OscServer::onPlay(OscServer &server, uint8_t param, const OscArgs &args) {
+  server.timing.play();
+}
+
+void OscServer::onPause(OscServer &server, uint8_t param, const OscArgs &args) {
+  server.timing.pausePlayback();
+}
+
+void OscServer::onStop(OscServer &server, uint8_t param, const OscArgs &args) {
+  server.timing.stopPlayback();
+}
+
+void OscServer::onMultiplier(OscServer &server, uint8_t param, const OscArgs &args) {
+  if (args.count < 1) return;
+  server.state.currentMultiplierIndex = constrain(args.getInt(0), 0, MULTIPLIER_COUNT - 1);
+}
+
+void OscServer::onRhythmMode(OscServer &server, uint8_t param, const OscArgs &args) {
+  if (args.count < 1) return;
+  server.state.rhythmMode = args.getInt(0) ? POLYRHYTHM : POLYMETER;
+}
+
+void OscServer::onChannelEnabled(OscServer &server, uint8_t param, const OscArgs &args) {
+  if (args.count < 1) return;
+  MetronomeChannel &channel = server.state.getChannel(param);
+  if (channel.isEnabled() != (args.getInt(0) != 0)) {
+    channel.toggleEnabled();
+  }
+}
+
+void OscServer::onChannelLength(OscServer &server, uint8_t param, const OscArgs &args) {
+  if (args.count < 1) return;
+  MetronomeChannel &channel = server.state.getChannel(param);
+  channel.setBarLength(constrain(args.getInt(0), 1, MAX_BEATS));
+  channel.setPattern(channel.getPattern() & channel.getMaxPattern());
+}
+
+void OscServer::onChannelPattern(OscServer &server, uint8_t param, const OscArgs &args) {
+  if (args.count < 1) return;
+  MetronomeChannel &channel = server.state.getChannel(param);
+  channel.setPattern(args.getInt(0) & channel.getMaxPattern());
+}
+
+void OscServer::onChannelEuclid(OscServer &server, uint8_t param, const OscArgs &args) {
+  if (args.count < 1) return;
+  MetronomeChannel &channel = server.state.getChannel(param);
+  channel.generateEuclidean(constrain(args.getInt(0), 1, channel.getBarLength()));
+  channel.setPattern(channel.getPattern()); // Notify wireless sync
+}
+
+void OscServer::onConfigSave(OscServer &server, uint8_t param, const OscArgs &args) {
+  ConfigManager::init();
+  server.state.saveToStorage();
+  ConfigManager::end();
+}
+
+void OscServer::onConfigLoad(OscServer &server, uint8_t param, const OscArgs &args) {
+  ConfigManager::init();
+  if (server.state.loadFromStorage()) {
+    server.timing.setTempo(server.state.bpm);
+  }
+  ConfigManager::end();
+}
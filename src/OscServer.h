@@ -0,0 +1,123 @@
+#pragma once
+#include <Arduino.h>
+#include "MetronomeState.h"
+#include "Timing.h"
+#include "config.h"
+
+// Maximum number of arguments kept per OSC message
+#define OSC_MAX_ARGS 4
+
+// Numeric arguments of one OSC message (strings and blobs are skipped)
+struct OscArgs {
+  uint8_t count = 0;
+  char types[OSC_MAX_ARGS];
+  union {
+    int32_t i;
+    float f;
+  } values[OSC_MAX_ARGS];
+
+  int32_t getInt(uint8_t index, int32_t fallback = 0) const;
+  float getFloat(uint8_t index, float fallback = 0.0f) const;
+};
+
+// OSC (Open Sound Control) UDP server for show-control software.
+//
+// Packets are parsed in place in a static receive buffer: no heap, no String.
+// Address patterns are matched against a compile-time route table (hashed for
+// plain addresses, glob-matched for patterns with wildcards). Bundles carrying
+// a future timetag are queued and applied when their time comes, in timetag
+// order; when the queue is full they are dropped, never applied early.
+// Timetags are placed on this device's clock through the SNTP wall clock,
+// not on the sync timeline: followers get the change through the usual sync
+// messages, one sync latency later.
+class OscServer {
+private:
+  typedef void (*Handler)(OscServer &server, uint8_t param, const OscArgs &args);
+
+  struct Route {
+    uint32_t hash;        // FNV-1a of the address, computed at compile time
+    const char *address;
+    Handler handler;
+    uint8_t param;        // Handler parameter (channel index)
+  };
+
+  // Message scheduled by a bundle timetag
+  struct PendingMessage {
+    uint32_t dueMicros;
+    uint8_t route;
+    OscArgs args;
+  };
+
+  static const Route routes[];
+  static const uint8_t ROUTE_COUNT;
+
+  MetronomeState &state;
+  Timing &timing;
+
+  int socketFd = -1;
+  uint16_t port;
+  uint8_t rxBuffer[OSC_RX_BUFFER_SIZE];
+  PendingMessage pending[OSC_MAX_PENDING];  // Sorted by dueMicros
+  uint8_t pendingCount = 0;
+
+  // Statistics
+  uint32_t messagesHandled = 0;
+  uint32_t messagesUnmatched = 0;
+  uint32_t packetsMalformed = 0;
+  uint32_t messagesScheduled = 0;
+  uint32_t messagesDropped = 0;
+
+  bool handlePacket(const uint8_t *data, int32_t len, uint8_t depth);
+  bool handleBundle(const uint8_t *data, int32_t len, uint8_t depth);
+  bool handleMessage(const uint8_t *data, int32_t len, uint64_t timetag);
+  void dispatch(uint8_t route, const OscArgs &args, uint64_t timetag);
+  void schedule(uint8_t route, const OscArgs &args, uint32_t dueMicros);
+  void runPending();
+
+  static bool timetagToMicros(uint64_t timetag, uint32_t &dueMicros);
+  static bool matchPattern(const char *pattern, const char *address);
+  static bool hasWildcards(const char *pattern);
+
+  // Route handlers
+  static void onBpm(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onPlay(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onPause(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onStop(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onMultiplier(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onRhythmMode(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onChannelEnabled(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onChannelLength(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onChannelPattern(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onChannelEuclid(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onConfigSave(OscServer &server, uint8_t param, const OscArgs &args);
+  static void onConfigLoad(OscServer &server, uint8_t param, const OscArgs &args);
+
+public:
+  // FNV-1a, usable at compile time for the route table
+  static constexpr uint32_t hashAddress(const char *address) {
+    uint32_t hash = 2166136261u;
+    while (*address) {
+      hash = (hash ^ (uint8_t)*address++) * 16777619u;
+    }
+    return hash;
+  }
+
+  OscServer(MetronomeState &state, Timing &timing, uint16_t port = OSC_PORT);
+
+  // Open the UDP socket (WiFi must be in STA mode); port 0 picks a free one
+  bool begin();
+  uint16_t getPort() const { return port; }
+
+  // Drain received packets and run scheduled messages; call from loop()
+  void update();
+
+  // Parse one received datagram in place and apply it, as update() does for
+  // each one it drains. Returns false (and counts it) if it is malformed.
+  bool handlePacket(const uint8_t *data, int32_t len);
+
+  uint32_t getMessagesHandled() const { return messagesHandled; }
+  uint32_t getMessagesUnmatched() const { return messagesUnmatched; }
+  uint32_t getPacketsMalformed() const { return packetsMalformed; }
+  uint32_t getMessagesScheduled() const { return messagesScheduled; }
+  uint32_t getMessagesDropped() const { return messagesDropped; }
+};
@@ -0,0 +1,155 @@
+#include "Rs485Transport.h"
+#include <esp_timer.h>
+#include "WirelessSync.h"
+
+#define RS485_RX_BUFFER_SIZE 1024
+#define RS485_TX_BUFFER_SIZE 512
+#define RS485_EVENT_QUEUE_LEN 16
+#define RS485_RX_TIMEOUT_SYMBOLS 3  // Idle symbols before the driver reports data
+
+// Start bit of the first byte of a frame: stamp it and mask the pin until the
+// frame is parsed, so the data bits that follow don't interrupt us
+void IRAM_ATTR Rs485Transport::onStartBitISR(void *arg) {
+  Rs485Transport *self = static_cast<Rs485Transport *>(arg);
+  self->_frameStartTime = esp_timer_get_time();
+  gpio_intr_disable((gpio_num_t)self->_rxPin);
+}
+
+bool Rs485Transport::begin(ReceiveCallback onReceive) {
+  _onReceive = onReceive;
+  
+  uart_config_t uartConfig = {};
+  uartConfig.baud_rate = _baud;
+  uartConfig.data_bits = UART_DATA_8_BITS;
+  uartConfig.parity = UART_PARITY_DISABLE;
+  uartConfig.stop_bits = UART_STOP_BITS_1;
+  uartConfig.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  
+  if (uart_driver_install(_port, RS485_RX_BUFFER_SIZE, RS485_TX_BUFFER_SIZE,
+                          RS485_EVENT_QUEUE_LEN, &_eventQueue, 0) != ESP_OK) {
+    Serial.println("Error installing RS-485 UART driver");
+    return false;
+  }
+  
+  // RTS drives the transceiver's DE pin in half-duplex mode
+  if (uart_param_config(_port, &uartConfig) != ESP_OK ||
+      uart_set_pin(_port, _txPin, _rxPin, _dePin, UART_PIN_NO_CHANGE) != ESP_OK ||
+      uart_set_mode(_port, UART_MODE_RS485_HALF_DUPLEX) != ESP_OK) {
+    Serial.println("Error configuring RS-485 UART");
+    uart_driver_delete(_port);
+    return false;
+  }
+  uart_set_rx_timeout(_port, RS485_RX_TIMEOUT_SYMBOLS);
+  
+  // Falling edge on RX = start bit. The pin stays routed to the UART; we only
+  // add an edge interrupt on top of it.
+  esp_err_t err = gpio_install_isr_service(0);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) { // Already installed is fine
+    Serial.println("Error installing GPIO ISR service");
+    return false;
+  }
+  gpio_set_intr_type((gpio_num_t)_rxPin, GPIO_INTR_NEGEDGE);
+  gpio_isr_handler_add((gpio_num_t)_rxPin, onStartBitISR, this);
+  armStartBitInterrupt();
+  
+  // Frames are parsed and delivered from a dedicated task, the same way
+  // ESP-NOW delivers them from the WiFi task
+  if (xTaskCreatePinnedToCore(rxTaskEntry, "rs485_rx", 3072, this,
+                              configMAX_PRIORITIES - 2, &_rxTask, 0) != pdPASS) {
+    Serial.println("Error starting RS-485 receive task");
+    return false;
+  }
+  
+  return true;
+}
+
+bool Rs485Transport::send(const uint8_t *data, size_t len) {
+  uint8_t frame[SYNC_FRAME_MAX_PAYLOAD + SYNC_FRAME_OVERHEAD];
+  size_t frameLen = syncFrameEncode(data, len, frame);
+  if (frameLen == 0) {
+    return false;
+  }
+  
+  // Copied into the driver's TX ring buffer; the ISR feeds the FIFO
+  return uart_write_bytes(_port, (const char *)frame, frameLen) == (int)frameLen;
+}
+
+void Rs485Transport::rxTaskEntry(void *arg) {
+  Rs485Transport *self = static_cast<Rs485Transport *>(arg);
+  uart_event_t event;
+  uint8_t buffer[128];
+  
+  for (;;) {
+    if (xQueueReceive(self->_eventQueue, &event, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    
+    switch (event.type) {
+      case UART_DATA: {
+        size_t remaining = event.size;
+        while (remaining > 0) {
+          int n = uart_read_bytes(self->_port, buffer, min(remaining, sizeof(buffer)), 0);
+          if (n <= 0) break;
+          self->processBytes(buffer, n);
+          remaining -= n;
+        }
+        break;
+      }
+      
+      case UART_FIFO_OVF:
+      case UART_BUFFER_FULL:
+        // Drop everything; the leader keeps streaming, we resync on the next frame
+        self->_rxOverflows++;
+        uart_flush_input(self->_port);
+        xQueueReset(self->_eventQueue);
+        self->_parser.reset();
+        self->armStartBitInterrupt();
+        break;
+      
+      default:
+        break;
+    }
+  }
+}
+
+void Rs485Transport::processBytes(const uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (_parser.feed(data[i])) {
+      deliverFrame();
+    }
+  }
+  
+  // Re-arm only between frames, so a frame split across reads keeps the
+  // timestamp of its first byte
+  if (_parser.isIdle()) {
+    armStartBitInterrupt();
+  }
+}
+
+void Rs485Transport::deliverFrame() {
+  _framesReceived++;
+  
+  // Start-bit time of this frame; estimate it from the byte count if the
+  // interrupt was missed
+  int64_t startTime = _frameStartTime;
+  if (startTime == 0) {
+    uint32_t frameBits = (_parser.length() + SYNC_FRAME_OVERHEAD) * 10;
+    startTime = esp_timer_get_time() - (int64_t)frameBits * 1000000 / _baud;
+  }
+  
+  if (_parser.length() == sizeof(SyncMessage)) {
+    // Re-stamp the message with its send time in our clock: start bit minus
+    // the sender's TX latency and cable propagation delay
+    SyncMessage msg;
+    memcpy(&msg, _parser.payload(), sizeof(msg));
+    msg.timestamp = (uint32_t)(startTime - _lineDelayNs / 1000); // micros() base
+    _onReceive(msg.deviceID, (const uint8_t *)&msg, sizeof(msg));
+  }
+  
+  _frameStartTime = 0;
+}
+
+void Rs485Transport::armStartBitInterrupt() {
+  _frameStartTime = 0;
+  gpio_intr_enable((gpio_num_t)_rxPin);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <driver/gpio.h>
+#include "SyncTransport.h"
+#include "SyncFrame.h"
+#include "config.h"
+
+// Wired sync transport: UART + RS-485 transceiver, half duplex.
+//
+// - The IDF UART driver moves bytes between the FIFOs and its ring buffers
+//   from its ISR, so neither TX nor RX busy-waits on the CPU.
+// - The transceiver's driver-enable pin is driven by the UART's RTS line in
+//   RS485_HALF_DUPLEX mode, so direction switching is done in hardware.
+// - Frames are timestamped by a GPIO interrupt on the start bit of their first
+//   byte, then the configured line delay is subtracted so the message
+//   timestamp is the send time expressed in the local clock.
+class Rs485Transport : public SyncTransport {
+private:
+  uart_port_t _port;
+  int8_t _txPin;
+  int8_t _rxPin;
+  int8_t _dePin;
+  uint32_t _baud;
+  uint32_t _lineDelayNs;
+
+  ReceiveCallback _onReceive;
+  QueueHandle_t _eventQueue;
+  TaskHandle_t _rxTask;
+  SyncFrameParser _parser;
+
+  // Start-bit timestamp of the frame currently being received (0 = none)
+  volatile int64_t _frameStartTime;
+
+  // Statistics
+  uint32_t _framesReceived;
+  uint32_t _rxOverflows;
+
+  static void IRAM_ATTR onStartBitISR(void *arg);
+  static void rxTaskEntry(void *arg);
+  void processBytes(const uint8_t *data, size_t len);
+  void deliverFrame();
+  void armStartBitInterrupt();
+
+public:
+  Rs485Transport(uart_port_t port, int8_t txPin, int8_t rxPin, int8_t dePin, uint32_t baud)
+      : _port(port),
+        _txPin(txPin),
+        _rxPin(rxPin),
+        _dePin(dePin),
+        _baud(baud),
+        _lineDelayNs(RS485_TX_LATENCY_NS + RS485_CABLE_LENGTH_M * RS485_PROPAGATION_NS_PER_M),
+        _onReceive(nullptr),
+        _eventQueue(nullptr),
+        _rxTask(nullptr),
+        _frameStartTime(0),
+        _framesReceived(0),
+        _rxOverflows(0) {}
+
+  bool begin(ReceiveCallback onReceive) override;
+  bool send(const uint8_t *data, size_t len) override;
+  const char *getName() const override { return "RS-485"; }
+
+  // Delay from the sender stamping a frame to its start bit reaching us
+  void setLineDelay(uint32_t ns) { _lineDelayNs = ns; }
+  uint32_t getLineDelay() const { return _lineDelayNs; }
+
+  uint32_t getFramesReceived() const { return _framesReceived; }
+  uint32_t getCrcErrors() const { return _parser.crcErrors(); }
+  uint32_t getRxOverflows() const { return _rxOverflows; }
+};
@@ -0,0 +1,244 @@
+#include "SerialControl.h"
+#include "CommandSerial.h"
+#include "ConfigManager.h"
+
+SerialControl *SerialControl::instance = nullptr;
+
+SerialControl::SerialControl(MetronomeState &state, Timing &timing, WirelessSync &sync)
+  : state(state), timing(timing), sync(sync) {}
+
+void SerialControl::begin() {
+  instance = this;
+  timing.setBeatListener(onBeat);
+}
+
+// uClock callback context: queue only
+void SerialControl::onBeat(uint8_t channel, BeatState beatState) {
+  SerialControl *self = instance;
+  if (!self || !(self->eventMask & CTRL_EVENTS_BEAT)) return;
+
+  uint32_t head = self->eventHead.load(std::memory_order_relaxed);
+  if (head - self->eventTail.load(std::memory_order_acquire) >= CONTROL_EVENT_QUEUE_SIZE) {
+    self->eventsDropped++;
+    return;
+  }
+  BeatEvent &event = self->events[head & (CONTROL_EVENT_QUEUE_SIZE - 1)];
+  event.channel = channel;
+  event.beatState = beatState;
+  event.micros = micros();
+  self->eventHead.store(head + 1, std::memory_order_release);
+}
+
+void SerialControl::update() {
+  uint32_t now = millis();
+  if (reader.inFrame() && now - lastByteTime > CONTROL_FRAME_TIMEOUT_MS) {
+    reader.reset();
+  }
+
+  for (int n = 0; n < CONTROL_MAX_BYTES_PER_UPDATE && Serial.available(); n++) {
+    uint8_t b = Serial.read();
+    lastByteTime = now;
+
+    switch (reader.feed(b)) {
+      case ControlFrameReader::TEXT:
+        if (commands) commands->feed((char)b);
+        break;
+      case ControlFrameReader::FRAME_READY:
+        handleFrame();
+        break;
+      case ControlFrameReader::CONSUMED:
+        break;
+    }
+  }
+
+  sendEvents();
+}
+
+void SerialControl::handleFrame() {
+  uint8_t status = applyCommand(reader.type(), reader.payload(), reader.payloadLength());
+  if (status == CTRL_OK) {
+    commandsHandled++;
+  } else {
+    commandsRejected++;
+  }
+
+  CtrlAck ack;
+  ack.command = reader.type();
+  ack.status = status;
+  ack.deviceMicros = micros();
+  sendFrame(CTRL_ACK, reader.seq(), &ack, sizeof(ack));
+}
+
+// Returns a ControlStatus
+uint8_t SerialControl::applyCommand(uint8_t type, const uint8_t *payload, size_t len) {
+  switch (type) {
+    case CTRL_PING:
+      return CTRL_OK;
+
+    case CTRL_SET_BPM: {
+      CtrlSetBpm cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      if (cmd.bpm < MIN_GLOBAL_BPM || cmd.bpm > MAX_GLOBAL_BPM) return CTRL_ERR_VALUE;
+      state.bpm = cmd.bpm;
+      timing.setTempo(state.bpm);
+      return CTRL_OK;
+    }
+
+    case CTRL_TRANSPORT: {
+      CtrlTransport cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      switch (cmd.action) {
+        case CTRL_PLAY:
+          timing.play();
+          return CTRL_OK;
+        case CTRL_PAUSE:
+          timing.pausePlayback();
+          return CTRL_OK;
+        case CTRL_STOP:
+          timing.stopPlayback();
+          return CTRL_OK;
+        default:
+          return CTRL_ERR_VALUE;
+      }
+    }
+
+    case CTRL_SET_PATTERN: {
+      CtrlSetPattern cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      if (cmd.channel >= MetronomeState::CHANNEL_COUNT) return CTRL_ERR_VALUE;
+      if (cmd.length < 1 || cmd.length > MAX_BEATS) return CTRL_ERR_VALUE;
+      MetronomeChannel &channel = state.getChannel(cmd.channel);
+      channel.setBarLength(cmd.length);
+      channel.setPattern(cmd.pattern & channel.getMaxPattern());
+      return CTRL_OK;
+    }
+
+    case CTRL_SET_ENABLED: {
+      CtrlSetEnabled cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      if (cmd.channel >= MetronomeState::CHANNEL_COUNT) return CTRL_ERR_VALUE;
+      MetronomeChannel &channel = state.getChannel(cmd.channel);
+      if (channel.isEnabled() != (cmd.enabled != 0)) {
+        channel.toggleEnabled();
+      }
+      return CTRL_OK;
+    }
+
+    case CTRL_SET_MULTIPLIER: {
+      CtrlSetValue cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      if (cmd.value >= MULTIPLIER_COUNT) return CTRL_ERR_VALUE;
+      state.currentMultiplierIndex = cmd.value;
+      return CTRL_OK;
+    }
+
+    case CTRL_SET_MODE: {
+      CtrlSetValue cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      if (cmd.value > 1) return CTRL_ERR_VALUE;
+      state.rhythmMode = cmd.value ? POLYRHYTHM : POLYMETER;
+      return CTRL_OK;
+    }
+
+    case CTRL_SUBSCRIBE: {
+      CtrlSetValue cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      eventMask = cmd.value;
+      return CTRL_OK;
+    }
+
+    case CTRL_ASSIGN_CHANNELS: {
+      CtrlAssignChannels cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      if (!sync.isLeader()) return CTRL_ERR_STATE;
+      // Fails when the assignment table is full
+      if (!sync.assignChannels(cmd.device, cmd.channelMask)) return CTRL_ERR_VALUE;
+      return CTRL_OK;
+    }
+
+    case CTRL_CLEAR_ASSIGNMENTS:
+      if (len != 0) return CTRL_ERR_LENGTH;
+      if (!sync.isLeader()) return CTRL_ERR_STATE;
+      sync.clearChannelAssignments();
+      return CTRL_OK;
+
+    case CTRL_SET_GROUP: {
+      CtrlSetGroup cmd;
+      if (len != sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      if (!sync.setGroupID(cmd.groupID)) return CTRL_ERR_VALUE;
+      ConfigManager::init();
+      ConfigManager::saveGroupID(cmd.groupID);
+      ConfigManager::end();
+      return CTRL_OK;
+    }
+
+    case CTRL_SEND_LAYOUT: {
+      CtrlSendLayout cmd;
+      if (len < sizeof(cmd)) return CTRL_ERR_LENGTH;
+      memcpy(&cmd, payload, sizeof(cmd));
+      if (len != sizeof(cmd) + cmd.count * sizeof(CtrlLayoutSegment)) return CTRL_ERR_LENGTH;
+      if (cmd.count == 0 || cmd.count > MAX_LAYOUT_SEGMENTS) return CTRL_ERR_VALUE;
+      if (!sync.isLeader()) return CTRL_ERR_STATE;
+      
+      LedSegment segments[MAX_LAYOUT_SEGMENTS];
+      for (uint8_t i = 0; i < cmd.count; i++) {
+        CtrlLayoutSegment seg;
+        memcpy(&seg, payload + sizeof(cmd) + i * sizeof(seg), sizeof(seg));
+        segments[i] = {seg.start, seg.length, seg.channel, seg.flags};
+      }
+      if (!sync.sendLayout(cmd.layoutID, segments, cmd.count)) return CTRL_ERR_VALUE;
+      return CTRL_OK;
+    }
+
+    case CTRL_GET_SYNC_STATUS: {
+      if (len != 0) return CTRL_ERR_LENGTH;
+      CtrlSyncStatus status;
+      status.groupID = sync.getGroupID();
+      status.isLeader = sync.isLeader();
+      status.channelMask = sync.getChannelMask();
+      status.foreignFrames = sync.getForeignFrameCount();
+      status.legacyFrames = sync.getLegacyFrameCount();
+      sendFrame(CTRL_SYNC_STATUS, reader.seq(), &status, sizeof(status));
+      return CTRL_OK;
+    }
+
+    default:
+      return CTRL_ERR_TYPE;
+  }
+}
+
+void SerialControl::sendEvents() {
+  uint32_t tail = eventTail.load(std::memory_order_relaxed);
+  while (tail != eventHead.load(std::memory_order_acquire)) {
+    const BeatEvent &queued = events[tail & (CONTROL_EVENT_QUEUE_SIZE - 1)];
+    CtrlBeatEvent event;
+    event.channel = queued.channel;
+    event.beatState = queued.beatState;
+    event.deviceMicros = queued.micros;
+    event.dropped = eventsDropped;
+
+    // Leave the rest queued if the TX buffer is full; the queue overflowing
+    // shows up in the dropped count
+    if (!sendFrame(CTRL_EVENT_BEAT, eventSeq, &event, sizeof(event))) break;
+    eventSeq++;
+    eventTail.store(++tail, std::memory_order_release);
+  }
+}
+
+// Never waits for the UART: returns false if the frame doesn't fit now
+bool SerialControl::sendFrame(uint8_t type, uint8_t seq, const void *payload, size_t len) {
+  uint8_t frame[CONTROL_FRAME_MAX_ENCODED];
+  size_t size = controlFrameEncode(type, seq, payload, len, frame);
+  if (size == 0 || (size_t)Serial.availableForWrite() < size) return false;
+  Serial.write(frame, size);
+  return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "ControlFrame.h"
+#include "MetronomeState.h"
+#include "Timing.h"
+#include "WirelessSync.h"
+#include "config.h"
+
+class CommandSystem;
+
+// Binary control and telemetry endpoint on the serial console (see
+// ControlFrame.h). Owns the UART receive side: COBS frames are handled
+// here, text bytes are passed on to a CommandSystem if one is attached.
+//
+// Commands are applied from loop() and acknowledged with the micros() at
+// which they took effect. Beat events are queued from the uClock callback
+// and streamed to subscribed hosts without ever blocking on the UART.
+class SerialControl {
+private:
+  struct BeatEvent {
+    uint8_t channel;
+    uint8_t beatState;
+    uint32_t micros;
+  };
+
+  static SerialControl *instance;
+
+  MetronomeState &state;
+  Timing &timing;
+  WirelessSync &sync;
+  CommandSystem *commands = nullptr;
+  ControlFrameReader reader;
+  uint32_t lastByteTime = 0;
+  uint8_t eventMask = 0;
+  uint8_t eventSeq = 0;
+
+  // Beat events, single producer (uClock) / single consumer (loop)
+  BeatEvent events[CONTROL_EVENT_QUEUE_SIZE];
+  std::atomic<uint32_t> eventHead{0};
+  std::atomic<uint32_t> eventTail{0};
+  std::atomic<uint32_t> eventsDropped{0};
+
+  // Statistics
+  uint32_t commandsHandled = 0;
+  uint32_t commandsRejected = 0;
+
+  static void onBeat(uint8_t channel, BeatState beatState);
+
+  void handleFrame();
+  uint8_t applyCommand(uint8_t type, const uint8_t *payload, size_t len);
+  void sendEvents();
+  bool sendFrame(uint8_t type, uint8_t seq, const void *payload, size_t len);
+
+public:
+  SerialControl(MetronomeState &state, Timing &timing, WirelessSync &sync);
+
+  // Start listening for beats (Serial must already be started)
+  void begin();
+
+  // Pass console text on to a command system
+  void setCommandSystem(CommandSystem *system) { commands = system; }
+
+  // Read received bytes, apply commands and stream events; call from loop()
+  void update();
+
+  uint32_t getCommandsHandled() const { return commandsHandled; }
+  uint32_t getCommandsRejected() const { return commandsRejected; }
+  uint32_t getCrcErrors() const { return reader.crcErrors(); }
+  uint32_t getFramingErrors() const { return reader.framingErrors(); }
+  uint32_t getEventsDropped() const { return eventsDropped; }
+};
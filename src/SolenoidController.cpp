@@ -1,16 +1,18 @@
 #include "SolenoidController.h"
+#include "Trace.h"
 
 // Initialize static member
 SolenoidController* SolenoidController::_instance = nullptr;
 
 // Implementation of the static callback function
-void IRAM_ATTR SolenoidController::endPulseCallback()
+void IRAM_ATTR SolenoidController::endPulseCallback(void *arg)
 {
   if (_instance)
   {
     digitalWrite(_instance->solenoidPin, LOW);
     digitalWrite(_instance->solenoidPin2, LOW);
     _instance->pulseActive = false;
+    TRACE(TRACE_PULSE_OFF);
   }
 }
 
@@ -19,6 +21,13 @@ void SolenoidController::init() {
     pinMode(solenoidPin2, OUTPUT);
     digitalWrite(solenoidPin, LOW);
     digitalWrite(solenoidPin2, LOW);
+
+    // One timer for the lifetime of the controller; Ticker::once() would
+    // create and delete an esp_timer (a heap allocation) on every beat
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = endPulseCallback;
+    timerArgs.name = "solenoid_pulse";
+    esp_timer_create(&timerArgs, &pulseTimer);
 }
 
 void SolenoidController::processBeat(uint8_t channel, BeatState beatState) {
@@ -26,9 +35,12 @@ void SolenoidController::processBeat(uint8_t channel, BeatState beatState) {
         digitalWrite((channel ? solenoidPin : solenoidPin2), HIGH);
 
         // Schedule turning off the solenoid after the appropriate duration
-        float pulseDuration = (beatState == ACCENT) ? (accentPulseMs / 1000.0f) : (weakPulseMs / 1000.0f);
+        uint32_t pulseDurationUs = ((beatState == ACCENT) ? accentPulseMs : weakPulseMs) * 1000;
 
-        pulseTicker.once(pulseDuration, endPulseCallback);
+        pulseActive = true;
+        esp_timer_stop(pulseTimer); // Restart if the previous pulse is still on
+        esp_timer_start_once(pulseTimer, pulseDurationUs);
+        TRACE(TRACE_PULSE_ON, channel, pulseDurationUs);
     }
 }
 
@@ -2,7 +2,7 @@
 #define SOLENOID_CONTROLLER_H
 
 #include <Arduino.h>
-#include <Ticker.h>
+#include <esp_timer.h>
 #include "MetronomeState.h"
 #include "config.h"
 
@@ -13,11 +13,11 @@ private:
   uint8_t solenoidPin2;
   uint16_t accentPulseMs;
   uint16_t weakPulseMs;
-  Ticker pulseTicker;
+  esp_timer_handle_t pulseTimer = nullptr;
   bool pulseActive = false;
 
   static SolenoidController *_instance;
-  static void IRAM_ATTR endPulseCallback(); // Just declaration, implementation in cpp
+  static void IRAM_ATTR endPulseCallback(void *arg); // Just declaration, implementation in cpp
 
 public:
   SolenoidController(uint8_t pin_1, uint8_t pin_2, uint16_t weakMs = SOLENOID_PULSE_MS, uint16_t accentMs = ACCENT_PULSE_MS)
@@ -28,6 +28,10 @@ public:
 
   ~SolenoidController()
   {
+    if (pulseTimer)
+    {
+      esp_timer_delete(pulseTimer);
+    }
     if (_instance == this)
     {
       _instance = nullptr;
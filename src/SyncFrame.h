@@ -0,0 +1,105 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Framing for byte-stream sync transports (RS-485 bus).
+// No Arduino dependencies so it can be built and exercised on the host.
+//
+//   [0xA5][0x5A][len][payload ...][crc16 hi][crc16 lo]
+//
+// The CRC (CRC-16/CCITT, init 0xFFFF) covers the length byte and the payload.
+
+#define SYNC_FRAME_SYNC1 0xA5
+#define SYNC_FRAME_SYNC2 0x5A
+#define SYNC_FRAME_MAX_PAYLOAD 64
+#define SYNC_FRAME_OVERHEAD 5  // 2 sync + 1 length + 2 CRC
+
+inline uint16_t syncFrameCrc16(uint16_t crc, const uint8_t *data, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t j = 0; j < 8; j++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+// Encode a payload into out (must hold len + SYNC_FRAME_OVERHEAD bytes).
+// Returns the encoded frame size, or 0 if the payload is too large.
+inline size_t syncFrameEncode(const uint8_t *payload, size_t len, uint8_t *out) {
+  if (len > SYNC_FRAME_MAX_PAYLOAD) return 0;
+  
+  out[0] = SYNC_FRAME_SYNC1;
+  out[1] = SYNC_FRAME_SYNC2;
+  out[2] = (uint8_t)len;
+  memcpy(&out[3], payload, len);
+  
+  uint16_t crc = syncFrameCrc16(0xFFFF, &out[2], len + 1);
+  out[3 + len] = crc >> 8;
+  out[4 + len] = crc & 0xFF;
+  return len + SYNC_FRAME_OVERHEAD;
+}
+
+// Incremental frame parser, fed one byte at a time from the receive path
+class SyncFrameParser {
+private:
+  enum State { WAIT_SYNC1, WAIT_SYNC2, WAIT_LEN, PAYLOAD, CRC_HI, CRC_LO };
+  
+  State _state = WAIT_SYNC1;
+  uint8_t _payload[SYNC_FRAME_MAX_PAYLOAD];
+  uint8_t _len = 0;
+  uint8_t _pos = 0;
+  uint16_t _rxCrc = 0;
+  uint32_t _crcErrors = 0;
+
+public:
+  // Feed one byte; returns true when a complete, CRC-valid frame is ready
+  bool feed(uint8_t b) {
+    switch (_state) {
+      case WAIT_SYNC1:
+        if (b == SYNC_FRAME_SYNC1) _state = WAIT_SYNC2;
+        break;
+      case WAIT_SYNC2:
+        _state = (b == SYNC_FRAME_SYNC2) ? WAIT_LEN :
+                 (b == SYNC_FRAME_SYNC1) ? WAIT_SYNC2 : WAIT_SYNC1;
+        break;
+      case WAIT_LEN:
+        if (b == 0 || b > SYNC_FRAME_MAX_PAYLOAD) {
+          _state = WAIT_SYNC1;
+        } else {
+          _len = b;
+          _pos = 0;
+          _state = PAYLOAD;
+        }
+        break;
+      case PAYLOAD:
+        _payload[_pos++] = b;
+        if (_pos == _len) _state = CRC_HI;
+        break;
+      case CRC_HI:
+        _rxCrc = (uint16_t)b << 8;
+        _state = CRC_LO;
+        break;
+      case CRC_LO: {
+        _rxCrc |= b;
+        _state = WAIT_SYNC1;
+        uint16_t crc = syncFrameCrc16(0xFFFF, &_len, 1);
+        crc = syncFrameCrc16(crc, _payload, _len);
+        if (crc == _rxCrc) return true;
+        _crcErrors++;
+        break;
+      }
+    }
+    return false;
+  }
+  
+  // True while no frame is in progress (waiting for the sync bytes)
+  bool isIdle() const { return _state == WAIT_SYNC1; }
+  
+  void reset() { _state = WAIT_SYNC1; }
+  
+  const uint8_t *payload() const { return _payload; }
+  uint8_t length() const { return _len; }
+  uint32_t crcErrors() const { return _crcErrors; }
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+
+// Transport backend used by WirelessSync to move SyncMessage frames.
+// ESP-NOW is the default; wired backends (RS-485) implement the same interface.
+class SyncTransport {
+public:
+  // Receive callback, same signature as the ESP-NOW receive callback.
+  // mac is the sender's device ID.
+  typedef void (*ReceiveCallback)(const uint8_t *mac, const uint8_t *data, int len);
+
+  virtual ~SyncTransport() {}
+
+  // Bring up the transport and start delivering frames to onReceive
+  virtual bool begin(ReceiveCallback onReceive) = 0;
+
+  // Broadcast one frame to every device on the transport
+  virtual bool send(const uint8_t *data, size_t len) = 0;
+
+  // Human-readable backend name for logs
+  virtual const char *getName() const = 0;
+};
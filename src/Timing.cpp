@@ -2,6 +2,7 @@
 #include "SolenoidController.h"
 #include "AudioController.h"
 #include "Display.h"
+#include "Trace.h"
 
 // Initialize static instance pointer
 Timing* Timing::instance = nullptr;
@@ -14,9 +15,33 @@ void Timing::onClockPulseStatic(uint32_t tick) {
 }
 
 void Timing::onSync24Static(uint32_t tick) {
-    if (instance && instance->wirelessSync.isInitialized()) {
+    if (!instance) {
+        return;
+    }
+    if (instance->wirelessSync.isInitialized()) {
         instance->wirelessSync.onSync24(tick);
     }
+    if (tick % 24 == 0) {
+        uint32_t seq = instance->anchorSeq.load(std::memory_order_relaxed);
+        instance->anchorSeq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        instance->anchorBeat.store(tick / 24, std::memory_order_relaxed);
+        instance->anchorMicros.store(micros(), std::memory_order_relaxed);
+        instance->anchorSeq.store(seq + 2, std::memory_order_release);
+    }
+    if (instance->clockListener) {
+        instance->clockListener(tick);
+    }
+}
+
+void Timing::getBeatAnchor(uint32_t& beat, uint32_t& beatMicros) const {
+    uint32_t seq;
+    do {
+        seq = anchorSeq.load(std::memory_order_acquire);
+        beat = anchorBeat.load(std::memory_order_relaxed);
+        beatMicros = anchorMicros.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != anchorSeq.load(std::memory_order_relaxed));
 }
 
 void Timing::onPPQNStatic(uint32_t tick) {
@@ -101,8 +126,12 @@ void Timing::update() {
 }
 
 void Timing::onBeatEvent(uint8_t channel, BeatState beatState) {
+    TRACE(TRACE_BEAT, channel, beatState);
     solenoidController.processBeat(channel, beatState);
     audioController.processBeat(channel, beatState);
+    if (beatListener) {
+        beatListener(channel, beatState);
+    }
 }
 
 void Timing::onClockPulse(uint32_t tick) {
@@ -127,7 +156,7 @@ void Timing::onClockPulse(uint32_t tick) {
     
     // For polyrhythm, use the precise timing method for channel 2
     // This is the ONLY place where channel 2 beats are processed in polyrhythm mode
-    if (isPolyrhythm && state.getChannel(1).isEnabled()) {
+    if (isPolyrhythm && state.getChannel(1).isEnabled() && wirelessSync.playsChannel(1)) {
         // Check if this tick should trigger a beat for channel 2 based on its polyrhythm subdivision
         BeatState ch2State = state.getChannel(1).getPolyrhythmBeatState(tick, state);
         if (ch2State != SILENT) {
@@ -148,6 +177,11 @@ void Timing::onClockPulse(uint32_t tick) {
                 if (channel.isEnabled()) {
                     channel.updateBeat(quarterNoteTick);
 
+                    // Channels assigned to other devices only advance for display
+                    if (!wirelessSync.playsChannel(i)) {
+                        continue;
+                    }
+
                     BeatState currentState = channel.getBeatState();
                     if (currentState != SILENT) {
                         onBeatEvent(i, currentState);
@@ -161,7 +195,7 @@ void Timing::onClockPulse(uint32_t tick) {
             if (channel1.isEnabled()) {
                 channel1.updateBeat(quarterNoteTick);
 
-                BeatState currentState = channel1.getBeatState();
+                BeatState currentState = wirelessSync.playsChannel(0) ? channel1.getBeatState() : SILENT;
                 if (currentState != SILENT) {
                     onBeatEvent(0, currentState);
                 }
@@ -196,6 +230,41 @@ void Timing::pause() {
     uClock.pause();
 }
 
+void Timing::play() {
+    if (state.isRunning) {
+        return;
+    }
+    bool resume = state.isPaused;
+    state.isRunning = true;
+    state.isPaused = false;
+    if (resume) {
+        pause(); // pause() toggles between pause and resume
+    } else {
+        start();
+    }
+}
+
+void Timing::pausePlayback() {
+    if (state.isRunning && !state.isPaused) {
+        state.isRunning = false;
+        state.isPaused = true;
+        pause();
+    }
+}
+
+void Timing::togglePlayback() {
+    if (state.isRunning) {
+        pausePlayback();
+    } else {
+        play();
+    }
+}
+
+void Timing::stopPlayback() {
+    state.resetPlayback();
+    stop();
+}
+
 void Timing::setTempo(uint16_t bpm) {
     uClock.setTempo(bpm);
 } 
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <Arduino.h>
 #include <uClock.h>
+#include <atomic>
 #include "MetronomeState.h"
 #include "WirelessSync.h"
 
@@ -10,12 +11,25 @@ class AudioController;
 class Display;
 
 class Timing {
+public:
+    // Called for every beat fired, in uClock callback context
+    typedef void (*BeatListener)(uint8_t channel, BeatState beatState);
+    // Called on every uClock Sync24 pulse (24 per quarter note), same context
+    typedef void (*ClockListener)(uint32_t tick);
+    
 private:
     MetronomeState& state;
     WirelessSync& wirelessSync;
     SolenoidController& solenoidController;
     AudioController& audioController;
     Display* display;
+    BeatListener beatListener = nullptr;
+    ClockListener clockListener = nullptr;
+    
+    // Latest quarter-note pulse; seqlock, written in uClock callback context
+    std::atomic<uint32_t> anchorSeq{0};
+    std::atomic<uint32_t> anchorBeat{0};
+    std::atomic<uint32_t> anchorMicros{0};
     
     // Track previous running state to detect changes
     bool previousRunningState = false;
@@ -55,6 +69,22 @@ public:
     void stop();
     void pause();
     
+    // Transport as the buttons and remote controls see it, keeping
+    // state.isRunning/isPaused in step with the clock
+    void play();            // Start when stopped, resume when paused
+    void pausePlayback();   // Pause when running
+    void togglePlayback();  // Play, or pause when running
+    void stopPlayback();    // Stop and rewind to the first beat
+    
     // Set tempo
     void setTempo(uint16_t bpm);
+    
+    // Observe fired beats (one listener; nullptr removes it)
+    void setBeatListener(BeatListener listener) { beatListener = listener; }
+    
+    // Observe Sync24 pulses (one listener; nullptr removes it)
+    void setClockListener(ClockListener listener) { clockListener = listener; }
+    
+    // Quarter note count since start and micros() of the latest beat pulse
+    void getBeatAnchor(uint32_t& beat, uint32_t& beatMicros) const;
 }; 
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "Trace.h"
+#include "ControlFrame.h"
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+// Records per serial frame
+#define TRACE_RECORDS_PER_FRAME (CONTROL_FRAME_MAX_PAYLOAD / sizeof(TraceRecord))
+
+Trace::Slot Trace::slots[TRACE_RING_SIZE];
+std::atomic<uint32_t> Trace::head{0};
+
+void Trace::begin() {
+  xTaskCreatePinnedToCore(drainTask, "trace_drain", 3072, nullptr, 1, nullptr, 0);
+}
+
+void Trace::drainTask(void *arg) {
+  uint32_t tail = 0;
+  uint32_t lost = 0;
+  uint8_t frameSeq = 0;
+  TraceRecord batch[TRACE_RECORDS_PER_FRAME];
+  uint8_t frame[CONTROL_FRAME_MAX_ENCODED];
+
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(TRACE_DRAIN_MS));
+
+    for (;;) {
+      // Skip whatever the producers have already overwritten
+      uint32_t h = head.load(std::memory_order_acquire);
+      if (h - tail > TRACE_RING_SIZE) {
+        lost += h - tail - TRACE_RING_SIZE;
+        tail = h - TRACE_RING_SIZE;
+      }
+
+      size_t count = 0;
+      if (lost) {
+        batch[count++] = {(uint32_t)esp_timer_get_time(), TRACE_LOST, (uint8_t)xPortGetCoreID(), 0, lost};
+      }
+
+      uint32_t next = tail;
+      uint32_t skipped = 0;
+      while (count < TRACE_RECORDS_PER_FRAME && next != h) {
+        Slot &slot = slots[next & (TRACE_RING_SIZE - 1)];
+        uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != next + 1) {
+          if (seq > next + 1) {
+            skipped++;     // Overwritten by a newer record
+            next++;
+            continue;
+          }
+          break;           // Still being written
+        }
+        TraceRecord record = slot.record;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+          skipped++;       // Overwritten while copying
+        } else {
+          batch[count++] = record;
+        }
+        next++;
+      }
+      // Date the loss at the gap it left, to keep the stream in time order
+      if (lost && count > 1) batch[0].time = batch[1].time;
+      if (count == 0) {
+        lost += skipped;
+        tail = next;
+        break;
+      }
+
+      size_t size = controlFrameEncode(CTRL_EVENT_TRACE, frameSeq, batch,
+                                       count * sizeof(TraceRecord), frame);
+      if ((size_t)Serial.availableForWrite() < size) break;  // Retry next round
+      Serial.write(frame, size);
+      frameSeq++;
+      tail = next;
+      lost = skipped;
+    }
+  }
+}
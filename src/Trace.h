@@ -0,0 +1,81 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <atomic>
+#include "config.h"
+
+// Event trace for timing debugging without Serial prints in the timed path.
+//
+// TRACE() stores a compact timestamped record in a lock-free ring; it is safe
+// from any task, timer callback or ISR on either core and costs one atomic
+// add, a timer read and a 12-byte store. A low-priority task drains the ring
+// as COBS frames (CTRL_EVENT_TRACE, see ControlFrame.h) on the serial console;
+// tools/trace/trace_to_json.py turns a capture into Chrome/Perfetto JSON.
+// When the drain falls behind, the oldest records are overwritten and the
+// loss is reported as a TRACE_LOST record.
+
+enum TraceEvent : uint8_t {
+  TRACE_BEAT = 1,      // a16 = channel, a32 = BeatState
+  TRACE_PULSE_ON,      // a16 = channel, a32 = pulse length (us)
+  TRACE_PULSE_OFF,
+  TRACE_TX,            // a16 = message type, a32 = sequence number
+  TRACE_RX,            // a16 = message type, a32 = sequence number
+  TRACE_SAVE,          // a32 = 1 if saved
+  TRACE_LOAD,          // a32 = 1 if loaded
+  TRACE_FRAME,         // a32 = display render + send time (us)
+  TRACE_EUCLID,        // a16 = active beats << 8 | bar length, a32 = pattern
+  TRACE_RESET,         // a16 = TraceReset, a32 = value
+  TRACE_LOST           // a32 = records overwritten before they were drained
+};
+
+enum TraceReset : uint16_t {
+  TRACE_RESET_BPM = 0,
+  TRACE_RESET_PATTERNS = 1,
+  TRACE_RESET_CHANNEL = 2,  // a32 = channel
+  TRACE_RESET_STORAGE = 3
+};
+
+// One record as sent to the host (little-endian, 12 bytes)
+struct __attribute__((packed)) TraceRecord {
+  uint32_t time;       // esp_timer microseconds (low 32 bits)
+  uint8_t event;       // TraceEvent
+  uint8_t core;
+  uint16_t a16;
+  uint32_t a32;
+};
+
+class Trace {
+private:
+  // seq is index + 1 once the record is complete, 0 while it is written
+  struct Slot {
+    std::atomic<uint32_t> seq;
+    TraceRecord record;
+  };
+
+  static Slot slots[TRACE_RING_SIZE];
+  static std::atomic<uint32_t> head;
+
+  static void drainTask(void *arg);
+
+public:
+  static inline void emit(TraceEvent event, uint16_t a16 = 0, uint32_t a32 = 0) {
+    uint32_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots[index & (TRACE_RING_SIZE - 1)];
+    slot.seq.store(0, std::memory_order_relaxed);
+    slot.record.time = (uint32_t)esp_timer_get_time();
+    slot.record.event = event;
+    slot.record.core = xPortGetCoreID();
+    slot.record.a16 = a16;
+    slot.record.a32 = a32;
+    slot.seq.store(index + 1, std::memory_order_release);
+  }
+
+  // Start the drain task (Serial must already be started)
+  static void begin();
+};
+
+#if ENABLE_TRACE
+#define TRACE(...) Trace::emit(__VA_ARGS__)
+#else
+#define TRACE(...) do {} while (0)
+#endif
@@ -1,10 +1,29 @@
 #include "WirelessSync.h"
+#include "Trace.h"
 
 // Static instance pointer for callback
 static WirelessSync* wirelessSyncInstance = nullptr;
 
 // Static callback function for ESP-NOW
 void WirelessSync::onDataReceived(const uint8_t *mac, const uint8_t *data, int len) {
+  // Drop other groups' traffic before any other work (one compare)
+  if (wirelessSyncInstance) {
+    uint16_t groupID = 0;
+    if (len >= (int)sizeof(groupID)) {
+      memcpy(&groupID, data, sizeof(groupID));
+    }
+    if (groupID != wirelessSyncInstance->_groupID) {
+      // Frames without a group field carry their type here; our own group
+      // is never in the reserved range, so this is off the fast path
+      if (groupID <= SYNC_GROUP_RESERVED_MAX) {
+        wirelessSyncInstance->_legacyFrames++;
+      } else {
+        wirelessSyncInstance->_foreignFrames++;
+      }
+      return;
+    }
+  }
+  
   if (len != sizeof(SyncMessage)) {
     Serial.println("Invalid message size");
     return;
@@ -17,6 +36,7 @@ void WirelessSync::onDataReceived(const uint8_t *mac, const uint8_t *data, int l
   if (wirelessSyncInstance && memcmp(msg->deviceID, wirelessSyncInstance->_deviceID, 6) == 0) {
     return;
   }
+  TRACE(TRACE_RX, msg->type, msg->sequenceNum);
   
   // Update latency tracking
   if (wirelessSyncInstance) {
@@ -59,9 +79,11 @@ void WirelessSync::onDataReceived(const uint8_t *mac, const uint8_t *data, int l
     case MSG_PATTERN:
       // Process pattern message (for followers)
       if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader) {
-        // Get channel ID and validate
+        // Get channel ID and validate; patterns for channels assigned to
+        // other devices are dropped here, before touching the state
         uint8_t channelId = msg->data.pattern.channelId;
-        if (channelId < MetronomeState::CHANNEL_COUNT) {
+        if (channelId < MetronomeState::CHANNEL_COUNT &&
+            wirelessSyncInstance->playsChannel(channelId)) {
           // Update pattern in state
           MetronomeChannel &channel = wirelessSyncInstance->_state->getChannel(channelId);
           channel.setPattern(msg->data.pattern.pattern);
@@ -83,6 +105,17 @@ void WirelessSync::onDataReceived(const uint8_t *mac, const uint8_t *data, int l
       }
       break;
       
+    case MSG_ASSIGN:
+      // Apply the channel assignment if it targets us (or every device)
+      if (wirelessSyncInstance && !wirelessSyncInstance->_isLeader) {
+        static const uint8_t broadcastID[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+        if (memcmp(msg->data.assign.targetID, wirelessSyncInstance->_deviceID, 6) == 0 ||
+            memcmp(msg->data.assign.targetID, broadcastID, 6) == 0) {
+          wirelessSyncInstance->_channelMask = msg->data.assign.channelMask;
+        }
+      }
+      break;
+      
     default:
       // Other message types handled by specific implementations
       break;
@@ -93,35 +126,17 @@ bool WirelessSync::init() {
   // Set static instance for callback at initialization
   wirelessSyncInstance = this;
   
-  // Set device in station mode
-  WiFi.mode(WIFI_STA);
-  
   // Get MAC address
   WiFi.macAddress(_deviceID);
   
-  // Initialize ESP-NOW
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("Error initializing ESP-NOW");
+  // Initialize the transport and register our receive callback
+  if (!_transport->begin(onDataReceived)) {
+    Serial.printf("Error initializing %s sync transport\n", _transport->getName());
     _initialized = false;
     return false;
   }
   
-  // Register callback
-  esp_now_register_recv_cb(onDataReceived);
-  
-  // Register peer (broadcast address)
-  esp_now_peer_info_t peerInfo = {};
-  memcpy(peerInfo.peer_addr, _broadcastAddress, 6);
-  peerInfo.channel = 0;
-  peerInfo.encrypt = false;
-  
-  if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-    Serial.println("Failed to add peer");
-    _initialized = false;
-    return false;
-  }
-  
-  Serial.println("ESP-NOW initialized successfully");
+  Serial.printf("%s sync initialized successfully\n", _transport->getName());
   Serial.print("MAC Address: ");
   for (int i = 0; i < 6; i++) {
     Serial.print(_deviceID[i], HEX);
@@ -139,17 +154,17 @@ void WirelessSync::setAsLeader(bool isLeader) {
 
 void WirelessSync::sendMessage(SyncMessage &msg) {
   // Fill common fields
+  msg.groupID = _groupID;
   msg.sequenceNum = _sequenceNum++;
   msg.priority = _priority;
   memcpy(msg.deviceID, _deviceID, 6);
   _lastSendTime = micros(); // Track send time
   msg.timestamp = _lastSendTime; // Use actual send time
+  TRACE(TRACE_TX, msg.type, msg.sequenceNum);
   
   // Send message
-  esp_err_t result = esp_now_send(_broadcastAddress, (uint8_t *)&msg, sizeof(SyncMessage));
-  
-  if (result != ESP_OK) {
-    Serial.println("Error sending ESP-NOW message");
+  if (!_transport->send((uint8_t *)&msg, sizeof(SyncMessage))) {
+    Serial.printf("Error sending %s message\n", _transport->getName());
   }
 }
 
@@ -286,6 +301,123 @@ void WirelessSync::sendControl(uint8_t command, uint32_t value) {
   sendMessage(msg);
 }
 
+// Map a device to the channels it should play (leader side)
+bool WirelessSync::assignChannels(const uint8_t *deviceID, uint16_t channelMask) {
+  // Our own entry is applied locally, never broadcast
+  if (memcmp(deviceID, _deviceID, 6) == 0) {
+    _channelMask = channelMask;
+    return true;
+  }
+  
+  // Update an existing entry for this device
+  for (uint8_t i = 0; i < _assignmentCount; i++) {
+    if (memcmp(_assignments[i].deviceID, deviceID, 6) == 0) {
+      _assignments[i].channelMask = channelMask;
+      _assignmentsChanged = true;
+      return true;
+    }
+  }
+  
+  if (_assignmentCount >= MAX_CHANNEL_ASSIGNMENTS) {
+    Serial.println("Channel assignment table full");
+    return false;
+  }
+  
+  memcpy(_assignments[_assignmentCount].deviceID, deviceID, 6);
+  _assignments[_assignmentCount].channelMask = channelMask;
+  _assignmentCount++;
+  _assignmentsChanged = true;
+  return true;
+}
+
+// Drop all assignments; every device goes back to playing all channels
+void WirelessSync::clearChannelAssignments() {
+  _assignmentCount = 0;
+  _assignmentsChanged = false;
+  _channelMask = CHANNEL_MASK_ALL;
+  
+  SyncMessage msg;
+  msg.type = MSG_ASSIGN;
+  memcpy(msg.data.assign.targetID, _broadcastAddress, 6);
+  msg.data.assign.channelMask = CHANNEL_MASK_ALL;
+  memset(msg.data.assign.reserved, 0, sizeof(msg.data.assign.reserved));
+  
+  sendMessage(msg);
+  
+  // Every follower now accepts every channel again
+  if (_state) {
+    sendPatterns(*_state, CHANNEL_MASK_ALL);
+  }
+}
+
+void WirelessSync::sendAssignments() {
+  for (uint8_t i = 0; i < _assignmentCount; i++) {
+    SyncMessage msg;
+    msg.type = MSG_ASSIGN;
+    memcpy(msg.data.assign.targetID, _assignments[i].deviceID, 6);
+    msg.data.assign.channelMask = _assignments[i].channelMask;
+    memset(msg.data.assign.reserved, 0, sizeof(msg.data.assign.reserved));
+    
+    sendMessage(msg);
+  }
+  _lastAssignmentSend = millis();
+  
+  // Followers drop patterns for channels they didn't own when the pattern
+  // was sent, so resend the assigned channels' patterns after the map
+  if (_state) {
+    uint16_t assigned = 0;
+    for (uint8_t i = 0; i < _assignmentCount; i++) {
+      assigned |= _assignments[i].channelMask;
+    }
+    sendPatterns(*_state, assigned);
+  }
+}
+
+void WirelessSync::sendPatterns(MetronomeState &state, uint16_t channelMask) {
+  for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
+    if ((channelMask >> i) & 1) {
+      sendPattern(state, i);
+    }
+  }
+}
+
+// Receivers apply a layout once every segment of it has arrived
+bool WirelessSync::sendLayout(uint16_t layoutID, const LedSegment *segments, uint8_t count) {
+  if (count == 0 || count > MAX_LAYOUT_SEGMENTS) {
+    Serial.println("Invalid LED layout segment count");
+    return false;
+  }
+  
+  // Receivers reject these too; don't send a layout nobody will apply
+  for (uint8_t i = 0; i < count; i++) {
+    const LedSegment &seg = segments[i];
+    if (seg.length == 0) return false;
+    for (uint8_t j = 0; j < i; j++) {
+      const LedSegment &other = segments[j];
+      if (seg.start < other.start + other.length && other.start < seg.start + seg.length) {
+        Serial.println("Overlapping LED layout segments");
+        return false;
+      }
+    }
+  }
+  
+  for (uint8_t i = 0; i < count; i++) {
+    SyncMessage msg;
+    msg.type = MSG_LAYOUT;
+    msg.data.layout.layoutID = layoutID;
+    msg.data.layout.segmentIndex = i;
+    msg.data.layout.segmentCount = count;
+    msg.data.layout.start = segments[i].start;
+    msg.data.layout.length = segments[i].length;
+    msg.data.layout.channel = segments[i].channel;
+    msg.data.layout.flags = segments[i].flags;
+    memset(msg.data.layout.reserved, 0, sizeof(msg.data.layout.reserved));
+    
+    sendMessage(msg);
+  }
+  return true;
+}
+
 void WirelessSync::notifyPatternChanged(uint8_t channelId) {
   _patternChanged = true;
 }
@@ -298,21 +430,33 @@ void WirelessSync::update(MetronomeState &state) {
     _patternChanged = false;
     
     // Send updated pattern info for all channels
-    for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
-      sendPattern(state, i);
-    }
+    sendPatterns(state, CHANNEL_MASK_ALL);
+  }
+  
+  // Send channel assignments when they change, and periodically so that
+  // late-joining followers pick up their channels
+  if (_isLeader && _assignmentCount > 0 &&
+      (_assignmentsChanged || millis() - _lastAssignmentSend > ASSIGNMENT_RESEND_MS)) {
+    _assignmentsChanged = false;
+    sendAssignments();
   }
   
   // If we're the leader and just started, send initial patterns
   static bool initialPatternsSent = false;
   if (_isLeader && !initialPatternsSent) {
     initialPatternsSent = true;
-    for (uint8_t i = 0; i < MetronomeState::CHANNEL_COUNT; i++) {
-      sendPattern(state, i);
-    }
+    sendPatterns(state, CHANNEL_MASK_ALL);
   }
 }
 
+bool WirelessSync::setGroupID(uint16_t groupID) {
+  if (groupID <= SYNC_GROUP_RESERVED_MAX) {
+    return false;
+  }
+  _groupID = groupID;
+  return true;
+}
+
 // Set device priority (higher value = higher priority)
 void WirelessSync::setPriority(uint8_t priority) {
   _priority = priority;
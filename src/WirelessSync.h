@@ -1,10 +1,12 @@
 #pragma once
 
 #include <Arduino.h>
-#include <esp_now.h>
 #include <WiFi.h>
 #include <uClock.h>
 #include "MetronomeState.h"
+#include "SyncTransport.h"
+#include "EspNowTransport.h"
+#include "config.h"
 
 // Message types for our sync protocol
 typedef enum {
@@ -12,11 +14,43 @@ typedef enum {
   MSG_BEAT = 1,
   MSG_BAR = 2,
   MSG_CONTROL = 3,
-  MSG_PATTERN = 4
+  MSG_PATTERN = 4,
+  MSG_ASSIGN = 5,
+  MSG_LAYOUT = 6
 } MessageType;
 
+// Channel mask meaning "play every channel" (no assignment received yet)
+#define CHANNEL_MASK_ALL 0xFFFF
+
+// Maximum number of devices the leader can hand channel assignments to
+#define MAX_CHANNEL_ASSIGNMENTS 8
+
+// Interval at which the leader re-broadcasts channel assignments (ms)
+#define ASSIGNMENT_RESEND_MS 2000
+
+// Group IDs up to this value are never used: frames from firmware without
+// the group field start with the message type (0-4), little-endian, and
+// would otherwise read as one of these groups
+#define SYNC_GROUP_RESERVED_MAX 0x00FF
+
+static_assert(SYNC_GROUP_ID > SYNC_GROUP_RESERVED_MAX, "SYNC_GROUP_ID is reserved");
+
+// LED layout segments (MSG_LAYOUT, one segment per message)
+#define MAX_LAYOUT_SEGMENTS 8
+#define LAYOUT_SEGMENT_TEMPO 0xFF   // Segment shows the beat rather than a channel
+#define LAYOUT_SEGMENT_REVERSE 0x01 // Segment runs from its last LED to its first
+
+// One segment of an LED receiver layout
+struct LedSegment {
+  uint16_t start;    // First LED on the receiver's strip(s)
+  uint16_t length;   // Number of LEDs
+  uint8_t channel;   // Channel shown, or LAYOUT_SEGMENT_TEMPO
+  uint8_t flags;     // LAYOUT_SEGMENT_REVERSE
+};
+
 // Main message structure for ESP-NOW sync
 typedef struct {
+  uint16_t groupID;           // Sync group/session ID, checked first (2 bytes)
   MessageType type;           // Message type (1 byte)
   uint8_t deviceID[6];        // MAC address of sender (6 bytes)
   uint32_t sequenceNum;       // Sequence number (4 bytes)
@@ -67,6 +101,25 @@ typedef struct {
       uint8_t param3;         // Parameter 3 (1 byte)
       uint32_t value;         // Command value (4 bytes)
     } control;
+    
+    // ASSIGN data (channel-to-device map entry)
+    struct {
+      uint8_t targetID[6];    // MAC address of the assigned device (6 bytes)
+      uint16_t channelMask;   // Bit mask of channels the device plays (2 bytes)
+      uint8_t reserved[4];    // Reserved (4 bytes)
+    } assign;
+    
+    // LAYOUT data (one LED receiver layout segment)
+    struct {
+      uint16_t layoutID;      // Layout version; segments of one layout share it (2 bytes)
+      uint8_t segmentIndex;   // Index of this segment (1 byte)
+      uint8_t segmentCount;   // Number of segments in the layout (1 byte)
+      uint16_t start;         // First LED (2 bytes)
+      uint16_t length;        // Number of LEDs (2 bytes)
+      uint8_t channel;        // Channel shown, or LAYOUT_SEGMENT_TEMPO (1 byte)
+      uint8_t flags;          // LAYOUT_SEGMENT_REVERSE (1 byte)
+      uint8_t reserved[2];    // Reserved (2 bytes)
+    } layout;
   } data;
 } SyncMessage;
 
@@ -81,12 +134,21 @@ enum ControlCommand {
 class WirelessSync {
 private:
   uint8_t _broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+  
+  // Transport backend (ESP-NOW unless replaced before init())
+  EspNowTransport _espNowTransport;
+  SyncTransport* _transport;
   uint8_t _deviceID[6];
   uint32_t _sequenceNum;
   uint8_t _priority;
   bool _isLeader;
   bool _initialized;
   
+  // Sync group filtering
+  uint16_t _groupID;
+  volatile uint32_t _foreignFrames;  // Frames dropped for another group
+  volatile uint32_t _legacyFrames;   // Frames dropped for having no group ID
+  
   // Track which sync messages have been sent
   uint32_t _lastSync24Tick;
   uint32_t _lastQuarterNote;
@@ -115,6 +177,19 @@ private:
   // State reference for pattern updates
   MetronomeState* _state;
   
+  // Channel assignment: channels this device compiles into its timeline
+  volatile uint16_t _channelMask;
+  
+  // Leader-side channel-to-device map
+  struct ChannelAssignment {
+    uint8_t deviceID[6];
+    uint16_t channelMask;
+  };
+  ChannelAssignment _assignments[MAX_CHANNEL_ASSIGNMENTS];
+  uint8_t _assignmentCount;
+  bool _assignmentsChanged;
+  uint32_t _lastAssignmentSend;
+  
   // Helper functions for pattern length calculations
   uint16_t lcm(uint16_t a, uint16_t b);
   uint16_t gcd(uint16_t a, uint16_t b);
@@ -138,10 +213,14 @@ private:
 public:
   // Constructor initialization
   WirelessSync() : 
+      _transport(&_espNowTransport),
       _sequenceNum(0),
       _priority(1),
       _isLeader(false),
       _initialized(false),
+      _groupID(SYNC_GROUP_ID),
+      _foreignFrames(0),
+      _legacyFrames(0),
       _lastSync24Tick(0),
       _lastQuarterNote(0),
       _lastBarStart(0),
@@ -156,14 +235,22 @@ public:
       _lastReceivedTick(0),
       _predictedNextTick(0),
       _driftCorrection(1.0f),
-      _state(nullptr)
+      _state(nullptr),
+      _channelMask(CHANNEL_MASK_ALL),
+      _assignmentCount(0),
+      _assignmentsChanged(false),
+      _lastAssignmentSend(0)
   {
       memset(_currentLeaderID, 0, sizeof(_currentLeaderID));
       memset(_highestPriorityDevice, 0, sizeof(_highestPriorityDevice));
       memset(_latencyBuffer, 0, sizeof(_latencyBuffer));
+      memset(_assignments, 0, sizeof(_assignments));
   }
   
-  // Initialize ESP-NOW
+  // Select the transport backend (call before init(); defaults to ESP-NOW)
+  void setTransport(SyncTransport* transport) { _transport = transport; }
+  
+  // Initialize the transport
   bool init();
   
   // Check if wireless sync is initialized
@@ -175,6 +262,13 @@ public:
   // Set device priority (higher value = higher priority)
   void setPriority(uint8_t priority);
   
+  // Sync group: only frames carrying the same group ID are processed.
+  // Returns false for a reserved ID (<= SYNC_GROUP_RESERVED_MAX).
+  bool setGroupID(uint16_t groupID);
+  uint16_t getGroupID() const { return _groupID; }
+  uint32_t getForeignFrameCount() const { return _foreignFrames; }
+  uint32_t getLegacyFrameCount() const { return _legacyFrames; }
+  
   // Check if this device is currently the leader
   bool isLeader() const;
   
@@ -194,10 +288,24 @@ public:
   
   // Send pattern definition
   void sendPattern(MetronomeState &state, uint8_t channelId);
+  void sendPatterns(MetronomeState &state, uint16_t channelMask);
   
   // Send control message
   void sendControl(uint8_t command, uint32_t value = 0);
   
+  // Channel assignment (leader side): map a device to the channels it plays
+  bool assignChannels(const uint8_t *deviceID, uint16_t channelMask);
+  void clearChannelAssignments();
+  void sendAssignments();
+  
+  // LED receiver layout (leader side): broadcast all segments of a layout.
+  // Returns false (nothing sent) for empty or overlapping segments.
+  bool sendLayout(uint16_t layoutID, const LedSegment *segments, uint8_t count);
+  
+  // Channel assignment (all devices): does this device play the channel?
+  bool playsChannel(uint8_t channelId) const { return (_channelMask >> channelId) & 1; }
+  uint16_t getChannelMask() const { return _channelMask; }
+  
   // Handle pattern changes from the metronome state
   void notifyPatternChanged(uint8_t channelId);
   
@@ -45,5 +45,67 @@
 #define CONFIG_VERSION 1
 #define CONFIG_MAGIC_MARKER 0xCBEF // Magic bytes to verify config integrity
 
+// Wireless sync group ID (devices only follow leaders in the same group).
+// Default only: the ID set over serial control is stored in flash.
+// 0x0000-0x00FF are reserved, see SYNC_GROUP_RESERVED_MAX.
+#define SYNC_GROUP_ID 0x0100
+
+// Wired sync bus (UART + RS-485 transceiver) as an alternative to ESP-NOW
+#define SYNC_TRANSPORT_RS485 0          // 1 = use the RS-485 bus instead of ESP-NOW
+#define RS485_UART_NUM UART_NUM_2
+#define RS485_TX_PIN 27
+#define RS485_RX_PIN 14
+#define RS485_DE_PIN 13                 // Transceiver driver enable (UART RTS)
+#define RS485_BAUD 1000000
+#define RS485_CABLE_LENGTH_M 10         // Bus length used for line delay compensation
+#define RS485_PROPAGATION_NS_PER_M 5    // Signal propagation in twisted pair
+#define RS485_TX_LATENCY_NS 20000       // Sender stamp-to-start-bit latency
+
+// OSC control server over UDP (joins the show-control WiFi network)
+#define ENABLE_OSC 0                    // 1 = start the OSC server
+#define OSC_WIFI_SSID ""
+#define OSC_WIFI_PASSWORD ""
+#define OSC_PORT 8000
+#define OSC_NTP_SERVER "pool.ntp.org"   // SNTP server for bundle timetags (e.g. the show controller)
+#define OSC_RX_BUFFER_SIZE 1536         // One UDP datagram, parsed in place
+#define OSC_MAX_PENDING 16              // Bundle messages waiting for their timetag; more are dropped
+#define OSC_MAX_PACKETS_PER_UPDATE 32   // Packets drained per loop() pass
+#define OSC_MAX_SCHEDULE_AHEAD_MS 10000 // Timetags further ahead are clamped
+
+// Binary control/telemetry protocol on the serial console (test rigs)
+#define ENABLE_SERIAL_CONTROL 0         // 1 = accept COBS frames on Serial
+#define SERIAL_CONTROL_BAUD 921600      // Console baud rate when enabled
+#define CONTROL_MAX_BYTES_PER_UPDATE 512
+#define CONTROL_EVENT_QUEUE_SIZE 32     // Beat events (power of two)
+#define CONTROL_FRAME_TIMEOUT_MS 50     // Drop a partial frame after this gap
+
+// BLE-MIDI control and clock output (see BleMidiControl.h), alongside ESP-NOW
+#define ENABLE_BLE_MIDI 0               // 1 = start the BLE-MIDI server
+#define BLE_MIDI_NAME "Metronome"
+#define BLE_MIDI_CONTROL_CHANNEL 15     // MIDI channel (1-16) for incoming CC/NRPN
+#define BLE_MIDI_STATUS_CHANNEL 16      // MIDI channel (1-16) for parameter echoes
+#define BLE_MIDI_CLOCK_OUTPUT 0         // 1 = send MIDI clock from boot
+#define BLE_MIDI_CONTROL_QUEUE_SIZE 32  // Decoded commands (power of two)
+#define BLE_MIDI_CLOCK_QUEUE_SIZE 64    // Sync24 pulses waiting for loop() (power of two)
+
+// Connectionless beat broadcast in BLE advertising (see BleBeatBroadcast.h)
+#define ENABLE_BLE_BEAT_BROADCAST 0     // 1 = the leader advertises its timeline anchor
+#define BLE_BEAT_COMPANY_ID 0xFFFF      // Manufacturer data company ID (0xFFFF = none/testing)
+#define BLE_BEAT_ADV_INTERVAL_MS 100    // Legacy or extended advertising interval
+#define BLE_BEAT_PERIODIC_INTERVAL_MS 50 // Periodic advertising interval (extended advertising builds)
+#define BLE_BEAT_ADV_INSTANCE 0         // Extended advertising instance
+#define BLE_BEAT_ADV_SID 1              // Advertising set ID receivers sync to
+
+// Event trace (see Trace.h), drained as binary frames on the serial console
+#define ENABLE_TRACE 0                  // 1 = record and stream trace events
+#define TRACE_RING_SIZE 1024            // Records (power of two)
+#define TRACE_DRAIN_MS 20               // Drain task period
+
+// Heap monitor (see HeapMonitor.h): report allocations made after setup()
+#ifndef ENABLE_HEAP_MONITOR
+#define ENABLE_HEAP_MONITOR 0           // Set by the esp32dev-heapmon env with its linker wraps
+#endif
+#define HEAP_REPORT_MS 10000            // Status line period
+
 // Fixed number of channels (for now)
 #define FIXED_CHANNEL_COUNT 2
@@ -11,7 +11,14 @@
 #include "AudioController.h"
 #include "EncoderController.h"
 #include "WirelessSync.h"
+#include "Rs485Transport.h"
+#include "OscServer.h"
+#include "SerialControl.h"
+#include "BleMidiControl.h"
+#include "BleBeatBroadcast.h"
 #include "Timing.h"
+#include "Trace.h"
+#include "HeapMonitor.h"
 #include "ConfigManager.h"
 
 MetronomeState state;
@@ -19,8 +26,23 @@ Display display;
 SolenoidController solenoidController(SOLENOID_PIN, SOLENOID_PIN2);
 AudioController audioController(DAC_PIN);
 WirelessSync wirelessSync;
+#if SYNC_TRANSPORT_RS485
+Rs485Transport rs485Transport(RS485_UART_NUM, RS485_TX_PIN, RS485_RX_PIN, RS485_DE_PIN, RS485_BAUD);
+#endif
 Timing timing(state, wirelessSync, solenoidController, audioController);
 EncoderController encoderController(state, timing);
+#if ENABLE_OSC
+OscServer oscServer(state, timing);
+#endif
+#if ENABLE_SERIAL_CONTROL
+SerialControl serialControl(state, timing, wirelessSync);
+#endif
+#if ENABLE_BLE_MIDI
+BleMidiControl bleMidiControl(state, timing);
+#endif
+#if ENABLE_BLE_BEAT_BROADCAST
+BleBeatBroadcast bleBeatBroadcast(state, timing, wirelessSync);
+#endif
 
 // Global pointer to WirelessSync instance for pattern change notifications
 WirelessSync* globalWirelessSync = &wirelessSync;
@@ -32,7 +54,11 @@ bool configModified = false;
 
 void setup()
 {
+#if ENABLE_SERIAL_CONTROL
+    Serial.begin(SERIAL_CONTROL_BAUD);
+#else
     Serial.begin(115200);
+#endif
     Serial.println("Metronome starting...");
     
     // Initialize Preferences
@@ -46,6 +72,9 @@ void setup()
     } else {
         Serial.println("Loaded configuration from storage");
     }
+    if (!wirelessSync.setGroupID(ConfigManager::loadGroupID())) {
+        Serial.println("Stored sync group ID is reserved, using default");
+    }
     
     // Close preferences to free resources during normal operation
     ConfigManager::end();
@@ -56,6 +85,9 @@ void setup()
     encoderController.begin();
 
     // Initialize wireless sync
+#if SYNC_TRANSPORT_RS485
+    wirelessSync.setTransport(&rs485Transport);
+#endif
     if (wirelessSync.init()) {
         // Set a random priority based on device ID
         uint8_t devicePriority = random(1, 100);
@@ -65,6 +97,23 @@ void setup()
         wirelessSync.negotiateLeadership();
     }
 
+#if ENABLE_OSC
+    oscServer.begin();
+#endif
+#if ENABLE_SERIAL_CONTROL
+    serialControl.begin();
+#endif
+#if ENABLE_BLE_MIDI
+    bleMidiControl.begin();
+#endif
+#if ENABLE_BLE_BEAT_BROADCAST
+    // After the BLE-MIDI server, whose advertiser it shares on the ESP32
+    bleBeatBroadcast.begin();
+#endif
+#if ENABLE_TRACE
+    Trace::begin();
+#endif
+
     // Set display reference in timing
     timing.setDisplay(&display);
     
@@ -74,6 +123,11 @@ void setup()
     
     // Start animation immediately (even before playback starts)
     display.startAnimation();
+
+#if ENABLE_HEAP_MONITOR
+    // Everything is allocated by now; the loop must not touch the heap
+    HeapMonitor::arm();
+#endif
 }
 
 void loop()
@@ -114,6 +168,23 @@ void loop()
         }
     }
     
+#if ENABLE_OSC
+    // Apply show-control messages
+    oscServer.update();
+#endif
+#if ENABLE_SERIAL_CONTROL
+    // Apply test-rig commands and stream beat events
+    serialControl.update();
+#endif
+#if ENABLE_BLE_MIDI
+    // Apply controller changes and send MIDI clock
+    bleMidiControl.update();
+#endif
+#if ENABLE_BLE_BEAT_BROADCAST
+    // Publish the timeline anchor while we lead
+    bleBeatBroadcast.update();
+#endif
+
     // Update state
     state.update();
 
@@ -141,6 +212,10 @@ void loop()
         ConfigManager::end();
     }
     
+#if ENABLE_HEAP_MONITOR
+    HeapMonitor::update();
+#endif
+
     // Prevent watchdog timeouts
     yield();
 }
\ No newline at end of file
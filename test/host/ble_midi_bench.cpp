@@ -0,0 +1,57 @@
+// BLE-MIDI receive path on the host: a 4-CC controller write parsed in place
+// from the received buffer, as onWriteData() hands it over, against the
+// copies the write used to go through (stack buffer, stored characteristic
+// value, std::string from getValue()).
+
+#include <chrono>
+#include <string>
+#include "ProtocolMidi.h"
+#include "check.h"
+
+class BenchMidi : public ProtocolMidi {
+public:
+  using ProtocolMidi::midi_receivePacket;
+
+protected:
+  bool sendPacket(uint8_t *, uint16_t) override { return true; }
+};
+
+static uint32_t controlChanges = 0;
+
+typedef std::chrono::steady_clock Clock;
+
+template <typename F>
+static double nsPerPacket(F receive) {
+  const int ROUNDS = 2000000;
+  uint32_t before = controlChanges;
+  auto start = Clock::now();
+  for (int i = 0; i < ROUNDS; i++) receive();
+  double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  CHECK_EQ(controlChanges - before, (uint32_t)ROUNDS * 4);
+  return ns / ROUNDS;
+}
+
+int main() {
+  BenchMidi midi;
+  midi.setControlChangeCallback([](uint8_t, uint8_t, uint8_t, uint16_t) { controlChanges++; });
+
+  // What tools/ble_midi/write_bench.py sends: header, then timestamp + CC x4
+  const uint8_t packet[] = {0x80, 0x81, 0xBE, 119, 0, 0x81, 0xBE, 119, 1,
+                            0x81, 0xBE, 119, 2, 0x81, 0xBE, 119, 3};
+
+  double inPlace = nsPerPacket([&]() { midi.midi_receivePacket(packet, sizeof(packet)); });
+
+  std::string value;
+  double copied = nsPerPacket([&]() {
+    uint8_t flattened[BLE_MIDI_MAX_PACKET];
+    memcpy(flattened, packet, sizeof(packet));
+    value.assign((const char *)flattened, sizeof(packet));
+    std::string received = value;
+    midi.midi_receivePacket((const uint8_t *)received.data(), received.size());
+  });
+
+  printf("BLE-MIDI 4-CC write, ns per packet:\n");
+  printf("  parsed in place     %6.1f\n", inPlace);
+  printf("  through copies      %6.1f\n", copied);
+  return checkReport("ble_midi_bench");
+}
@@ -0,0 +1,143 @@
+// ProtocolMidi's receive parser against well-formed, truncated and random
+// packets. Every packet is copied to the very end of a heap block of its own
+// size, so a read past the end is caught when built with -fsanitize=address.
+
+#include <string>
+#include <vector>
+#include "ProtocolMidi.h"
+#include "check.h"
+
+// Sent packets are collected, so what the sender queues can be parsed back
+class LoopbackMidi : public ProtocolMidi {
+public:
+  std::vector<std::vector<uint8_t>> sent;
+
+  void receive(const std::vector<uint8_t> &packet) {
+    uint8_t *exact = new uint8_t[packet.size()];
+    memcpy(exact, packet.data(), packet.size());
+    midi_receivePacket(exact, packet.size());
+    delete[] exact;
+  }
+
+protected:
+  bool sendPacket(uint8_t *packet, uint16_t packetSize) override {
+    sent.emplace_back(packet, packet + packetSize);
+    return true;
+  }
+};
+
+// Every callback appends what it saw
+static std::string events;
+
+static void append(const char *format, ...) {
+  char line[64];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  events += line;
+}
+
+static void installCallbacks(ProtocolMidi &midi) {
+  midi.setNoteOnCallback([](uint8_t ch, uint8_t note, uint8_t vel, uint16_t ts) { append("on %u %u %u @%u;", ch, note, vel, ts); });
+  midi.setNoteOffCallback([](uint8_t ch, uint8_t note, uint8_t vel, uint16_t ts) { append("off %u %u %u @%u;", ch, note, vel, ts); });
+  midi.setAfterTouchPolyCallback([](uint8_t ch, uint8_t note, uint8_t p, uint16_t ts) { append("poly %u %u %u @%u;", ch, note, p, ts); });
+  midi.setControlChangeCallback([](uint8_t ch, uint8_t cc, uint8_t v, uint16_t ts) { append("cc %u %u %u @%u;", ch, cc, v, ts); });
+  midi.setProgramChangeCallback([](uint8_t ch, uint8_t prog, uint16_t ts) { append("pc %u %u @%u;", ch, prog, ts); });
+  midi.setAfterTouchCallback([](uint8_t ch, uint8_t p, uint16_t ts) { append("at %u %u @%u;", ch, p, ts); });
+  midi.setPitchBendCallback([](uint8_t ch, uint16_t value, uint16_t ts) { append("pb %u %u @%u;", ch, value, ts); });
+  midi.setStopCallback([]() { append("stop;"); });
+}
+
+static std::string parse(LoopbackMidi &midi, const std::vector<uint8_t> &packet) {
+  events.clear();
+  midi.receive(packet);
+  return events;
+}
+
+static void testWellFormed(LoopbackMidi &midi) {
+  // Header, then timestamp + message; running status; real-time in between
+  CHECK(parse(midi, {0x81, 0x82, 0xB0, 7, 100}) == "cc 0 7 100 @130;");
+  CHECK(parse(midi, {0x80, 0x81, 0x91, 60, 90, 0x82, 62, 91, 63, 92}) ==
+           "on 1 60 90 @1;on 1 62 91 @2;on 1 63 92 @2;");
+  CHECK(parse(midi, {0x80, 0x81, 0x92, 60, 90, 0x81, 0xFC, 0x82, 61, 0}) ==
+           "on 2 60 90 @1;stop;on 2 61 0 @2;");
+  CHECK(parse(midi, {0x80, 0x80, 0xC3, 5, 0x80, 0xD3, 40, 0x80, 0xE3, 0, 64, 0x80, 0xA3, 1, 2}) ==
+           "pc 3 5 @0;at 3 40 @0;pb 3 8192 @0;poly 3 1 2 @0;");
+  // SysEx is skipped along with its closing timestamp and F7
+  CHECK(parse(midi, {0x80, 0x80, 0xF0, 0x7F, 0x7F, 0x06, 0x02, 0x80, 0xF7, 0x80, 0x84, 1, 2}) ==
+           "off 4 1 2 @0;");
+}
+
+// Packets cut short or with a status where data belongs fire nothing past
+// the last complete message
+static void testMalformed(LoopbackMidi &midi) {
+  CHECK(parse(midi, {0x80, 0x80, 0xB0}) == "");
+  CHECK(parse(midi, {0x80, 0x80, 0xB0, 7}) == "");
+  CHECK(parse(midi, {0x80, 0x80, 0xC0}) == "");
+  CHECK(parse(midi, {0x80, 0x80, 0xB0, 7, 100, 0x81}) == "cc 0 7 100 @0;");
+  CHECK(parse(midi, {0x80, 0x80, 0xB0, 7, 100, 8}) == "cc 0 7 100 @0;");
+  CHECK(parse(midi, {0x80, 0x80, 0x90, 60, 0x81, 0x90, 61, 1}) == "");
+  CHECK(parse(midi, {0x80, 0x80, 0x80, 0x80}) == "");
+  CHECK(parse(midi, {0x80, 0x80, 0xF0, 1, 2}) == "");
+  CHECK(parse(midi, {0x80, 0x80, 0xF0, 1, 0x80}) == "");
+  CHECK(parse(midi, {0x80, 0x80, 7, 100}) == "");
+}
+
+static uint32_t rngState = 2463534242u;
+static uint32_t rng() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static void testRandom(LoopbackMidi &midi) {
+  uint32_t packets = midi.getRxStats().packets;
+  for (int i = 0; i < 200000; i++) {
+    std::vector<uint8_t> packet(3 + rng() % 20);
+    for (uint8_t &b : packet) {
+      // Bias towards status and timestamp bytes so more get past the header
+      b = rng() % 3 ? 0x80 | rng() : rng() & 0x7F;
+    }
+    packet[0] |= 0x80;
+    packet[1] |= 0x80;
+    parse(midi, packet);
+  }
+  CHECK_EQ(midi.getRxStats().packets - packets, 200000u);
+}
+
+// What the sender queues parses back to the same messages
+static void testRoundTrip(LoopbackMidi &midi) {
+  midi.sent.clear();
+  midi.controlChange(3, 7, 100);
+  midi.controlChange(3, 8, 101);
+  midi.noteOn(3, 60, 90);
+  midi.clockTick(micros());
+  midi.programChange(3, 9);
+  midi.flush();
+  CHECK(!midi.sent.empty());
+
+  std::string received;
+  for (const auto &packet : midi.sent) received += parse(midi, packet);
+  // Strip the timestamps, which depend on the clock
+  std::string stripped;
+  for (size_t i = 0; i < received.size(); i++) {
+    if (received[i] == '@') {
+      while (received[i] != ';') i++;
+      stripped.pop_back();
+    }
+    stripped += received[i];
+  }
+  CHECK(stripped == "cc 3 7 100;cc 3 8 101;on 3 60 90;pc 3 9;");
+}
+
+int main() {
+  LoopbackMidi midi;
+  installCallbacks(midi);
+  testWellFormed(midi);
+  testMalformed(midi);
+  testRandom(midi);
+  testRoundTrip(midi);
+  return checkReport("ble_midi_parse_test");
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimal assertions for the host tests: report and keep going, exit code
+// says whether anything failed
+
+static int checkFailures = 0;
+
+#define CHECK(cond)                                                        \
+  do {                                                                     \
+    if (!(cond)) {                                                         \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+      checkFailures++;                                                     \
+    }                                                                      \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                     \
+  do {                                                                     \
+    long long _a = (long long)(a), _b = (long long)(b);                    \
+    if (_a != _b) {                                                        \
+      fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld vs %lld)\n", \
+              __FILE__, __LINE__, #a, #b, _a, _b);                         \
+      checkFailures++;                                                     \
+    }                                                                      \
+  } while (0)
+
+static inline int checkReport(const char *name) {
+  if (checkFailures) {
+    fprintf(stderr, "%s: %d check(s) failed\n", name, checkFailures);
+    return 1;
+  }
+  printf("%s: ok\n", name);
+  return 0;
+}
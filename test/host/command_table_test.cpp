@@ -0,0 +1,76 @@
+// CommandTable's compile-time perfect hash over real command names: the
+// example's console commands, then the serial control operations spelled as
+// text commands. Every table from 4 to 16 of them has to be built by the
+// compiler, or this file does not compile.
+
+#include <utility>
+#include "MainCommand.h"
+#include "check.h"
+
+static const char *lastCommand = nullptr;
+
+static void record(const CommandArgs &args) {
+  lastCommand = args.argv[0];
+}
+
+// examples/src.ble's table comes first, in its order
+static constexpr const char *names[] = {
+    "bpm", "measure", "pattern", "subdivision", "midistats", "pools", "clock",
+    "help", "ping", "transport", "enabled", "multiplier", "mode", "subscribe",
+    "assign", "group", "layout",
+};
+
+template <size_t N>
+struct Commands {
+  command_t table[N] = {};
+
+  constexpr Commands() {
+    for (size_t i = 0; i < N; i++) table[i] = {names[i], "", record};
+  }
+};
+
+template <size_t N>
+static constexpr Commands<N> commands{};
+
+template <size_t N>
+static constexpr CommandTable<N> table(commands<N>.table);
+
+// Every name finds its own entry; near misses and other names find nothing
+template <size_t N>
+static void testTable() {
+  CommandTableView view = table<N>.view();
+  CHECK_EQ(view.count, N);
+  for (size_t i = 0; i < N; i++) CHECK(view.find(names[i]) == &commands<N>.table[i]);
+  for (size_t i = N; i < sizeof(names) / sizeof(names[0]); i++) CHECK(view.find(names[i]) == nullptr);
+  CHECK(view.find("") == nullptr);
+  CHECK(view.find("bpmx") == nullptr);
+  CHECK(view.find("bp") == nullptr);
+  CHECK(view.find("BPM") == nullptr);
+}
+
+template <size_t... N>
+static void testTables(std::index_sequence<N...>) {
+  (testTable<N + 4>(), ...);
+}
+
+// MainCommand dispatches a parsed line to its callback
+static void testDispatch() {
+  MainCommand command(table<7>.view());
+  CommandArgs args = {};
+  args.argc = 2;
+  args.argv[0] = "clock";
+  args.argv[1] = "on";
+  command.parser(args);
+  CHECK(lastCommand == args.argv[0]);
+
+  lastCommand = nullptr;
+  args.argv[0] = "clocks";
+  CHECK(!command.runCallback(args.argv[0], args));
+  CHECK(lastCommand == nullptr);
+}
+
+int main() {
+  testTables(std::make_index_sequence<13>());
+  testDispatch();
+  return checkReport("command_table_test");
+}
@@ -0,0 +1,73 @@
+// Stands in for the device at the far end of a serial port, so that
+// tools/serial_control/benchmark.py measures the firmware's framing code
+// (ControlFrame.h) rather than the Python copy of it. Every valid command
+// is acknowledged, like SerialControl::handleFrame() does; unknown types get
+// CTRL_ERR_TYPE. Runs until SIGTERM or the other end of the port closes,
+// then reports any frames it could not decode.
+//
+//   control_responder /dev/pts/N
+
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdio.h>
+#include "ControlFrame.h"
+
+static uint32_t deviceMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+static void onTerm(int) {}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <tty>\n", argv[0]);
+    return 2;
+  }
+  int fd = open(argv[1], O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    perror(argv[1]);
+    return 1;
+  }
+  struct termios tio;
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(fd, TCSANOW, &tio);
+
+  // Without SA_RESTART the signal ends the blocking read below
+  struct sigaction term = {};
+  term.sa_handler = onTerm;
+  sigaction(SIGTERM, &term, nullptr);
+
+  ControlFrameReader reader;
+  uint8_t in[4096];
+  // A frame takes at least six bytes of a read: five of COBS and the
+  // closing delimiter (the opening one can be in the previous read)
+  uint8_t out[(sizeof(in) / 6 + 1) * CONTROL_FRAME_MAX_ENCODED];
+
+  for (;;) {
+    ssize_t n = read(fd, in, sizeof(in));
+    if (n <= 0) break;
+
+    size_t outLen = 0;
+    for (ssize_t i = 0; i < n; i++) {
+      if (reader.feed(in[i]) != ControlFrameReader::FRAME_READY) continue;
+      CtrlAck ack;
+      ack.command = reader.type();
+      ack.status = reader.type() < CTRL_ACK ? CTRL_OK : CTRL_ERR_TYPE;
+      ack.deviceMicros = deviceMicros();
+      outLen += controlFrameEncode(CTRL_ACK, reader.seq(), &ack, sizeof(ack), &out[outLen]);
+    }
+    if (outLen > 0 && write(fd, out, outLen) != (ssize_t)outLen) break;
+  }
+
+  if (reader.crcErrors() || reader.framingErrors())
+    fprintf(stderr, "control_responder: %u CRC errors, %u framing errors\n",
+            reader.crcErrors(), reader.framingErrors());
+  close(fd);
+  return 0;
+}
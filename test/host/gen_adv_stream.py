@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Synthetic advertising reports from a crowded venue, for nimble_scan_bench.
+
+There is no recorded capture, so this stands in for one: 400 advertisers
+(phones, tags and beacons) over a 60 s active scan. A fifth advertise every
+20-100 ms, the rest every 200 ms-2 s, with the 0-10 ms jitter the spec
+adds. Connectable and scannable advertisers (60%) answer half of the scan
+requests with a scan response carrying the same data.
+
+Each report is a 41-byte record, little-endian:
+    6s address, B address type, B event type, b RSSI, B data length, 31s data
+
+    ./gen_adv_stream.py build/adv_stream.bin
+
+The seed is fixed, so every run writes the same stream.
+"""
+
+import argparse
+import random
+import struct
+
+ADV_IND = 0
+ADV_NONCONN_IND = 3
+SCAN_RSP = 4
+SCAN_SECONDS = 60
+ADVERTISERS = 400
+
+RECORD = struct.Struct("<6sBBbB31s")
+
+
+def advertisers(rng):
+    devices = []
+    for _ in range(ADVERTISERS):
+        address = bytes(rng.getrandbits(8) for _ in range(6))
+        kind = rng.random()
+        if kind < 0.2:
+            interval = rng.choice([20, 30, 100])
+        else:
+            interval = rng.choice([200, 300, 500, 1000, 2000])
+        connectable = kind < 0.6
+        data = bytes(rng.getrandbits(8) for _ in range(rng.randint(8, 31)))
+        devices.append((address, interval, connectable, data))
+    return devices
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("output", help="file to write the reports to")
+    args = parser.parse_args()
+
+    rng = random.Random(7)
+    events = []
+    for address, interval, connectable, data in advertisers(rng):
+        at = rng.uniform(0, interval)
+        while at < SCAN_SECONDS * 1000:
+            events.append((at, address, connectable, data))
+            at += interval + rng.uniform(0, 10)
+    events.sort()
+
+    reports = 0
+    with open(args.output, "wb") as out:
+        for _, address, connectable, data in events:
+            rssi = rng.randint(-95, -40)
+            padded = data.ljust(31, b"\0")
+            event_type = ADV_IND if connectable else ADV_NONCONN_IND
+            out.write(RECORD.pack(address, 0, event_type, rssi, len(data), padded))
+            reports += 1
+            if connectable and rng.random() < 0.5:
+                out.write(RECORD.pack(address, 0, SCAN_RSP, rssi, len(data), padded))
+                reports += 1
+
+    print(f"{reports} reports from {ADVERTISERS} advertisers over {SCAN_SECONDS} s")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,3 @@
+#pragma once
+// The ESP32 build's NimBLE configuration
+#include "nimble/esp_port/port/include/esp_nimble_cfg.h"
@@ -0,0 +1,91 @@
+// In-memory NVS: one namespace, keys and blobs as ESP-IDF stores them
+
+#include <stdlib.h>
+#include <string.h>
+#include "nvs.h"
+
+#define FAKE_NVS_ENTRIES 256
+
+struct entry {
+  char key[16];
+  unsigned char *data;
+  size_t size;
+};
+
+static struct entry entries[FAKE_NVS_ENTRIES];
+static int numEntries;
+int fake_nvs_ops;
+
+static struct entry *find(const char *key) {
+  for (int i = 0; i < numEntries; i++) {
+    if (strcmp(entries[i].key, key) == 0) return &entries[i];
+  }
+  return NULL;
+}
+
+esp_err_t nvs_open(const char *name, int mode, nvs_handle_t *handle) {
+  fake_nvs_ops++;
+  *handle = 1;
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length) {
+  fake_nvs_ops++;
+  struct entry *e = find(key);
+  if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+  if (value != NULL) {
+    if (*length < e->size) return ESP_ERR_NVS_INVALID_LENGTH;
+    memcpy(value, e->data, e->size);
+  }
+  *length = e->size;
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+  fake_nvs_ops++;
+  struct entry *e = find(key);
+  if (e == NULL) {
+    if (numEntries == FAKE_NVS_ENTRIES) abort();
+    e = &entries[numEntries++];
+    strncpy(e->key, key, sizeof(e->key) - 1);
+  }
+  free(e->data);
+  e->data = malloc(length);
+  memcpy(e->data, value, length);
+  e->size = length;
+  return ESP_OK;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *value) {
+  size_t length = 1;
+  return nvs_get_blob(handle, key, value, &length);
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value) {
+  return nvs_set_blob(handle, key, &value, 1);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+  fake_nvs_ops++;
+  struct entry *e = find(key);
+  if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+  free(e->data);
+  *e = entries[--numEntries];
+  memset(&entries[numEntries], 0, sizeof(entries[0]));
+  return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_OK; }
+
+int fake_nvs_has(const char *key) { return find(key) != NULL; }
+
+size_t fake_nvs_size(const char *key) {
+  struct entry *e = find(key);
+  return e ? e->size : 0;
+}
+
+void fake_nvs_clear(void) {
+  while (numEntries > 0) nvs_erase_key(1, entries[numEntries - 1].key);
+}
@@ -0,0 +1,52 @@
+#pragma once
+// Just enough of FreeRTOS to build NimBLE host sources on the host; the
+// tests drive the host from their own threads, never from FreeRTOS tasks
+
+#include <stdint.h>
+
+typedef void *QueueHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef void *TaskHandle_t;
+typedef void *TimerHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+typedef struct {
+  int unused;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portMAX_DELAY 0xffffffff
+#define portTICK_PERIOD_MS 1
+#define configTICK_RATE_HZ 1000
+#define IRAM_ATTR
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+
+#define taskSCHEDULER_NOT_STARTED 1
+static inline int xTaskGetSchedulerState(void) { return 2; }
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Critical sections are in port.c; a test that reaches any of the rest
+// defines it
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+UBaseType_t uxGetCriticalNestingDepth(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCountFromISR(void);
+void vTaskDelay(TickType_t ticks);
+void xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueIsQueueEmptyFromISR(QueueHandle_t queue);
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore);
+
+#ifdef __cplusplus
+}
+#endif
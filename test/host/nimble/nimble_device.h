@@ -0,0 +1,11 @@
+#pragma once
+// NimBLEDevice and GAP discovery stand-ins for the NimBLE-Arduino scan
+// tests: NimBLEScan::start() hands its event handler to ble_gap_disc(),
+// and the tests feed it reports through scanEvent()
+
+#include "NimBLEDevice.h"
+
+// Sends a DISC event for one advertising report, or DISC_COMPLETE
+void scanReport(const uint8_t addr[6], uint8_t addrType, uint8_t eventType, int8_t rssi,
+                const uint8_t *data, uint8_t length);
+void scanComplete();
@@ -0,0 +1,28 @@
+#pragma once
+// ESP-IDF NVS API, backed by the in-memory store in fake_nvs.c
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int esp_err_t;
+typedef uint32_t nvs_handle_t;
+
+#define ESP_OK 0
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+#define ESP_ERR_NVS_INVALID_LENGTH 0x110c
+#define NVS_READWRITE 1
+
+esp_err_t nvs_open(const char *name, int mode, nvs_handle_t *handle);
+void nvs_close(nvs_handle_t handle);
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length);
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *value);
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value);
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key);
+esp_err_t nvs_commit(nvs_handle_t handle);
+
+// For the tests: calls made so far, what is stored, and a wipe
+extern int fake_nvs_ops;
+int fake_nvs_has(const char *key);
+size_t fake_nvs_size(const char *key);
+void fake_nvs_clear(void);
@@ -0,0 +1,13 @@
+// Critical sections for the NimBLE porting layer: one process-wide
+// spinlock, as on a single-core ESP32
+
+#include <pthread.h>
+
+static pthread_spinlock_t criticalLock;
+
+__attribute__((constructor)) static void criticalInit(void) {
+  pthread_spin_init(&criticalLock, PTHREAD_PROCESS_PRIVATE);
+}
+
+void vPortEnterCritical(void) { pthread_spin_lock(&criticalLock); }
+void vPortExitCritical(void) { pthread_spin_unlock(&criticalLock); }
@@ -0,0 +1,20 @@
+#pragma once
+// Forced into every NimBLE source: queue macros that ESP-IDF's newlib
+// <sys/queue.h> has and glibc's lacks or defines differently
+
+#include <stddef.h>
+
+#ifndef STAILQ_REMOVE_AFTER
+#define STAILQ_REMOVE_AFTER(head, elm, field)                                   \
+  do {                                                                          \
+    if ((STAILQ_NEXT(elm, field) = STAILQ_NEXT(STAILQ_NEXT(elm, field), field)) \
+        == NULL)                                                                \
+      (head)->stqh_last = &STAILQ_NEXT((elm), field);                           \
+  } while (0)
+#endif
+
+#undef STAILQ_LAST
+#define STAILQ_LAST(head, type, field)                                          \
+  (STAILQ_EMPTY((head)) ? NULL                                                  \
+                        : (struct type *)(void *)((char *)((head)->stqh_last) - \
+                                                  offsetof(struct type, field)))
@@ -0,0 +1,2 @@
+#pragma once
+// The ESP-IDF configuration comes from -D flags in the host Makefile
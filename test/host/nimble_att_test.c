@@ -0,0 +1,140 @@
+// The ATT server's handle index on the host: a 200-attribute table looked
+// up by handle and searched by UUID from a start handle, checked
+// against the registration order, then a hidden range must vanish from both
+// and come back on restore. Prints the lookup times as it goes.
+
+#include <time.h>
+#include "host/ble_uuid.h"
+#include "ble_att_priv.h"
+#include "check.h"
+
+#define ATTRS 200
+
+uint16_t ble_hs_max_attrs;
+int ble_att_svr_init(void);
+
+static const ble_uuid16_t svc = BLE_UUID16_INIT(0x2800);
+static const ble_uuid16_t chr = BLE_UUID16_INIT(0x2803);
+static const ble_uuid16_t val = BLE_UUID16_INIT(0x2a00);
+static const ble_uuid16_t cccd = BLE_UUID16_INIT(0x2902);
+
+static int access(uint16_t conn, uint16_t handle, uint8_t op, uint16_t offset,
+                  struct os_mbuf **om, void *arg) {
+  return 0;
+}
+
+static double nowNs(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static unsigned rngState = 1;
+static uint16_t randomHandle(void) {
+  rngState = rngState * 1103515245 + 12345;
+  return 1 + (rngState >> 16) % ATTRS;
+}
+
+// A service every 10 handles, then characteristic, value and CCCD in turn
+static const ble_uuid_t *uuidFor(int i) {
+  if (i % 10 == 0) return &svc.u;
+  if (i % 3 == 1) return &chr.u;
+  if (i % 3 == 2) return &val.u;
+  return &cccd.u;
+}
+
+// First CCCD at or above start, walking from the head of the list as the
+// range requests did before the index
+static struct ble_att_svr_entry *firstCccdByWalk(uint16_t start) {
+  struct ble_att_svr_entry *e = NULL;
+  while ((e = ble_att_svr_find_by_uuid(e, &cccd.u, 0xffff)) != NULL) {
+    if (e->ha_handle_id >= start) return e;
+  }
+  return NULL;
+}
+
+// The same, jumping to the start handle through the index first
+static struct ble_att_svr_entry *firstCccdByIndex(uint16_t start) {
+  struct ble_att_svr_entry *e = ble_att_svr_find_by_handle(start);
+  if (e != NULL && ble_uuid_cmp(e->ha_uuid, &cccd.u) == 0) return e;
+  return ble_att_svr_find_by_uuid(e, &cccd.u, 0xffff);
+}
+
+static void testLookup(void) {
+  for (int i = 0; i < ATTRS; i++) {
+    struct ble_att_svr_entry *e = ble_att_svr_find_by_handle(i + 1);
+    CHECK(e != NULL);
+    if (e == NULL) continue;
+    CHECK_EQ(e->ha_handle_id, i + 1);
+    CHECK(ble_uuid_cmp(e->ha_uuid, uuidFor(i)) == 0);
+  }
+  CHECK(ble_att_svr_find_by_handle(0) == NULL);
+  CHECK(ble_att_svr_find_by_handle(ATTRS + 1) == NULL);
+
+  // CCCDs are the handles whose index is a multiple of 3 outside services
+  for (int start = 1; start <= ATTRS; start++) {
+    int expected = 0;
+    for (int i = start - 1; i < ATTRS && !expected; i++) {
+      if (uuidFor(i) == &cccd.u) expected = i + 1;
+    }
+    struct ble_att_svr_entry *e = firstCccdByWalk(start);
+    CHECK_EQ(e ? e->ha_handle_id : 0, expected);
+    e = firstCccdByIndex(start);
+    CHECK_EQ(e ? e->ha_handle_id : 0, expected);
+  }
+}
+
+static void testHideRestore(void) {
+  ble_att_svr_hide_range(21, 40);
+  for (int h = 21; h <= 40; h++) CHECK(ble_att_svr_find_by_handle(h) == NULL);
+  CHECK(ble_att_svr_find_by_handle(20) != NULL);
+  CHECK(ble_att_svr_find_by_handle(41) != NULL);
+  struct ble_att_svr_entry *e = firstCccdByWalk(21);
+  CHECK(e != NULL && e->ha_handle_id > 40);
+
+  ble_att_svr_restore_range(21, 40);
+  for (int h = 21; h <= 40; h++) {
+    e = ble_att_svr_find_by_handle(h);
+    CHECK(e != NULL && e->ha_handle_id == h);
+  }
+  e = firstCccdByIndex(21);
+  CHECK(e != NULL && e->ha_handle_id < 40);
+}
+
+static void bench(void) {
+  const int ROUNDS = 2000000;
+  volatile uintptr_t sink = 0;
+
+  double start = nowNs();
+  for (int i = 0; i < ROUNDS; i++) sink += (uintptr_t)ble_att_svr_find_by_handle(randomHandle());
+  double byHandle = (nowNs() - start) / ROUNDS;
+
+  start = nowNs();
+  for (int i = 0; i < ROUNDS / 10; i++) sink += (uintptr_t)firstCccdByWalk(randomHandle());
+  double byWalk = (nowNs() - start) / (ROUNDS / 10);
+
+  start = nowNs();
+  for (int i = 0; i < ROUNDS; i++) sink += (uintptr_t)firstCccdByIndex(randomHandle());
+  double byIndex = (nowNs() - start) / ROUNDS;
+
+  printf("ATT server, %d attributes, ns per lookup:\n", ATTRS);
+  printf("  find by handle                 %6.1f\n", byHandle);
+  printf("  CCCD from a handle, list walk  %6.1f\n", byWalk);
+  printf("  CCCD from a handle, index      %6.1f\n", byIndex);
+}
+
+int main(void) {
+  ble_hs_max_attrs = ATTRS;
+  CHECK_EQ(ble_att_svr_init(), 0);
+  CHECK_EQ(ble_att_svr_start(), 0);
+  for (int i = 0; i < ATTRS; i++) {
+    uint16_t handle;
+    CHECK_EQ(ble_att_svr_register(uuidFor(i), 0, 0, &handle, access, NULL), 0);
+    CHECK_EQ(handle, i + 1);
+  }
+
+  testLookup();
+  testHideRestore();
+  bench();
+  return checkReport("nimble_att_test");
+}
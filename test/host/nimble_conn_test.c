@@ -0,0 +1,120 @@
+// The host's connection indexes on the host: connections are removed and
+// re-inserted under new handles at random, and after every round both
+// lookups must agree with the list. Then times the lookups against a walk
+// of the list, and the insert/remove round trip that keeps the indexes.
+// Built once per BLE_MAX_CONNECTIONS setting.
+
+#include <time.h>
+#include "ble_hs_priv.h"
+#include "check.h"
+
+#define CONNS MYNEWT_VAL(BLE_MAX_CONNECTIONS)
+
+static struct ble_hs_conn conns[CONNS];
+
+int ble_hs_locked_by_cur_task(void) { return 1; }
+
+// Only needed for our own addresses, which the lookups never ask for
+uint8_t ble_hs_misc_own_addr_type_to_id(uint8_t addr_type) { __builtin_trap(); }
+int ble_hs_id_addr(uint8_t id_addr_type, const uint8_t **out_id_addr, int *out_is_nrpa) {
+  __builtin_trap();
+}
+
+static double nowNs(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static unsigned rngState = 1;
+static unsigned rng(void) {
+  rngState = rngState * 1103515245 + 12345;
+  return rngState >> 16;
+}
+
+// What ble_hs_conn_find() did before the index
+static struct ble_hs_conn *findByWalk(uint16_t handle) {
+  struct ble_hs_conn *conn;
+  for (conn = ble_hs_conn_first(); conn != NULL; conn = SLIST_NEXT(conn, bhc_next)) {
+    if (conn->bhc_handle == handle) return conn;
+  }
+  return NULL;
+}
+
+static void checkLookups(int removed) {
+  for (int j = 0; j < CONNS; j++) {
+    struct ble_hs_conn *byHandle = ble_hs_conn_find(conns[j].bhc_handle);
+    struct ble_hs_conn *byAddr = ble_hs_conn_find_by_addr(&conns[j].bhc_peer_addr);
+    if (j == removed) {
+      CHECK(byHandle == NULL);
+      CHECK(byAddr == NULL);
+    } else {
+      CHECK(byHandle == &conns[j]);
+      CHECK(byAddr == &conns[j]);
+    }
+  }
+}
+
+static void testRemoveReinsert(void) {
+  for (int round = 0; round < 1000; round++) {
+    int i = rng() % CONNS;
+    ble_hs_conn_remove(&conns[i]);
+    checkLookups(i);
+
+    // A new handle, clustered low as controllers assign them, so probe runs
+    // collide and wrap
+    uint16_t handle = rng() % 64;
+    for (int j = 0; j < CONNS; j++) {
+      if (j != i && conns[j].bhc_handle == handle) handle = 100 + i;
+    }
+    conns[i].bhc_handle = handle;
+    ble_hs_conn_insert(&conns[i]);
+    checkLookups(-1);
+  }
+}
+
+static void bench(void) {
+  const int ROUNDS = 1000000;
+  volatile uintptr_t sink = 0;
+
+  double start = nowNs();
+  for (int r = 0; r < ROUNDS; r++) sink += (uintptr_t)findByWalk(conns[r % CONNS].bhc_handle);
+  double walk = (nowNs() - start) / ROUNDS;
+
+  start = nowNs();
+  for (int r = 0; r < ROUNDS; r++) sink += (uintptr_t)ble_hs_conn_find(conns[r % CONNS].bhc_handle);
+  double byHandle = (nowNs() - start) / ROUNDS;
+
+  start = nowNs();
+  for (int r = 0; r < ROUNDS; r++) sink += (uintptr_t)ble_hs_conn_find_by_addr(&conns[r % CONNS].bhc_peer_addr);
+  double byAddr = (nowNs() - start) / ROUNDS;
+
+  // Connect and disconnect are where the indexes cost something
+  start = nowNs();
+  for (int r = 0; r < ROUNDS; r++) {
+    ble_hs_conn_remove(&conns[r % CONNS]);
+    ble_hs_conn_insert(&conns[r % CONNS]);
+  }
+  double update = (nowNs() - start) / ROUNDS;
+  checkLookups(-1);
+
+  printf("Host connections, %d connections, ns per call:\n", CONNS);
+  printf("  find, list walk          %6.1f\n", walk);
+  printf("  find, index              %6.1f\n", byHandle);
+  printf("  find_by_addr, index      %6.1f\n", byAddr);
+  printf("  remove + insert          %6.1f\n", update);
+}
+
+int main(void) {
+  CHECK_EQ(ble_hs_conn_init(), 0);
+  for (int i = 0; i < CONNS; i++) {
+    conns[i].bhc_handle = i * 3 + 1;
+    conns[i].bhc_peer_addr.type = BLE_ADDR_PUBLIC;
+    for (int k = 0; k < 6; k++) conns[i].bhc_peer_addr.val[k] = i * 7 + k;
+    ble_hs_conn_insert(&conns[i]);
+  }
+
+  testRemoveReinsert();
+  bench();
+  return checkReport("nimble_conn_test");
+}
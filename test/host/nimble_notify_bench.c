@@ -0,0 +1,99 @@
+// Notifying one value to several subscribers on the host, with NimBLE's own
+// os_mbuf, os_mempool and ble_hs_mbuf: NimBLECharacteristic's
+// notify(value, length) builds one chain per subscriber; notify(om) takes a
+// chain the caller built and copies it for every subscriber but the last.
+// The transport stands in for ATT, L2CAP and HCI: it prepends their
+// headers, then frees the chain.
+
+#include <time.h>
+#include "os/os_mbuf.h"
+#include "os/os_mempool.h"
+#include "host/ble_hs_mbuf.h"
+#include "check.h"
+
+// The ESP32 msys_1 pool
+#define BLOCK_SIZE 292
+#define BLOCK_COUNT 24
+
+static os_membuf_t mem[OS_MEMPOOL_SIZE(BLOCK_COUNT, BLOCK_SIZE)];
+static struct os_mempool pool;
+static struct os_mbuf_pool mbufPool;
+
+// Reached only if a put to an event queue is needed, which a pool never does
+void npl_freertos_eventq_put(struct ble_npl_eventq *evq, struct ble_npl_event *ev) {
+  __builtin_trap();
+}
+
+static unsigned long sentBytes;
+
+static void transport(struct os_mbuf *om) {
+  om = os_mbuf_prepend(om, 3);     // ATT opcode and handle
+  CHECK(om != NULL);
+  om->om_data[0] = 0x1b;
+  om->om_data[1] = 0x10;
+  om->om_data[2] = 0;
+  om = os_mbuf_prepend(om, 4);     // L2CAP length and CID
+  CHECK(om != NULL);
+  om->om_data[0] = OS_MBUF_PKTLEN(om) - 4;
+  om->om_data[1] = 0;
+  om->om_data[2] = 4;
+  om->om_data[3] = 0;
+  om = os_mbuf_prepend(om, 4);     // HCI ACL header
+  CHECK(om != NULL);
+  sentBytes += OS_MBUF_PKTLEN(om);
+  os_mbuf_free_chain(om);
+}
+
+static double nowNs(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+int main(void) {
+  os_mempool_init(&pool, BLOCK_COUNT, BLOCK_SIZE, mem, "msys_1");
+  os_mbuf_pool_init(&mbufPool, &pool, BLOCK_SIZE, BLOCK_COUNT);
+  os_msys_register(&mbufPool);
+
+  uint8_t value[244];
+  for (int i = 0; i < (int)sizeof(value); i++) value[i] = i;
+
+  const int lengths[] = {20, 64, 244};
+  const int subscribers[] = {1, 4, 8};
+  const int ROUNDS = 500000;
+
+  printf("Notify fan-out, ns per notify (notify(value, length) / notify(om)):\n");
+  for (int l = 0; l < 3; l++) {
+    for (int s = 0; s < 3; s++) {
+      int len = lengths[l];
+      int subs = subscribers[s];
+
+      sentBytes = 0;
+      double start = nowNs();
+      for (int i = 0; i < ROUNDS; i++) {
+        for (int k = 0; k < subs; k++) transport(ble_hs_mbuf_from_flat(value, len));
+      }
+      double fromValue = (nowNs() - start) / ROUNDS;
+      unsigned long expected = sentBytes;
+
+      sentBytes = 0;
+      start = nowNs();
+      for (int i = 0; i < ROUNDS; i++) {
+        struct os_mbuf *om = ble_hs_mbuf_from_flat(value, len);
+        for (int k = 0; k < subs - 1; k++) {
+          struct os_mbuf *copy = ble_hs_mbuf_att_pkt();
+          os_mbuf_appendfrom(copy, om, 0, OS_MBUF_PKTLEN(om));
+          transport(copy);
+        }
+        transport(om);
+      }
+      double fromChain = (nowNs() - start) / ROUNDS;
+      CHECK_EQ(sentBytes, expected);
+
+      printf("  %3d bytes x %d   %6.1f / %6.1f\n", len, subs, fromValue, fromChain);
+    }
+  }
+
+  CHECK_EQ(pool.mp_num_free, BLOCK_COUNT);
+  return checkReport("nimble_notify_bench");
+}
@@ -0,0 +1,103 @@
+// NimBLEScan on the host, replaying the reports of an active scan in a
+// crowded venue (gen_adv_stream.py: 400 advertisers over 60 s) through the
+// scan's GAP event handler. Prints the time and heap allocations per report
+// and how many callbacks the duplicate filter let through twice.
+
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <vector>
+#include "nimble_device.h"
+#include "check.h"
+
+static unsigned long allocations;
+
+void *operator new(size_t size) {
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+struct Report {
+  uint8_t addr[6];
+  uint8_t addrType;
+  uint8_t eventType;
+  int8_t rssi;
+  uint8_t length;
+  uint8_t data[31];
+};
+static_assert(sizeof(Report) == 41, "Report must match gen_adv_stream.py");
+
+static uint64_t addressKey(const uint8_t addr[6]) {
+  uint64_t key = 0;
+  memcpy(&key, addr, 6);
+  return key;
+}
+
+// Callbacks per advertiser, counted without allocating during the replay
+class Counter : public NimBLEAdvertisedDeviceCallbacks {
+public:
+  std::vector<uint64_t> advertisers;
+  std::vector<int> results;
+  unsigned long total = 0;
+
+  void onResult(NimBLEAdvertisedDevice *device) override {
+    uint64_t key = addressKey(device->getAddress().getNative());
+    results[std::lower_bound(advertisers.begin(), advertisers.end(), key) - advertisers.begin()]++;
+    total++;
+  }
+};
+
+typedef std::chrono::steady_clock Clock;
+
+int main(int argc, char **argv) {
+  const char *path = argc > 1 ? argv[1] : "build/adv_stream.bin";
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "%s: run gen_adv_stream.py first\n", path);
+    return 1;
+  }
+  std::vector<Report> reports;
+  Report report;
+  while (fread(&report, sizeof(report), 1, file) == 1) reports.push_back(report);
+  fclose(file);
+
+  NimBLEScan *scan = NimBLEDevice::getScan();
+  Counter counter;
+  for (const Report &r : reports) counter.advertisers.push_back(addressKey(r.addr));
+  std::sort(counter.advertisers.begin(), counter.advertisers.end());
+  counter.advertisers.erase(std::unique(counter.advertisers.begin(), counter.advertisers.end()),
+                            counter.advertisers.end());
+  scan->setAdvertisedDeviceCallbacks(&counter, false);
+  scan->setActiveScan(true);
+
+  printf("Scan replay, %zu reports from %zu advertisers, %d-device pool:\n", reports.size(),
+         counter.advertisers.size(), CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS);
+  // The first pass warms the pool's payload buffers up
+  for (int pass = 0; pass < 2; pass++) {
+    scan->stop();
+    CHECK(scan->start(0, nullptr, false));
+    counter.results.assign(counter.advertisers.size(), 0);
+    counter.total = 0;
+
+    unsigned long allocationsBefore = allocations;
+    auto start = Clock::now();
+    for (const Report &r : reports) {
+      scanReport(r.addr, r.addrType, r.eventType, r.rssi, r.data, r.length);
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    unsigned long replayAllocations = allocations - allocationsBefore;
+
+    int duplicates = 0;
+    for (int result : counter.results) duplicates += std::max(result - 1, 0);
+    printf("  pass %d: %5.0f ns per report, %lu allocations, %lu callbacks, %d duplicate\n", pass + 1,
+           ns / reports.size(), replayAllocations, counter.total, duplicates);
+    CHECK_EQ(scan->getResults().getCount(), CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS);
+    if (pass == 1) CHECK_EQ(replayAllocations, 0);
+  }
+
+  return checkReport("nimble_scan_bench");
+}
@@ -0,0 +1,156 @@
+// NimBLEScan's device pool on the host: a full pool reuses the advertiser
+// heard from least recently, erase() and re-reports go through the address
+// index, and with the duplicate filter on an advertiser dropped from the
+// pool is not reported again when it comes back.
+
+#include <map>
+#include "nimble_device.h"
+#include "check.h"
+
+#define POOL CONFIG_NIMBLE_CPP_SCAN_MAX_RESULTS
+
+class Counter : public NimBLEAdvertisedDeviceCallbacks {
+public:
+  std::map<std::string, int> results;
+  int total = 0;
+
+  void onResult(NimBLEAdvertisedDevice *device) override {
+    results[device->getAddress().toString()]++;
+    total++;
+  }
+};
+
+static NimBLEScan *scan;
+static Counter counter;
+
+static void address(int i, uint8_t out[6]) {
+  for (int k = 0; k < 6; k++) out[k] = (i * 37 + k * 11 + (i >> 8)) & 0xff;
+  out[5] = i & 0xff;
+  out[4] = i >> 8;
+}
+
+static NimBLEAddress nimbleAddress(int i) {
+  ble_addr_t addr = {BLE_ADDR_PUBLIC, {}};
+  address(i, addr.val);
+  return NimBLEAddress(addr);
+}
+
+// A non-connectable advertisement, reported at once on a passive scan
+static void advertise(int i) {
+  static const uint8_t data[] = {2, 1, 6};
+  uint8_t addr[6];
+  address(i, addr);
+  scanReport(addr, BLE_ADDR_PUBLIC, BLE_HCI_ADV_RPT_EVTYPE_NONCONN_IND, -60, data, sizeof(data));
+}
+
+static void restart(bool wantDuplicates) {
+  scan->stop();
+  scan->setAdvertisedDeviceCallbacks(&counter, wantDuplicates);
+  scan->setMaxResults(0xFF);
+  CHECK(scan->start(0, nullptr, false));
+  counter.results.clear();
+  counter.total = 0;
+}
+
+static void testLeastRecentlyHeard() {
+  restart(false);
+  for (int i = 0; i < POOL; i++) advertise(i);
+  CHECK_EQ(scan->getResults().getCount(), POOL);
+
+  // Heard again, so 1 is now the oldest
+  advertise(0);
+  advertise(POOL);
+  NimBLEScanResults results = scan->getResults();
+  CHECK_EQ(results.getCount(), POOL);
+  CHECK(results.getDevice(nimbleAddress(0)) != nullptr);
+  CHECK(results.getDevice(nimbleAddress(1)) == nullptr);
+  CHECK(results.getDevice(nimbleAddress(POOL)) != nullptr);
+}
+
+static void testErase() {
+  restart(false);
+  for (int i = 0; i < POOL; i++) advertise(i);
+  for (int i = 0; i < POOL; i += 2) scan->erase(nimbleAddress(i));
+  NimBLEScanResults results = scan->getResults();
+  CHECK_EQ(results.getCount(), POOL / 2);
+  for (int i = 0; i < POOL; i++) {
+    CHECK_EQ(results.getDevice(nimbleAddress(i)) != nullptr, i % 2 == 1);
+  }
+
+  // Known advertisers update their device, erased ones get a new one
+  for (int i = 0; i < POOL; i++) advertise(i);
+  results = scan->getResults();
+  CHECK_EQ(results.getCount(), POOL);
+  for (int i = 0; i < POOL; i++) CHECK(results.getDevice(nimbleAddress(i)) != nullptr);
+}
+
+static void testDuplicateFilterAcrossEviction() {
+  restart(false);
+  for (int i = 0; i < POOL + 16; i++) advertise(i);
+  CHECK_EQ(counter.total, POOL + 16);
+
+  // The first 16 were dropped for the last 16; back again, still not reported
+  for (int i = 0; i < 16; i++) advertise(i);
+  CHECK_EQ(counter.total, POOL + 16);
+  CHECK_EQ(scan->getResults().getCount(), POOL);
+  CHECK(scan->getResults().getDevice(nimbleAddress(0)) != nullptr);
+
+  // Dropped twice over
+  for (int i = 16; i < POOL + 32; i++) advertise(i);
+  for (int i = 0; i < POOL + 32; i++) advertise(i);
+  CHECK_EQ(counter.total, POOL + 32);
+  for (auto &result : counter.results) CHECK_EQ(result.second, 1);
+
+  // Cleared results report everyone again
+  scan->clearResults();
+  advertise(0);
+  CHECK_EQ(counter.results[nimbleAddress(0).toString()], 2);
+}
+
+// More advertisers than can be remembered: some are reported twice, none
+// more often, and the scan keeps working
+static void testSeenFull() {
+  const int ADVERTISERS = POOL + CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE * 2;
+  restart(false);
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < ADVERTISERS; i++) advertise(i);
+  }
+  CHECK_EQ(counter.results.size(), ADVERTISERS);
+  CHECK(counter.total < 3 * ADVERTISERS);
+  CHECK_EQ(scan->getResults().getCount(), POOL);
+
+  // Up to 3/4 of the table, nobody is reported twice
+  restart(false);
+  const int REMEMBERED = POOL + CONFIG_NIMBLE_CPP_SCAN_SEEN_SIZE * 3 / 4;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < REMEMBERED; i++) advertise(i);
+  }
+  CHECK_EQ(counter.total, REMEMBERED);
+}
+
+static void testDuplicatesWanted() {
+  restart(true);
+  for (int i = 0; i < POOL + 16; i++) advertise(i);
+  for (int i = 0; i < 16; i++) advertise(i);
+  CHECK_EQ(counter.total, POOL + 32);
+}
+
+static void testCallbacksOnly() {
+  restart(false);
+  scan->setMaxResults(0);
+  for (int i = 0; i < POOL + 16; i++) advertise(i);
+  CHECK_EQ(counter.total, POOL + 16);
+  CHECK_EQ(scan->getResults().getCount(), 0);
+}
+
+int main() {
+  scan = NimBLEDevice::getScan();
+  scan->setActiveScan(false);
+  testLeastRecentlyHeard();
+  testErase();
+  testDuplicateFilterAcrossEviction();
+  testSeenFull();
+  testDuplicatesWanted();
+  testCallbacksOnly();
+  return checkReport("nimble_scan_test");
+}
@@ -0,0 +1,246 @@
+// The bond store on the host with 16 bonds and 64 CCCDs over an in-memory
+// NVS: per-record keys from older firmware are migrated into the blobs,
+// lookups through the address index match a linear scan of the arrays, what
+// is persisted restores to the same state, and the reconnect lookups and the
+// NVS calls per update and per restore are measured.
+
+#include <time.h>
+#include "nvs.h"
+#include "host/ble_hs.h"
+#include "store/config/ble_store_config.h"
+#include "ble_store_config_priv.h"
+#include "ble_hs_resolv_priv.h"
+#include "check.h"
+
+#define BONDS MYNEWT_VAL(BLE_STORE_MAX_BONDS)
+#define CCCDS MYNEWT_VAL(BLE_STORE_MAX_CCCDS)
+
+// What the store links against from the rest of the host
+struct ble_hs_cfg ble_hs_cfg;
+
+static struct ble_hs_dev_records devRecords[BONDS + 1];
+static int numDevRecords;
+
+struct ble_hs_dev_records *ble_rpa_get_peer_dev_records(void) { return devRecords; }
+int ble_rpa_get_num_peer_dev_records(void) { return numDevRecords; }
+void ble_rpa_set_num_peer_dev_records(int num) { numDevRecords = num; }
+
+void ble_store_key_from_value_sec(struct ble_store_key_sec *key,
+                                  const struct ble_store_value_sec *value) {
+  memset(key, 0, sizeof(*key));
+  key->peer_addr = value->peer_addr;
+  key->ediv = value->ediv;
+  key->rand_num = value->rand_num;
+  key->ediv_rand_present = 1;
+}
+
+void ble_store_key_from_value_cccd(struct ble_store_key_cccd *key,
+                                   const struct ble_store_value_cccd *value) {
+  memset(key, 0, sizeof(*key));
+  key->peer_addr = value->peer_addr;
+  key->chr_val_handle = value->chr_val_handle;
+}
+
+void ble_hs_log_flat_buf(const void *data, int len) {}
+
+static double nowNs(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static ble_addr_t peer(int i) {
+  ble_addr_t addr = {.type = i & 1};
+  for (int k = 0; k < 6; k++) addr.val[k] = (i * 37 + k * 11) & 0xff;
+  return addr;
+}
+
+static int readSec(int type, int i, union ble_store_value *value) {
+  union ble_store_key key;
+  memset(&key, 0, sizeof(key));
+  key.sec.peer_addr = peer(i);
+  return ble_store_config_read(type, &key, value);
+}
+
+static int readCccd(int i, int skip, union ble_store_value *value) {
+  union ble_store_key key;
+  memset(&key, 0, sizeof(key));
+  key.cccd.peer_addr = peer(i);
+  key.cccd.idx = skip;
+  return ble_store_config_read(BLE_STORE_OBJ_TYPE_CCCD, &key, value);
+}
+
+static void deleteSec(int i) {
+  union ble_store_key key;
+  memset(&key, 0, sizeof(key));
+  key.sec.peer_addr = peer(i);
+  CHECK_EQ(ble_store_config_delete(BLE_STORE_OBJ_TYPE_PEER_SEC, &key), 0);
+}
+
+// Bonds and a CCCD stored one key per record, as before the blobs
+static void testLegacyMigration(void) {
+  struct ble_store_value_sec sec = {0};
+  struct ble_store_value_cccd cccd = {0};
+  sec.peer_addr = peer(100);
+  sec.ediv = 5;
+  nvs_set_blob(1, "peer_sec_1", &sec, sizeof(sec));
+  sec.peer_addr = peer(101);
+  sec.ediv = 6;
+  nvs_set_blob(1, "peer_sec_3", &sec, sizeof(sec));
+  cccd.peer_addr = peer(100);
+  cccd.chr_val_handle = 7;
+  nvs_set_blob(1, "cccd_sec_2", &cccd, sizeof(cccd));
+
+  ble_store_config_init();
+  CHECK_EQ(ble_store_config_num_peer_secs, 2);
+  CHECK_EQ(ble_store_config_num_cccds, 1);
+  CHECK(fake_nvs_has("peer_sec_db"));
+  CHECK(fake_nvs_has("cccd_sec_db"));
+  CHECK(!fake_nvs_has("peer_sec_1"));
+  CHECK(!fake_nvs_has("peer_sec_3"));
+  CHECK(!fake_nvs_has("cccd_sec_2"));
+
+  union ble_store_value value;
+  CHECK_EQ(readSec(BLE_STORE_OBJ_TYPE_PEER_SEC, 101, &value), 0);
+  CHECK_EQ(value.sec.ediv, 6);
+  CHECK_EQ(readCccd(100, 0, &value), 0);
+  CHECK_EQ(value.cccd.chr_val_handle, 7);
+
+  // Migrated once: the next boot reads the blobs as they are
+  ble_store_config_init();
+  CHECK_EQ(ble_store_config_num_peer_secs, 2);
+  CHECK_EQ(ble_store_config_num_cccds, 1);
+
+  fake_nvs_clear();
+  ble_store_config_init();
+  CHECK_EQ(ble_store_config_num_peer_secs, 0);
+  CHECK_EQ(ble_store_config_num_cccds, 0);
+}
+
+static void fill(void) {
+  union ble_store_value value;
+  for (int i = 0; i < BONDS; i++) {
+    memset(&value, 0, sizeof(value));
+    value.sec.peer_addr = peer(i);
+    value.sec.ediv = i;
+    value.sec.rand_num = i * 1000;
+    CHECK_EQ(ble_store_config_write(BLE_STORE_OBJ_TYPE_PEER_SEC, &value), 0);
+    CHECK_EQ(ble_store_config_write(BLE_STORE_OBJ_TYPE_OUR_SEC, &value), 0);
+  }
+  for (int i = 0; i < CCCDS; i++) {
+    memset(&value, 0, sizeof(value));
+    value.cccd.peer_addr = peer(i % BONDS);
+    value.cccd.chr_val_handle = 10 + i / BONDS;
+    value.cccd.flags = 1;
+    CHECK_EQ(ble_store_config_write(BLE_STORE_OBJ_TYPE_CCCD, &value), 0);
+  }
+
+  // Holes in the middle of the arrays
+  for (int i = 0; i < BONDS; i += 5) deleteSec(i);
+  union ble_store_key key;
+  memset(&key, 0, sizeof(key));
+  key.cccd.peer_addr = peer(3);
+  key.cccd.chr_val_handle = 11;
+  CHECK_EQ(ble_store_config_delete(BLE_STORE_OBJ_TYPE_CCCD, &key), 0);
+}
+
+// Every lookup against a scan of the arrays, as the store did before
+static void checkAgainstScan(void) {
+  union ble_store_value value;
+  for (int i = 0; i < BONDS; i++) {
+    int rc = readSec(BLE_STORE_OBJ_TYPE_PEER_SEC, i, &value);
+    CHECK_EQ(rc != 0, i % 5 == 0);
+    if (rc == 0) CHECK_EQ(value.sec.ediv, i);
+
+    ble_addr_t addr = peer(i);
+    for (int skip = 0; skip < 6; skip++) {
+      int expected = -1;
+      for (int j = 0, matches = 0; j < ble_store_config_num_cccds; j++) {
+        if (ble_addr_cmp(&ble_store_config_cccds[j].peer_addr, &addr) == 0 && matches++ == skip) {
+          expected = j;
+          break;
+        }
+      }
+      rc = readCccd(i, skip, &value);
+      CHECK_EQ(rc != 0, expected < 0);
+      if (rc == 0 && expected >= 0) {
+        CHECK_EQ(value.cccd.chr_val_handle, ble_store_config_cccds[expected].chr_val_handle);
+      }
+    }
+  }
+
+  // Keys without an address still go by position or by EDIV/Rand
+  union ble_store_key key;
+  memset(&key, 0, sizeof(key));
+  key.cccd.peer_addr = *BLE_ADDR_ANY;
+  key.cccd.idx = 5;
+  CHECK_EQ(ble_store_config_read(BLE_STORE_OBJ_TYPE_CCCD, &key, &value), 0);
+  CHECK_EQ(value.cccd.chr_val_handle, ble_store_config_cccds[5].chr_val_handle);
+
+  memset(&key, 0, sizeof(key));
+  key.sec.peer_addr = *BLE_ADDR_ANY;
+  key.sec.ediv = 7;
+  key.sec.rand_num = 7000;
+  key.sec.ediv_rand_present = 1;
+  CHECK_EQ(ble_store_config_read(BLE_STORE_OBJ_TYPE_OUR_SEC, &key, &value), 0);
+  CHECK_EQ(value.sec.ediv, 7);
+}
+
+static void testPersist(void) {
+  CHECK_EQ(fake_nvs_size("peer_sec_db"),
+           ble_store_config_num_peer_secs * sizeof(struct ble_store_value_sec));
+  CHECK_EQ(fake_nvs_size("cccd_sec_db"),
+           ble_store_config_num_cccds * sizeof(struct ble_store_value_cccd));
+
+  int peerSecs = ble_store_config_num_peer_secs;
+  int cccds = ble_store_config_num_cccds;
+  ble_store_config_init();
+  CHECK_EQ(ble_store_config_num_peer_secs, peerSecs);
+  CHECK_EQ(ble_store_config_num_cccds, cccds);
+  checkAgainstScan();
+
+  // An update in place is persisted too
+  union ble_store_value value;
+  memset(&value, 0, sizeof(value));
+  value.cccd.peer_addr = peer(2);
+  value.cccd.chr_val_handle = 10;
+  value.cccd.flags = 2;
+  fake_nvs_ops = 0;
+  CHECK_EQ(ble_store_config_write(BLE_STORE_OBJ_TYPE_CCCD, &value), 0);
+  int updateOps = fake_nvs_ops;
+
+  fake_nvs_ops = 0;
+  ble_store_config_init();
+  int restoreOps = fake_nvs_ops;
+  CHECK_EQ(readCccd(2, 0, &value), 0);
+  CHECK_EQ(value.cccd.flags, 2);
+
+  printf("Bond store, %d bonds, %d CCCDs:\n", BONDS, CCCDS);
+  printf("  NVS calls per CCCD update    %4d\n", updateOps);
+  printf("  NVS calls per restore        %4d\n", restoreOps);
+}
+
+// A bonded peer reconnecting: its keys, then all of its CCCDs
+static void benchReconnect(void) {
+  const int ROUNDS = 100000;
+  union ble_store_value value;
+  volatile int sink = 0;
+
+  double start = nowNs();
+  for (int r = 0; r < ROUNDS; r++) {
+    int i = 1 + r % (BONDS - 1);
+    if (i % 5 == 0) i++;
+    sink += readSec(BLE_STORE_OBJ_TYPE_PEER_SEC, i, &value);
+    for (int skip = 0; readCccd(i, skip, &value) == 0; skip++) sink++;
+  }
+  printf("  reconnect lookups, ns        %4.0f\n", (nowNs() - start) / ROUNDS);
+}
+
+int main(void) {
+  testLegacyMigration();
+  fill();
+  checkAgainstScan();
+  testPersist();
+  benchReconnect();
+  return checkReport("nimble_store_test");
+}
@@ -0,0 +1,188 @@
+// OscServer throughput on the host: the in-place parser and route table
+// called directly, then whole datagrams through a UDP loopback socket, and
+// checks that bundles with future timetags are applied on time, in timetag
+// order, and dropped rather than applied early when the queue is full.
+
+#include <chrono>
+#include <sys/time.h>
+#include <lwip/sockets.h>
+#include <vector>
+#include "OscServer.h"
+#include "check.h"
+
+// Timing and WirelessSync are not under test: count what the handlers ask for
+static uint32_t tempoChanges = 0;
+static uint32_t transportChanges = 0;
+void Timing::setTempo(uint16_t) { tempoChanges++; }
+void Timing::play() { transportChanges++; }
+void Timing::pausePlayback() { transportChanges++; }
+void Timing::stopPlayback() { transportChanges++; }
+void WirelessSync::notifyPatternChanged(uint8_t) {}
+WirelessSync *globalWirelessSync = nullptr;
+
+// OSC packet builder (big-endian, 4-byte padded)
+struct OscPacket {
+  std::vector<uint8_t> bytes;
+
+  void pad() {
+    while (bytes.size() & 3) bytes.push_back(0);
+  }
+  void string(const char *s) {
+    bytes.insert(bytes.end(), s, s + strlen(s) + 1);
+    pad();
+  }
+  void u32(uint32_t v) {
+    for (int shift = 24; shift >= 0; shift -= 8) bytes.push_back(v >> shift);
+  }
+  void u64(uint64_t v) {
+    u32(v >> 32);
+    u32((uint32_t)v);
+  }
+  void f32(float f) {
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    u32(v);
+  }
+};
+
+static OscPacket messageFloat(const char *address, float value) {
+  OscPacket p;
+  p.string(address);
+  p.string(",f");
+  p.f32(value);
+  return p;
+}
+
+static OscPacket messageInt(const char *address, int32_t value) {
+  OscPacket p;
+  p.string(address);
+  p.string(",i");
+  p.u32(value);
+  return p;
+}
+
+static OscPacket bundle(uint64_t timetag, const std::vector<OscPacket> &elements) {
+  OscPacket p;
+  p.string("#bundle");
+  p.u64(timetag);
+  for (const OscPacket &element : elements) {
+    p.u32(element.bytes.size());
+    p.bytes.insert(p.bytes.end(), element.bytes.begin(), element.bytes.end());
+  }
+  return p;
+}
+
+// NTP timetag of now + offset
+static uint64_t timetagIn(uint32_t offsetMicros) {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  uint64_t usec = (uint64_t)tv.tv_usec + offsetMicros;
+  uint64_t sec = tv.tv_sec + 2208988800ULL + usec / 1000000;
+  return (sec << 32) | (((usec % 1000000) << 32) / 1000000);
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double nsPerMessage(OscServer &server, const OscPacket &packet, int messagesPerPacket) {
+  const int ROUNDS = 200000;
+  uint32_t handled = server.getMessagesHandled();
+  // Parse in place from a copy, as recv() leaves it in the receive buffer
+  static uint8_t rxBuffer[OSC_RX_BUFFER_SIZE];
+  memcpy(rxBuffer, packet.bytes.data(), packet.bytes.size());
+  auto start = Clock::now();
+  for (int i = 0; i < ROUNDS; i++) {
+    server.handlePacket(rxBuffer, packet.bytes.size());
+  }
+  double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  CHECK_EQ(server.getMessagesHandled() - handled, (uint32_t)ROUNDS * messagesPerPacket);
+  return ns / ROUNDS / messagesPerPacket;
+}
+
+int main() {
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  MetronomeState state;
+  alignas(Timing) static uint8_t timingStorage[sizeof(Timing)];
+  Timing &timing = *reinterpret_cast<Timing *>(timingStorage);
+  OscServer server(state, timing, 0);
+
+  std::vector<OscPacket> eight;
+  for (int i = 0; i < 4; i++) {
+    eight.push_back(messageInt("/metronome/ch1/pattern", 0x5 + i));
+    eight.push_back(messageFloat("/metronome/bpm", 100.0f + i));
+  }
+
+  printf("OSC parse + dispatch, ns per message:\n");
+  printf("  plain address       %6.1f\n", nsPerMessage(server, messageFloat("/metronome/bpm", 120.0f), 1));
+  printf("  channel address     %6.1f\n", nsPerMessage(server, messageInt("/metronome/ch2/length", 7), 1));
+  printf("  pattern (2 routes)  %6.1f\n", nsPerMessage(server, messageInt("/metronome/ch?/enabled", 1), 2));
+  printf("  bundle of 8         %6.1f\n", nsPerMessage(server, bundle(1, eight), 8));
+  CHECK_EQ(server.getPacketsMalformed(), 0);
+  CHECK_EQ(server.getMessagesUnmatched(), 0);
+
+  // Whole datagrams through the socket, drained by update() as in loop()
+  if (!server.begin()) return 1;
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(server.getPort());
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int sender = socket(AF_INET, SOCK_DGRAM, 0);
+
+  const int PACKETS = 100000;
+  const int BURST = 256;
+  OscPacket bpm = messageFloat("/metronome/bpm", 121.0f);
+  uint32_t handled = server.getMessagesHandled();
+  auto start = Clock::now();
+  for (int sent = 0; sent < PACKETS; sent += BURST) {
+    for (int i = 0; i < BURST; i++) {
+      sendto(sender, bpm.bytes.data(), bpm.bytes.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
+    }
+    while (server.getMessagesHandled() - handled < (uint32_t)(sent + BURST)) {
+      server.update();
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("UDP loopback: %.0f messages/s (%d datagrams, send + recv + parse)\n",
+         PACKETS / seconds, PACKETS);
+
+  // A bundle 20 ms ahead is held and applied on time
+  const uint32_t AHEAD_US = 20000;
+  uint32_t scheduled = server.getMessagesScheduled();
+  uint32_t tempo = tempoChanges;
+  uint32_t sentAt = micros();
+  OscPacket later = bundle(timetagIn(AHEAD_US), {messageFloat("/metronome/bpm", 90.0f)});
+  sendto(sender, later.bytes.data(), later.bytes.size(), 0, (struct sockaddr *)&addr, sizeof(addr));
+  while (tempoChanges == tempo && micros() - sentAt < 1000000) {
+    server.update();
+  }
+  uint32_t lateBy = micros() - sentAt - AHEAD_US;
+  CHECK_EQ(server.getMessagesScheduled() - scheduled, 1);
+  CHECK_EQ(state.bpm, 90);
+  CHECK(lateBy < 2000);
+  printf("Timetag 20 ms ahead applied %u us late\n", lateBy);
+
+  // Two bundles due in the same update(): the later timetag wins, whichever
+  // arrived first
+  OscPacket second = bundle(timetagIn(11000), {messageFloat("/metronome/bpm", 130.0f)});
+  OscPacket first = bundle(timetagIn(10000), {messageFloat("/metronome/bpm", 120.0f)});
+  CHECK(server.handlePacket(second.bytes.data(), second.bytes.size()));
+  CHECK(server.handlePacket(first.bytes.data(), first.bytes.size()));
+  delay(20);
+  server.update();
+  CHECK_EQ(state.bpm, 130);
+
+  // A full queue drops what does not fit rather than applying it early
+  uint32_t dropped = server.getMessagesDropped();
+  for (int i = 0; i <= OSC_MAX_PENDING; i++) {
+    OscPacket queued = bundle(timetagIn(10000), {messageFloat("/metronome/bpm", 100.0f + i)});
+    CHECK(server.handlePacket(queued.bytes.data(), queued.bytes.size()));
+  }
+  server.update();
+  CHECK_EQ(server.getMessagesDropped() - dropped, 1);
+  CHECK_EQ(state.bpm, 130);
+  delay(20);
+  server.update();
+  CHECK_EQ(state.bpm, 100 + OSC_MAX_PENDING - 1);
+
+  close(sender);
+  return checkReport("osc_bench");
+}
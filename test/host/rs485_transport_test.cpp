@@ -0,0 +1,223 @@
+// Rs485Transport over pty pairs, through the UART and GPIO stand-ins in
+// stubs/driver/: its receive task, framing and start-bit timestamps, then
+// plugged into WirelessSync as its backend. A second transport on the master
+// side of each pty is the leader.
+
+#include <fcntl.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+#include <mutex>
+#include <vector>
+#include "Rs485Transport.h"
+#include "WirelessSync.h"
+#include "check.h"
+
+// MetronomeChannel reports edits to main.cpp's instance
+WirelessSync *globalWirelessSync = nullptr;
+
+#define BAUD 115200
+#define LINE_DELAY_NS 50000
+
+struct Bus {
+  int master = -1;
+  int slave = -1;
+
+  bool open() {
+    if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0) return false;
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(slave, F_SETFL, O_NONBLOCK);
+    return true;
+  }
+};
+
+// What the receive task delivered, and when
+struct Delivery {
+  SyncMessage msg;
+  uint32_t receivedAt;
+};
+
+static std::mutex deliveredLock;
+static std::vector<Delivery> delivered;
+
+static void onReceive(const uint8_t *, const uint8_t *data, int len) {
+  Delivery d;
+  d.receivedAt = micros();
+  CHECK_EQ(len, sizeof(SyncMessage));
+  memcpy(&d.msg, data, sizeof(d.msg));
+  std::lock_guard<std::mutex> lock(deliveredLock);
+  delivered.push_back(d);
+}
+
+static size_t deliveredCount() {
+  std::lock_guard<std::mutex> lock(deliveredLock);
+  return delivered.size();
+}
+
+// Waits up to a second for the receive task
+template <typename F>
+static bool waitFor(F done) {
+  for (int i = 0; i < 1000; i++) {
+    if (done()) return true;
+    delay(1);
+  }
+  return done();
+}
+
+static SyncMessage message(MessageType type, uint32_t sequenceNum) {
+  SyncMessage msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.groupID = SYNC_GROUP_ID;
+  msg.type = type;
+  memset(msg.deviceID, 0xA5, sizeof(msg.deviceID));
+  msg.sequenceNum = sequenceNum;
+  return msg;
+}
+
+// Every frame arrives once, in order; frames of other sizes are counted and
+// not delivered
+static void testFrames(Rs485Transport &leader, Rs485Transport &follower, const Bus &bus) {
+  delivered.clear();
+  uint32_t before = follower.getFramesReceived();
+  for (uint32_t i = 0; i < 200; i++) {
+    SyncMessage msg = message(MSG_CLOCK, i);
+    CHECK(leader.send((const uint8_t *)&msg, sizeof(msg)));
+  }
+  const uint8_t shortPayload[10] = {};
+  uint8_t frame[SYNC_FRAME_MAX_PAYLOAD + SYNC_FRAME_OVERHEAD];
+  size_t size = syncFrameEncode(shortPayload, sizeof(shortPayload), frame);
+  CHECK_EQ(write(bus.master, frame, size), size);
+
+  CHECK(waitFor([&]() { return follower.getFramesReceived() - before == 201; }));
+  CHECK_EQ(deliveredCount(), 200);
+  for (uint32_t i = 0; i < delivered.size(); i++) CHECK_EQ(delivered[i].msg.sequenceNum, i);
+  CHECK_EQ(follower.getCrcErrors(), 0);
+}
+
+// The timestamp is the first byte's start bit less the line delay, even
+// when the rest of the frame comes much later
+static void testStartBitTimestamp(const Bus &bus) {
+  delivered.clear();
+  SyncMessage msg = message(MSG_CLOCK, 1);
+  uint8_t frame[SYNC_FRAME_MAX_PAYLOAD + SYNC_FRAME_OVERHEAD];
+  size_t size = syncFrameEncode((const uint8_t *)&msg, sizeof(msg), frame);
+
+  uint32_t sent = micros();
+  CHECK_EQ(write(bus.master, frame, 8), 8);
+  delay(20);
+  CHECK_EQ(write(bus.master, frame + 8, size - 8), size - 8);
+  CHECK(waitFor([]() { return deliveredCount() == 1; }));
+
+  int32_t stamped = (uint32_t)delivered[0].msg.timestamp + LINE_DELAY_NS / 1000 - sent;
+  CHECK(stamped >= 0);
+  CHECK(stamped < 5000);
+  CHECK(delivered[0].receivedAt - sent >= 20000);
+}
+
+// A missed start-bit interrupt is made up for from the frame's length at
+// the line rate
+static void testMissedStartBit(Rs485Transport &leader) {
+  delivered.clear();
+  gpioShimMissInterrupts(RS485_RX_PIN, true);
+  SyncMessage msg = message(MSG_CLOCK, 2);
+  CHECK(leader.send((const uint8_t *)&msg, sizeof(msg)));
+  CHECK(waitFor([]() { return deliveredCount() == 1; }));
+  gpioShimMissInterrupts(RS485_RX_PIN, false);
+
+  int32_t frameMicros = (sizeof(SyncMessage) + SYNC_FRAME_OVERHEAD) * 10 * 1000000 / BAUD;
+  int32_t estimate = delivered[0].receivedAt - frameMicros - LINE_DELAY_NS / 1000;
+  int32_t error = (uint32_t)delivered[0].msg.timestamp - estimate;
+  CHECK(error <= 0);
+  CHECK(error > -1000);
+}
+
+// An overflow drops the bytes received so far; the next frame gets through
+static void testOverflow(Rs485Transport &leader, Rs485Transport &follower, const Bus &bus) {
+  delivered.clear();
+  SyncMessage msg = message(MSG_CLOCK, 3);
+  uint8_t frame[SYNC_FRAME_MAX_PAYLOAD + SYNC_FRAME_OVERHEAD];
+  syncFrameEncode((const uint8_t *)&msg, sizeof(msg), frame);
+
+  uartShimOverflow(UART_NUM_0);
+  CHECK_EQ(write(bus.master, frame, 10), 10);
+  CHECK(waitFor([&]() { return follower.getRxOverflows() == 1; }));
+  CHECK(leader.send((const uint8_t *)&msg, sizeof(msg)));
+  CHECK(waitFor([]() { return deliveredCount() == 1; }));
+  CHECK_EQ(delivered[0].msg.sequenceNum, 3);
+  CHECK_EQ(follower.getCrcErrors(), 0);
+}
+
+// The same transport as WirelessSync's backend: group filter, pattern and
+// assignment handling, and latency from the start-bit timestamps
+static void testWirelessSync(Rs485Transport &leader, Rs485Transport &follower) {
+  MetronomeState state;
+  WirelessSync sync;
+  sync.setTransport(&follower);
+  CHECK(sync.init());
+  sync.update(state);
+
+  SyncMessage foreign = message(MSG_CLOCK, 0);
+  foreign.groupID = SYNC_GROUP_ID + 1;
+  CHECK(leader.send((const uint8_t *)&foreign, sizeof(foreign)));
+
+  SyncMessage pattern = message(MSG_PATTERN, 1);
+  pattern.data.pattern.channelId = 1;
+  pattern.data.pattern.barLength = 5;
+  pattern.data.pattern.pattern = 0x15;
+  pattern.data.pattern.enabled = state.getChannel(1).isEnabled();
+  CHECK(leader.send((const uint8_t *)&pattern, sizeof(pattern)));
+
+  SyncMessage assign = message(MSG_ASSIGN, 2);
+  memset(assign.data.assign.targetID, 0xFF, 6);
+  assign.data.assign.channelMask = 0x0006;
+  CHECK(leader.send((const uint8_t *)&assign, sizeof(assign)));
+
+  // The leader stamps in its clock; on one host that is ours
+  for (uint32_t i = 0; i < 8; i++) {
+    SyncMessage clock = message(MSG_CLOCK, 3 + i);
+    clock.timestamp = micros();
+    CHECK(leader.send((const uint8_t *)&clock, sizeof(clock)));
+  }
+
+  CHECK(waitFor([&]() { return follower.getFramesReceived() == 11; }));
+  delay(10);
+  CHECK_EQ(sync.getForeignFrameCount(), 1);
+  CHECK_EQ(state.getChannel(1).getBarLength(), 5);
+  CHECK_EQ(state.getChannel(1).getPattern(), 0x15);
+  CHECK_EQ(sync.getChannelMask(), 0x0006);
+  CHECK(sync.getLatency() >= LINE_DELAY_NS / 1000);
+  CHECK(sync.getLatency() < 5000);
+}
+
+int main() {
+  Bus a, b;
+  if (!a.open() || !b.open()) {
+    perror("openpty");
+    return 1;
+  }
+
+  // Bus a: the transport's own behaviour
+  uartShimAttach(UART_NUM_0, a.slave);
+  uartShimAttach(UART_NUM_1, a.master);
+  Rs485Transport follower(UART_NUM_0, RS485_TX_PIN, RS485_RX_PIN, RS485_DE_PIN, BAUD);
+  Rs485Transport leader(UART_NUM_1, RS485_TX_PIN, RS485_RX_PIN + 1, RS485_DE_PIN, BAUD);
+  follower.setLineDelay(LINE_DELAY_NS);
+  CHECK(follower.begin(onReceive));
+  testFrames(leader, follower, a);
+  testStartBitTimestamp(a);
+  testMissedStartBit(leader);
+  testOverflow(leader, follower, a);
+
+  // Bus b: behind WirelessSync
+  uartShimAttach(UART_NUM_2, b.slave);
+  uartShimAttach(UART_NUM_3, b.master);
+  Rs485Transport syncFollower(UART_NUM_2, RS485_TX_PIN, RS485_RX_PIN + 2, RS485_DE_PIN, BAUD);
+  Rs485Transport syncLeader(UART_NUM_3, RS485_TX_PIN, RS485_RX_PIN + 3, RS485_DE_PIN, BAUD);
+  syncFollower.setLineDelay(LINE_DELAY_NS);
+  testWirelessSync(syncLeader, syncFollower);
+
+  return checkReport("rs485_transport_test");
+}
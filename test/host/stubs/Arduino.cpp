@@ -0,0 +1,23 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <uClock.h>
+#include <esp_timer.h>
+#include <time.h>
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+uClockClass uClock;
+
+int64_t esp_timer_get_time() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint32_t micros() { return (uint32_t)esp_timer_get_time(); }
+uint32_t millis() { return (uint32_t)(esp_timer_get_time() / 1000); }
+
+void delay(uint32_t ms) {
+  struct timespec ts = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000};
+  nanosleep(&ts, nullptr);
+}
@@ -0,0 +1,93 @@
+#pragma once
+// Just enough of the Arduino core to build firmware sources on the host
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include <algorithm>
+
+#define IRAM_ATTR
+
+#define HEX 16
+#define DEC 10
+
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t ms);
+inline void yield() {}
+inline int xPortGetCoreID() { return 0; }
+inline void configTime(long, int, const char *, const char * = nullptr, const char * = nullptr) {}
+inline long random(long low, long high) { return low + rand() % (high - low); }
+
+template <typename T, typename L, typename H>
+inline T constrain(T value, L low, H high) {
+  return value < (T)low ? (T)low : value > (T)high ? (T)high : value;
+}
+
+typedef uint8_t byte;
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+using std::max;
+using std::min;
+
+// FreeRTOS spinlocks; the host tests drive each object from one thread
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+inline void portENTER_CRITICAL(portMUX_TYPE *) {}
+inline void portEXIT_CRITICAL(portMUX_TYPE *) {}
+
+// Byte stream with the formatted printing the firmware uses
+class Stream {
+public:
+  virtual ~Stream() {}
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() = 0;
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t *data, size_t len) {
+    size_t n = 0;
+    while (len--) n += write(*data++);
+    return n;
+  }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t println(const char *s = "") { return print(s) + print("\n"); }
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return n > 0 ? write((const uint8_t *)buffer, std::min((size_t)n, sizeof(buffer) - 1)) : 0;
+  }
+};
+
+// Console output goes to stdout; nothing is ever available to read
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override { fflush(stdout); }
+  int availableForWrite() { return 4096; }
+  size_t write(const uint8_t *data, size_t len) override { return fwrite(data, 1, len, stdout); }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t print(const char *s) { return printf("%s", s); }
+  size_t print(long v, int base = DEC) { return printf(base == HEX ? "%lx" : "%ld", v); }
+  size_t println(const char *s = "") { return printf("%s\n", s); }
+  size_t println(long v, int base = DEC) { return printf(base == HEX ? "%lx\n" : "%ld\n", v); }
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n;
+  }
+};
+
+extern HardwareSerial Serial;
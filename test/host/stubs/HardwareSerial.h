@@ -0,0 +1,3 @@
+#pragma once
+// HardwareSerial is declared with the rest of the Arduino stand-ins
+#include "Arduino.h"
@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Stores nothing: every get returns its default
+class Preferences {
+public:
+  bool begin(const char *, bool) { return true; }
+  void end() {}
+  bool clear() { return true; }
+  size_t putUShort(const char *, uint16_t) { return 2; }
+  size_t putUChar(const char *, uint8_t) { return 1; }
+  size_t putBool(const char *, bool) { return 1; }
+  size_t putBytes(const char *, const void *, size_t len) { return len; }
+  uint16_t getUShort(const char *, uint16_t fallback = 0) { return fallback; }
+  uint8_t getUChar(const char *, uint8_t fallback = 0) { return fallback; }
+  bool getBool(const char *, bool fallback = false) { return fallback; }
+  size_t getBytes(const char *, void *, size_t) { return 0; }
+};
@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+
+#define WIFI_STA 1
+
+class WiFiClass {
+public:
+  void begin(const char *, const char *) {}
+  void mode(int) {}
+  void macAddress(uint8_t *mac) { memset(mac, 0, 6); }
+};
+
+extern WiFiClass WiFi;
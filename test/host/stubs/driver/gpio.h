@@ -0,0 +1,18 @@
+#pragma once
+#include <esp_timer.h>
+
+// GPIO interrupts, as far as the UART's start-bit stamp needs them; the UART
+// stand-in in driver/uart.h fires them
+
+typedef int gpio_num_t;
+typedef enum { GPIO_INTR_DISABLE = 0, GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE } gpio_int_type_t;
+typedef void (*gpio_isr_t)(void *arg);
+
+esp_err_t gpio_install_isr_service(int intrFlags);
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type);
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void *arg);
+esp_err_t gpio_intr_enable(gpio_num_t pin);
+esp_err_t gpio_intr_disable(gpio_num_t pin);
+
+// Host only: drop the pin's interrupts, as if they had been missed
+void gpioShimMissInterrupts(gpio_num_t pin, bool miss);
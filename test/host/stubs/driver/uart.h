@@ -0,0 +1,73 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_timer.h>
+
+// The ESP-IDF UART driver, with each port backed by a file descriptor (one
+// side of a pty in the tests). The driver's receive events come from
+// xQueueReceive() on the event queue, which waits for the descriptor to
+// become readable, fires the RX pin's start-bit interrupt if it is enabled,
+// then reports the bytes waiting as one UART_DATA event.
+
+#define ESP_ERR_INVALID_STATE 0x103
+
+typedef int uart_port_t;
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+#define UART_NUM_2 2
+#define UART_NUM_3 3  // Host only: a second bus in the tests
+#define UART_NUM_MAX 4
+#define UART_PIN_NO_CHANGE -1
+
+typedef enum { UART_DATA_8_BITS = 3 } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0 } uart_hw_flowcontrol_t;
+typedef enum { UART_MODE_UART = 0, UART_MODE_RS485_HALF_DUPLEX = 1 } uart_mode_t;
+
+typedef struct {
+  int baud_rate;
+  uart_word_length_t data_bits;
+  uart_parity_t parity;
+  uart_stop_bits_t stop_bits;
+  uart_hw_flowcontrol_t flow_ctrl;
+} uart_config_t;
+
+typedef enum { UART_DATA, UART_BREAK, UART_BUFFER_FULL, UART_FIFO_OVF, UART_FRAME_ERR } uart_event_type_t;
+
+typedef struct {
+  uart_event_type_t type;
+  size_t size;
+} uart_event_t;
+
+// FreeRTOS, as far as the UART driver's users need it
+typedef struct UartQueue *QueueHandle_t;
+typedef struct UartTask *TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define configMAX_PRIORITIES 25
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+BaseType_t xQueueReset(QueueHandle_t queue);
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void *), const char *name, uint32_t stackDepth,
+                                   void *arg, int priority, TaskHandle_t *handle, int core);
+
+esp_err_t uart_driver_install(uart_port_t port, int rxBufferSize, int txBufferSize, int queueSize,
+                              QueueHandle_t *queue, int intrFlags);
+esp_err_t uart_driver_delete(uart_port_t port);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config);
+esp_err_t uart_set_pin(uart_port_t port, int txPin, int rxPin, int rtsPin, int ctsPin);
+esp_err_t uart_set_mode(uart_port_t port, uart_mode_t mode);
+esp_err_t uart_set_rx_timeout(uart_port_t port, uint8_t symbols);
+int uart_read_bytes(uart_port_t port, void *buffer, uint32_t length, TickType_t ticks);
+int uart_write_bytes(uart_port_t port, const void *data, size_t size);
+esp_err_t uart_flush_input(uart_port_t port);
+
+// Host only: back a port with fd (call before uart_driver_install())
+void uartShimAttach(uart_port_t port, int fd);
+// Host only: report an RX overflow before the port's next data event
+void uartShimOverflow(uart_port_t port);
@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+#include <esp_timer.h>
+
+// ESP-NOW is not there on the host: initializing it fails
+typedef void (*esp_now_recv_cb_t)(const uint8_t *mac, const uint8_t *data, int len);
+typedef struct {
+  uint8_t peer_addr[6];
+  uint8_t channel;
+  bool encrypt;
+} esp_now_peer_info_t;
+
+inline esp_err_t esp_now_init() { return ESP_FAIL; }
+inline esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t) { return ESP_FAIL; }
+inline esp_err_t esp_now_add_peer(const esp_now_peer_info_t *) { return ESP_FAIL; }
+inline esp_err_t esp_now_send(const uint8_t *, const uint8_t *, size_t) { return ESP_FAIL; }
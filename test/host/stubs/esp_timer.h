@@ -0,0 +1,22 @@
+#pragma once
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
+
+// Timers never fire on the host; creating one fails
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+typedef struct esp_timer *esp_timer_handle_t;
+typedef void (*esp_timer_cb_t)(void *arg);
+typedef struct {
+  esp_timer_cb_t callback;
+  void *arg;
+  int dispatch_method;
+  const char *name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t *, esp_timer_handle_t *) { return ESP_FAIL; }
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t, uint64_t) { return ESP_FAIL; }
+inline esp_err_t esp_timer_stop(esp_timer_handle_t) { return ESP_FAIL; }
@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+
+class uClockClass {
+public:
+  float tempo = 120.0f;
+  float getTempo() { return tempo; }
+  void setTempo(float bpm) { tempo = bpm; }
+  uint32_t bpmToMicroSeconds(float bpm) { return 60000000.0f / bpm; }
+};
+
+extern uClockClass uClock;
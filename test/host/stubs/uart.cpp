@@ -0,0 +1,138 @@
+#include <driver/gpio.h>
+#include <driver/uart.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <atomic>
+#include <utility>
+
+struct UartQueue {
+  uart_port_t port;
+};
+
+struct Uart {
+  int fd = -1;
+  int rxPin = -1;
+  UartQueue queue;
+  std::atomic<bool> overflow{false};
+};
+
+struct GpioPin {
+  gpio_isr_t handler = nullptr;
+  void *arg = nullptr;
+  std::atomic<bool> enabled{false};
+  std::atomic<bool> miss{false};
+};
+
+static Uart uarts[UART_NUM_MAX];
+static GpioPin pins[40];
+
+void uartShimAttach(uart_port_t port, int fd) { uarts[port].fd = fd; }
+void uartShimOverflow(uart_port_t port) { uarts[port].overflow = true; }
+void gpioShimMissInterrupts(gpio_num_t pin, bool miss) { pins[pin].miss = miss; }
+
+esp_err_t uart_driver_install(uart_port_t port, int, int, int, QueueHandle_t *queue, int) {
+  if (uarts[port].fd < 0) return ESP_FAIL;
+  uarts[port].queue.port = port;
+  *queue = &uarts[port].queue;
+  return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t) { return ESP_OK; }
+esp_err_t uart_param_config(uart_port_t, const uart_config_t *) { return ESP_OK; }
+esp_err_t uart_set_mode(uart_port_t, uart_mode_t) { return ESP_OK; }
+esp_err_t uart_set_rx_timeout(uart_port_t, uint8_t) { return ESP_OK; }
+
+esp_err_t uart_set_pin(uart_port_t port, int, int rxPin, int, int) {
+  uarts[port].rxPin = rxPin;
+  return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void *buffer, uint32_t length, TickType_t) {
+  return read(uarts[port].fd, buffer, length);
+}
+
+int uart_write_bytes(uart_port_t port, const void *data, size_t size) {
+  const uint8_t *p = (const uint8_t *)data;
+  size_t left = size;
+  while (left > 0) {
+    ssize_t n = write(uarts[port].fd, p, left);
+    if (n <= 0) return -1;
+    p += n;
+    left -= n;
+  }
+  return size;
+}
+
+esp_err_t uart_flush_input(uart_port_t port) {
+  uint8_t buffer[256];
+  struct pollfd pfd = {uarts[port].fd, POLLIN, 0};
+  while (poll(&pfd, 1, 0) > 0 && read(uarts[port].fd, buffer, sizeof(buffer)) > 0) {
+  }
+  return ESP_OK;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+  Uart &uart = uarts[queue->port];
+  uart_event_t *event = (uart_event_t *)item;
+  struct pollfd pfd = {uart.fd, POLLIN, 0};
+  if (poll(&pfd, 1, ticks == portMAX_DELAY ? -1 : (int)ticks) <= 0) return pdFALSE;
+
+  if (uart.overflow.exchange(false)) {
+    event->type = UART_BUFFER_FULL;
+    event->size = 0;
+    return pdTRUE;
+  }
+
+  // The first byte's start bit, just before the bytes are handed over
+  GpioPin &pin = pins[uart.rxPin];
+  if (pin.enabled && pin.handler != nullptr && !pin.miss) {
+    pin.handler(pin.arg);
+  }
+
+  int available = 0;
+  ioctl(uart.fd, FIONREAD, &available);
+  event->type = UART_DATA;
+  event->size = available;
+  return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t) { return pdPASS; }
+
+// Tasks are detached threads that run until the test exits
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void *), const char *, uint32_t, void *arg, int,
+                                   TaskHandle_t *handle, int) {
+  pthread_t thread;
+  if (pthread_create(&thread, nullptr, [](void *p) -> void * {
+        auto *start = (std::pair<void (*)(void *), void *> *)p;
+        auto entry = *start;
+        delete start;
+        entry.first(entry.second);
+        return nullptr;
+      }, new std::pair<void (*)(void *), void *>(task, arg)) != 0) {
+    return pdFALSE;
+  }
+  pthread_detach(thread);
+  if (handle != nullptr) *handle = (TaskHandle_t)thread;
+  return pdPASS;
+}
+
+esp_err_t gpio_install_isr_service(int) { return ESP_OK; }
+esp_err_t gpio_set_intr_type(gpio_num_t, gpio_int_type_t) { return ESP_OK; }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void *arg) {
+  pins[pin].handler = handler;
+  pins[pin].arg = arg;
+  return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t pin) {
+  pins[pin].enabled = true;
+  return ESP_OK;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t pin) {
+  pins[pin].enabled = false;
+  return ESP_OK;
+}
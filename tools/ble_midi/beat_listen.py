@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Follow the leader's BLE beat broadcast without connecting.
+
+Decodes the timeline anchor (src/BleBeatBroadcast.h) from the manufacturer
+data of legacy advertising and prints when each beat should fall on this
+host's clock. Desktop BLE stacks don't expose periodic advertising sync, so
+this follows the ESP32 (scan response) build; the payload is the same.
+
+    ./beat_listen.py                # needs bleak
+    ./beat_listen.py --company 0xFFFF
+"""
+
+import argparse
+import asyncio
+import struct
+import time
+
+from bleak import BleakScanner
+
+BEAT_MAGIC = 0xB1
+FLAG_RUNNING = 0x01
+FLAG_PAUSED = 0x02
+# After the company ID: magic, seq, flags, bpm/100, beat, anchor us, sent us
+ANCHOR_FORMAT = "<BBBHHII"
+
+
+class Follower:
+    """Maps the leader's micros() onto the local clock.
+
+    Every update is heard some time after the leader stamped it; the
+    smallest (receive - sent) seen so far is the best offset estimate.
+    """
+
+    def __init__(self):
+        self.offset = None
+        self.seq = None
+
+    def feed(self, payload, received_us):
+        magic, seq, flags, bpm_centi, beat, anchor_us, sent_us = struct.unpack(ANCHOR_FORMAT, payload)
+        if magic != BEAT_MAGIC or seq == self.seq:
+            return
+        self.seq = seq
+
+        offset = (received_us - sent_us) % (1 << 32)
+        if self.offset is None or offset < self.offset:
+            self.offset = offset
+
+        if not flags & FLAG_RUNNING:
+            print("seq %3d: %s, %.2f BPM" % (seq, "paused" if flags & FLAG_PAUSED else "stopped",
+                                             bpm_centi / 100))
+            return
+        period_us = 6e9 / bpm_centi
+        local_anchor = (anchor_us + self.offset) % (1 << 32)
+        now = received_us % (1 << 32)
+        ahead = (local_anchor - now + (1 << 31)) % (1 << 32) - (1 << 31)
+        beats_since = max(0, int(-ahead // period_us) + 1)
+        next_beat = ahead + beats_since * period_us
+        print("seq %3d: %.2f BPM, beat %d in %.1f ms (offset estimate %d us)" % (
+            seq, bpm_centi / 100, (beat + beats_since) & 0xFFFF, next_beat / 1000, self.offset))
+
+
+async def run(args):
+    follower = Follower()
+
+    def on_advertisement(device, adv):
+        data = adv.manufacturer_data.get(args.company)
+        if data is not None and len(data) == struct.calcsize(ANCHOR_FORMAT):
+            follower.feed(data, int(time.monotonic() * 1e6))
+
+    async with BleakScanner(on_advertisement, scanning_mode="active"):
+        await asyncio.sleep(args.seconds)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--company", type=lambda s: int(s, 0), default=0xFFFF,
+                        help="BLE_BEAT_COMPANY_ID")
+    parser.add_argument("--seconds", type=float, default=60)
+    args = parser.parse_args()
+    asyncio.run(run(args))
+
+
+if __name__ == "__main__":
+    main()
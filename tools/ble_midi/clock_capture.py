@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Capture the metronome's BLE-MIDI clock and measure how well it is stamped.
+
+Subscribes to the MIDI characteristic with clock output on ('clock on' or
+CH15 CC5 on the BLE example) and records every Timing Clock (F8) with its
+13-bit BLE-MIDI timestamp and the host time its notification arrived. Each
+series is fitted to a straight line over the clock index; the residuals are
+how far each clock sits off a steady grid. The timestamp residual is the
+error a receiver that honours the stamps sees, the arrival residual is what
+it would see going by receive time alone.
+
+    ./clock_capture.py --seconds 30                 # needs bleak
+
+Stamps have 1 ms resolution, so a perfectly stamped clock still shows up
+to 0.5 ms of timestamp residual. A fit over a tempo change is meaningless;
+keep the tempo fixed during the capture.
+"""
+
+import argparse
+import asyncio
+import time
+
+from bleak import BleakClient, BleakScanner
+
+MIDI_CHARACTERISTIC = "7772e5db-3868-4112-a1a9-f2669d106bf3"
+TIMING_CLOCK = 0xF8
+STAMP_WRAP_MS = 1 << 13
+
+
+def clock_stamps(packet):
+    """Yields the 13-bit timestamp of every F8 in a BLE-MIDI packet."""
+    if len(packet) < 3 or not packet[0] & 0x80:
+        return
+    high = packet[0] & 0x3F
+    last_low = None
+    expect_timestamp = True
+    for byte in packet[1:]:
+        if not byte & 0x80:
+            expect_timestamp = True  # data byte; the next status gets a timestamp
+            continue
+        if expect_timestamp:
+            low = byte & 0x7F
+            if last_low is not None and low < last_low:
+                high = (high + 1) & 0x3F  # low bits wrapped inside the packet
+            last_low = low
+            stamp = (high << 7) | low
+            expect_timestamp = False
+        else:
+            if byte == TIMING_CLOCK:
+                yield stamp
+            expect_timestamp = True
+
+
+def residuals(values):
+    """Distance of each value from the least-squares line over its index."""
+    n = len(values)
+    mean_x = (n - 1) / 2
+    mean_y = sum(values) / n
+    sxx = sum((i - mean_x) ** 2 for i in range(n))
+    sxy = sum((i - mean_x) * (v - mean_y) for i, v in enumerate(values))
+    slope = sxy / sxx
+    return [v - (mean_y + slope * (i - mean_x)) for i, v in enumerate(values)], slope
+
+
+def report(name, values_ms):
+    res, slope = residuals(values_ms)
+    rms = (sum(r * r for r in res) / len(res)) ** 0.5
+    print("%-9s period %.3f ms, residual rms %.3f ms, max %.3f ms" % (
+        name, slope, rms, max(abs(r) for r in res)))
+
+
+async def run(args):
+    device = await BleakScanner.find_device_by_name(args.name, timeout=10.0)
+    if device is None:
+        raise SystemExit("%s not found" % args.name)
+
+    stamps = []
+    arrivals = []
+    state = {"last": None, "base": 0}
+
+    def on_notify(_, data):
+        received = time.perf_counter() * 1000
+        for stamp in clock_stamps(data):
+            if state["last"] is not None and stamp < state["last"]:
+                state["base"] += STAMP_WRAP_MS
+            state["last"] = stamp
+            stamps.append(state["base"] + stamp)
+            arrivals.append(received)
+
+    async with BleakClient(device) as client:
+        await client.start_notify(MIDI_CHARACTERISTIC, on_notify)
+        await asyncio.sleep(args.seconds)
+        await client.stop_notify(MIDI_CHARACTERISTIC)
+
+    if len(stamps) < 3:
+        raise SystemExit("only %d clocks received; is clock output on?" % len(stamps))
+    print("%d clocks in %.1f s" % (len(stamps), args.seconds))
+    report("timestamp", stamps)
+    report("arrival", arrivals)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--name", default="Metronome", help="advertised device name")
+    parser.add_argument("--seconds", type=float, default=30)
+    args = parser.parse_args()
+    asyncio.run(run(args))
+
+
+if __name__ == "__main__":
+    main()
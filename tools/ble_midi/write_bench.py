@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Sustained BLE-MIDI write load, like a controller sweeping faders.
+
+Connects to the metronome's BLE-MIDI service and writes (without response)
+packets of control changes at a fixed rate. The CCs go to a controller the
+firmware doesn't map, so the run doesn't change the metronome's state.
+
+    ./write_bench.py --rate 200 --seconds 60          # needs bleak
+    ./write_bench.py --messages 8 --rate 100
+
+Read the device side afterwards: `midistats` on the BLE example prints
+packets received and parse time per packet; the main firmware built with
+ENABLE_HEAP_MONITOR must keep reporting allocations=0 during the run.
+"""
+
+import argparse
+import asyncio
+import time
+
+from bleak import BleakClient, BleakScanner
+
+MIDI_CHARACTERISTIC = "7772e5db-3868-4112-a1a9-f2669d106bf3"
+UNMAPPED_CC = 119
+
+
+def midi_packet(channel, messages, value, now_ms):
+    """One BLE-MIDI packet: header, then timestamp + CC per message."""
+    header = 0x80 | ((now_ms >> 7) & 0x3F)
+    packet = bytearray([header])
+    for i in range(messages):
+        packet += bytes([0x80 | (now_ms & 0x7F), 0xB0 | channel, UNMAPPED_CC, (value + i) & 0x7F])
+    return bytes(packet)
+
+
+async def run(args):
+    device = await BleakScanner.find_device_by_name(args.name, timeout=10.0)
+    if device is None:
+        raise SystemExit("%s not found" % args.name)
+
+    async with BleakClient(device) as client:
+        interval = 1.0 / args.rate
+        count = int(args.rate * args.seconds)
+        late = 0
+        start = time.perf_counter()
+        for i in range(count):
+            due = start + i * interval
+            delay = due - time.perf_counter()
+            if delay > 0:
+                await asyncio.sleep(delay)
+            elif delay < -interval:
+                late += 1
+            now_ms = int((time.perf_counter() - start) * 1000) & 0x1FFF
+            await client.write_gatt_char(MIDI_CHARACTERISTIC,
+                                         midi_packet(args.channel - 1, args.messages, i, now_ms),
+                                         response=False)
+        elapsed = time.perf_counter() - start
+
+    print("%d packets (%d messages each) in %.1f s: %.0f packets/s, %.0f messages/s" % (
+        count, args.messages, elapsed, count / elapsed, count * args.messages / elapsed))
+    print("%d packets sent more than one interval late" % late)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--name", default="Metronome", help="advertised device name")
+    parser.add_argument("--channel", type=int, default=15, help="MIDI channel (1-16)")
+    parser.add_argument("--rate", type=float, default=200, help="packets per second")
+    parser.add_argument("--messages", type=int, default=4, help="CCs per packet")
+    parser.add_argument("--seconds", type=float, default=30)
+    args = parser.parse_args()
+    asyncio.run(run(args))
+
+
+if __name__ == "__main__":
+    main()
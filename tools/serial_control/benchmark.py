@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Loopback throughput and latency benchmark for the serial control protocol.
+
+A pty pair stands in for the USB serial port: a simulated device on one end
+decodes frames and acknowledges them, the client on the other end pipelines
+commands and measures round-trip time. By default the device is a Python
+thread using this package's framing code; --responder runs the C++ one from
+test/host instead, which frames with the firmware's src/ControlFrame.h. This
+measures the host stack and framing cost; run against real hardware with
+--port to include the UART and firmware.
+
+    ./benchmark.py                      # pty loopback, Python device
+    ./benchmark.py --responder ../../test/host/build/control_responder
+    ./benchmark.py --port /dev/ttyUSB0  # device (needs pyserial)
+"""
+
+import argparse
+import os
+import struct
+import subprocess
+import threading
+import time
+import tty
+
+import metronome_control as mc
+
+
+def simulated_device(fd, stop):
+    """Acks every valid command, like SerialControl::handleFrame()."""
+    reader = mc.FrameReader()
+    start = time.perf_counter()
+    while not stop.is_set():
+        try:
+            data = os.read(fd, 4096)
+        except OSError:
+            return
+        out = bytearray()
+        for frame_type, seq, _ in reader.feed(data):
+            status = mc.CTRL_OK if frame_type < 0x80 else mc.CTRL_ERR_TYPE
+            micros = int((time.perf_counter() - start) * 1e6) & 0xFFFFFFFF
+            ack = struct.pack(mc.ACK_FORMAT, frame_type, status, micros)
+            out += mc.encode_frame(mc.CTRL_ACK, seq, ack)
+        if out:
+            os.write(fd, out)
+
+
+class FdPort:
+    def __init__(self, fd):
+        self.fd = fd
+
+    def read(self, size):
+        return os.read(self.fd, size)
+
+    def write(self, data):
+        os.write(self.fd, data)
+
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def run(client, count, window):
+    rtts = []
+    in_flight = []
+    commands = [
+        (mc.CTRL_SET_BPM, struct.pack("<H", 120)),
+        (mc.CTRL_SET_PATTERN, struct.pack("<BBH", 0, 4, 0b1001)),
+        (mc.CTRL_TRANSPORT, bytes([mc.CTRL_PLAY])),
+        (mc.CTRL_PING, b""),
+    ]
+
+    start = time.perf_counter()
+    for i in range(count):
+        if len(in_flight) >= window:
+            rtts.append(client.wait_ack(in_flight.pop(0))[3])
+        frame_type, payload = commands[i % len(commands)]
+        in_flight.append(client.send(frame_type, payload))
+    for seq in in_flight:
+        rtts.append(client.wait_ack(seq)[3])
+    elapsed = time.perf_counter() - start
+
+    print("%d commands, window %d: %.0f commands/s" % (count, window, count / elapsed))
+    print("round trip: p50 %.0f us, p99 %.0f us, max %.0f us" % (
+        percentile(rtts, 50) * 1e6, percentile(rtts, 99) * 1e6, max(rtts) * 1e6))
+    print("crc errors %d, framing errors %d" % (
+        client.reader.crc_errors, client.reader.framing_errors))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", help="serial device (default: pty loopback)")
+    parser.add_argument("--responder",
+                        help="device program for the pty loopback, given the tty path "
+                             "(default: simulated in Python)")
+    parser.add_argument("--baud", type=int, default=921600)
+    parser.add_argument("--count", type=int, default=20000)
+    parser.add_argument("--window", type=int, default=1,
+                        help="commands in flight (1 = measure pure latency)")
+    args = parser.parse_args()
+
+    stop = threading.Event()
+    responder = None
+    if args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+    else:
+        master, slave = os.openpty()
+        tty.setraw(master)
+        tty.setraw(slave)
+        if args.responder:
+            responder = subprocess.Popen([args.responder, os.ttyname(slave)])
+        else:
+            threading.Thread(target=simulated_device, args=(slave, stop), daemon=True).start()
+        port = FdPort(master)
+
+    client = mc.MetronomeControl(port)
+    client.ping()
+    run(client, args.count, args.window)
+    client.close()
+    stop.set()
+    if responder:
+        responder.terminate()
+        responder.wait()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,277 @@
+"""Host client for the metronome's binary serial control protocol.
+
+Wire format (see src/ControlFrame.h):
+
+    0x00 [COBS( type | seq | payload ... | crc16 hi | crc16 lo )] 0x00
+
+CRC-16/CCITT (init 0xFFFF) over type, seq and payload; payload fields are
+little-endian. Works with any object that has read()/write() on bytes, e.g. a
+pyserial Serial or a file opened on a pty.
+"""
+
+import struct
+import threading
+import time
+
+# Frame types
+CTRL_PING = 0x01
+CTRL_SET_BPM = 0x02
+CTRL_TRANSPORT = 0x03
+CTRL_SET_PATTERN = 0x04
+CTRL_SET_ENABLED = 0x05
+CTRL_SET_MULTIPLIER = 0x06
+CTRL_SET_MODE = 0x07
+CTRL_SUBSCRIBE = 0x08
+CTRL_ASSIGN_CHANNELS = 0x09
+CTRL_CLEAR_ASSIGNMENTS = 0x0A
+CTRL_SET_GROUP = 0x0B
+CTRL_GET_SYNC_STATUS = 0x0C
+CTRL_SEND_LAYOUT = 0x0D
+CTRL_ACK = 0x80
+CTRL_SYNC_STATUS = 0x81
+CTRL_EVENT_BEAT = 0x90
+CTRL_EVENT_TRACE = 0x91
+
+# Ack status
+CTRL_OK = 0
+CTRL_ERR_TYPE = 1
+CTRL_ERR_LENGTH = 2
+CTRL_ERR_VALUE = 3
+CTRL_ERR_STATE = 4
+
+# Transport actions
+CTRL_PLAY = 0
+CTRL_PAUSE = 1
+CTRL_STOP = 2
+
+CTRL_EVENTS_BEAT = 0x01
+
+ACK_FORMAT = "<BBI"          # command, status, device micros
+BEAT_FORMAT = "<BBII"        # channel, beat state, device micros, dropped
+SYNC_STATUS_FORMAT = "<HBHII"  # group, is leader, channel mask, foreign, legacy
+LAYOUT_TEMPO = 0xFF          # Segment channel showing the beat
+LAYOUT_REVERSE = 0x01        # Segment flag: runs from its last LED
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_pos = 0
+    code = 1
+    for b in data:
+        if b != 0:
+            out.append(b)
+            code += 1
+        if b == 0 or code == 0xFF:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+    out[code_pos] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            raise ValueError("malformed COBS block")
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(frame_type, seq, payload=b""):
+    raw = bytes([frame_type, seq & 0xFF]) + payload
+    raw += struct.pack(">H", crc16(raw))
+    return b"\x00" + cobs_encode(raw) + b"\x00"
+
+
+class FrameReader:
+    """Splits a byte stream into (type, seq, payload) frames and text."""
+
+    def __init__(self):
+        self.in_frame = False
+        self.buffer = bytearray()
+        self.text = bytearray()
+        self.crc_errors = 0
+        self.framing_errors = 0
+
+    def feed(self, data):
+        frames = []
+        for b in data:
+            if b != 0:
+                (self.buffer if self.in_frame else self.text).append(b)
+                continue
+            if not self.in_frame:
+                self.in_frame = True
+                self.buffer.clear()
+                continue
+            if not self.buffer:
+                continue  # Second delimiter in a row opens the next frame
+            self.in_frame = False
+            try:
+                raw = cobs_decode(bytes(self.buffer))
+            except ValueError:
+                self.framing_errors += 1
+                continue
+            if len(raw) < 4:
+                self.framing_errors += 1
+                continue
+            if crc16(raw[:-2]) != struct.unpack(">H", raw[-2:])[0]:
+                self.crc_errors += 1
+                continue
+            frames.append((raw[0], raw[1], raw[2:-2]))
+        return frames
+
+
+class MetronomeControl:
+    """Sends typed commands and collects acks and beat events.
+
+    A reader thread parses everything the device sends; send() returns a
+    sequence number and wait_ack() blocks until that command is acknowledged.
+    Several commands may be in flight at once (up to 256 sequence numbers).
+    """
+
+    def __init__(self, port, on_beat=None, on_text=None):
+        self.port = port
+        self.on_beat = on_beat
+        self.on_text = on_text
+        self.reader = FrameReader()
+        self.seq = 0
+        self.acks = {}
+        self.sync_status = {}
+        self.sent_at = {}
+        self.cond = threading.Condition()
+        self.running = True
+        self.thread = threading.Thread(target=self._read_loop, daemon=True)
+        self.thread.start()
+
+    def close(self):
+        self.running = False
+
+    def _read_loop(self):
+        while self.running:
+            data = self.port.read(4096)
+            if not data:
+                continue
+            for frame_type, seq, payload in self.reader.feed(data):
+                if frame_type == CTRL_ACK:
+                    command, status, micros = struct.unpack(ACK_FORMAT, payload)
+                    with self.cond:
+                        self.acks[seq] = (command, status, micros, time.perf_counter())
+                        self.cond.notify_all()
+                elif frame_type == CTRL_SYNC_STATUS:
+                    with self.cond:
+                        self.sync_status[seq] = struct.unpack(SYNC_STATUS_FORMAT, payload)
+                elif frame_type == CTRL_EVENT_BEAT and self.on_beat:
+                    self.on_beat(*struct.unpack(BEAT_FORMAT, payload))
+            if self.reader.text and self.on_text:
+                self.on_text(bytes(self.reader.text))
+            self.reader.text.clear()
+
+    def send(self, frame_type, payload=b""):
+        with self.cond:
+            seq = self.seq
+            self.seq = (self.seq + 1) & 0xFF
+            self.acks.pop(seq, None)
+            self.sent_at[seq] = time.perf_counter()
+        self.port.write(encode_frame(frame_type, seq, payload))
+        return seq
+
+    def wait_ack(self, seq, timeout=1.0):
+        """Returns (command, status, device micros, round trip seconds)."""
+        deadline = time.perf_counter() + timeout
+        with self.cond:
+            while seq not in self.acks:
+                remaining = deadline - time.perf_counter()
+                if remaining <= 0:
+                    raise TimeoutError("no ack for seq %d" % seq)
+                self.cond.wait(remaining)
+            command, status, micros, received = self.acks.pop(seq)
+            return command, status, micros, received - self.sent_at.pop(seq)
+
+    def call(self, frame_type, payload=b"", timeout=1.0):
+        command, status, _, _ = self.wait_ack(self.send(frame_type, payload), timeout)
+        if status != CTRL_OK:
+            raise RuntimeError("command 0x%02x rejected (status %d)" % (command, status))
+
+    # Typed commands
+
+    def ping(self):
+        self.call(CTRL_PING)
+
+    def set_bpm(self, bpm):
+        self.call(CTRL_SET_BPM, struct.pack("<H", bpm))
+
+    def play(self):
+        self.call(CTRL_TRANSPORT, bytes([CTRL_PLAY]))
+
+    def pause(self):
+        self.call(CTRL_TRANSPORT, bytes([CTRL_PAUSE]))
+
+    def stop(self):
+        self.call(CTRL_TRANSPORT, bytes([CTRL_STOP]))
+
+    def set_pattern(self, channel, length, pattern):
+        self.call(CTRL_SET_PATTERN, struct.pack("<BBH", channel, length, pattern))
+
+    def set_enabled(self, channel, enabled):
+        self.call(CTRL_SET_ENABLED, struct.pack("<BB", channel, 1 if enabled else 0))
+
+    def set_multiplier(self, index):
+        self.call(CTRL_SET_MULTIPLIER, bytes([index]))
+
+    def set_mode(self, polyrhythm):
+        self.call(CTRL_SET_MODE, bytes([1 if polyrhythm else 0]))
+
+    def subscribe(self, mask=CTRL_EVENTS_BEAT):
+        self.call(CTRL_SUBSCRIBE, bytes([mask]))
+
+    def assign_channels(self, device, channel_mask):
+        """Leader only: device is the follower's MAC, e.g. "24:6f:28:aa:bb:cc"."""
+        mac = bytes(int(part, 16) for part in device.split(":"))
+        if len(mac) != 6:
+            raise ValueError("MAC address needs 6 bytes")
+        self.call(CTRL_ASSIGN_CHANNELS, mac + struct.pack("<H", channel_mask))
+
+    def clear_assignments(self):
+        self.call(CTRL_CLEAR_ASSIGNMENTS)
+
+    def set_group(self, group_id):
+        """Stored in flash; IDs up to 0x00FF are reserved."""
+        self.call(CTRL_SET_GROUP, struct.pack("<H", group_id))
+
+    def get_sync_status(self):
+        """Returns a dict with the group, leader flag, channel mask and the
+        frames dropped for another group or for having no group ID."""
+        seq = self.send(CTRL_GET_SYNC_STATUS)
+        command, status, _, _ = self.wait_ack(seq)
+        if status != CTRL_OK:
+            raise RuntimeError("command 0x%02x rejected (status %d)" % (command, status))
+        with self.cond:
+            group, leader, mask, foreign, legacy = self.sync_status.pop(seq)
+        return {"group": group, "leader": bool(leader), "channel_mask": mask,
+                "foreign_frames": foreign, "legacy_frames": legacy}
+
+    def send_layout(self, layout_id, segments):
+        """Leader only: broadcast an LED receiver layout. segments is a list
+        of (start, length, channel, flags); channel LAYOUT_TEMPO shows the
+        beat. Segments must not overlap."""
+        payload = struct.pack("<HB", layout_id, len(segments))
+        for start, length, channel, flags in segments:
+            payload += struct.pack("<HHBB", start, length, channel, flags)
+        self.call(CTRL_SEND_LAYOUT, payload)
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Steady-state heap soak test against a device.
+
+Build with ENABLE_SERIAL_CONTROL 1 and ENABLE_HEAP_MONITOR 1. The script
+starts playback, subscribes to beat events and keeps changing tempo,
+patterns, channels and transport for the whole run, while collecting the
+device's "heap:" status lines. It fails if any allocation is reported after
+boot, or if the status lines stop arriving.
+
+    ./soak.py --port /dev/ttyUSB0 --minutes 60
+
+Run with wireless sync off: the radio driver allocates per packet inside
+the IDF, outside the firmware's control.
+"""
+
+import argparse
+import random
+import re
+import struct
+import sys
+import time
+
+import metronome_control as mc
+
+HEAP_LINE = re.compile(rb"heap: allocations=(\d+) last_size=(\d+) last_caller=(0x[0-9a-f]+) free=(\d+)")
+
+
+class HeapStatus:
+    def __init__(self):
+        self.buffer = b""
+        self.reports = 0
+        self.allocations = None
+        self.last = None
+        self.min_free = None
+
+    def feed(self, text):
+        self.buffer += text
+        *lines, self.buffer = self.buffer.split(b"\n")
+        for line in lines:
+            match = HEAP_LINE.search(line)
+            if not match:
+                continue
+            allocations, size, caller, free = match.groups()
+            self.reports += 1
+            self.allocations = int(allocations)
+            self.last = (int(size), caller.decode())
+            free = int(free)
+            self.min_free = free if self.min_free is None else min(self.min_free, free)
+            if self.allocations:
+                print("allocation after boot: %d so far, last %d bytes from %s" % (
+                    self.allocations, *self.last))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", required=True)
+    parser.add_argument("--baud", type=int, default=921600)
+    parser.add_argument("--minutes", type=float, default=60.0)
+    parser.add_argument("--rate", type=float, default=200.0, help="commands per second")
+    args = parser.parse_args()
+
+    import serial
+    port = serial.Serial(args.port, args.baud, timeout=0.1)
+    status = HeapStatus()
+    beats = [0]
+    client = mc.MetronomeControl(port, on_beat=lambda *event: beats.__setitem__(0, beats[0] + 1),
+                                 on_text=status.feed)
+    client.ping()
+    client.subscribe()
+    client.play()
+
+    rng = random.Random(1)
+    commands = 0
+    start = time.monotonic()
+    end = start + args.minutes * 60
+    next_progress = start + 60
+    while time.monotonic() < end:
+        choice = rng.randrange(10)
+        if choice < 4:
+            client.set_bpm(rng.randint(40, 240))
+        elif choice < 7:
+            length = rng.randint(1, 16)
+            client.set_pattern(rng.randrange(2), length, rng.getrandbits(16))
+        elif choice < 8:
+            client.set_enabled(1, rng.randrange(2))
+        elif choice < 9:
+            client.set_mode(rng.randrange(2))
+        else:
+            # Brief pause and resume, so transport changes are covered too
+            client.pause()
+            client.play()
+        commands += 1
+        time.sleep(1.0 / args.rate)
+
+        if time.monotonic() >= next_progress:
+            next_progress += 60
+            print("%.0f min: %d commands, %d beats, %d heap reports" % (
+                (time.monotonic() - start) / 60, commands, beats[0], status.reports))
+
+    # Let the next periodic report arrive
+    time.sleep(12)
+    client.stop()
+    client.close()
+
+    print("%d commands, %d beats, %d heap reports, min free %s bytes" % (
+        commands, beats[0], status.reports, status.min_free))
+    if status.reports == 0:
+        print("FAIL: no heap reports (ENABLE_HEAP_MONITOR off?)")
+        return 1
+    if status.allocations:
+        print("FAIL: %d allocations after boot" % status.allocations)
+        return 1
+    print("PASS: no allocations after boot")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
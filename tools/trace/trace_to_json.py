@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Convert a metronome event trace into Chrome trace JSON.
+
+Build with ENABLE_TRACE 1 (src/config.h). The device streams CTRL_EVENT_TRACE
+frames on the serial console (see src/Trace.h); capture them live or from a
+raw dump and open the output in https://ui.perfetto.dev or chrome://tracing.
+
+    ./trace_to_json.py --port /dev/ttyUSB0 --seconds 10 -o trace.json
+    ./trace_to_json.py capture.bin -o trace.json
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "serial_control"))
+import metronome_control as mc  # noqa: E402
+
+RECORD_FORMAT = "<IBBHI"     # time us, event, core, a16, a32
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+
+TRACE_BEAT = 1
+TRACE_PULSE_ON = 2
+TRACE_PULSE_OFF = 3
+TRACE_TX = 4
+TRACE_RX = 5
+TRACE_SAVE = 6
+TRACE_LOAD = 7
+TRACE_FRAME = 8
+TRACE_EUCLID = 9
+TRACE_RESET = 10
+TRACE_LOST = 11
+
+BEAT_STATES = {0: "silent", 1: "weak", 2: "accent"}
+MESSAGE_TYPES = {0: "clock", 1: "beat", 2: "bar", 3: "control", 4: "pattern",
+                 5: "assign", 6: "layout"}
+RESETS = {0: "bpm", 1: "patterns", 2: "channel", 3: "storage"}
+
+# One timeline row per subsystem
+THREADS = {"timing": 1, "solenoid": 2, "sync": 3, "display": 4, "state": 5, "trace": 6}
+
+
+def records(frames):
+    for frame_type, _, payload in frames:
+        if frame_type != mc.CTRL_EVENT_TRACE:
+            continue
+        for offset in range(0, len(payload) - RECORD_SIZE + 1, RECORD_SIZE):
+            yield struct.unpack_from(RECORD_FORMAT, payload, offset)
+
+
+class Converter:
+    def __init__(self):
+        self.events = []
+        self.last = None
+        self.high = 0
+        self.lost = 0
+
+    def unwrap(self, t):
+        # Device time is the low 32 bits of a microsecond counter (~71 min)
+        if self.last is not None and t < self.last and self.last - t > 0x80000000:
+            self.high += 1 << 32
+        self.last = t
+        return self.high + t
+
+    def instant(self, ts, core, thread, name, **args):
+        self.events.append({"name": name, "ph": "i", "s": "t", "ts": ts, "pid": core,
+                            "tid": THREADS[thread], "args": args})
+
+    def add(self, t, event, core, a16, a32):
+        ts = self.unwrap(t)
+        if event == TRACE_BEAT:
+            self.instant(ts, core, "timing", "beat ch%d" % a16,
+                         state=BEAT_STATES.get(a32, a32))
+        elif event == TRACE_PULSE_ON:
+            self.events.append({"name": "pulse ch%d" % a16, "ph": "B", "ts": ts, "pid": core,
+                                "tid": THREADS["solenoid"], "args": {"length_us": a32}})
+        elif event == TRACE_PULSE_OFF:
+            # Ends whichever pulse is open; B/E must pair on the same pid
+            for e in reversed(self.events):
+                if e["tid"] == THREADS["solenoid"] and e["ph"] == "B":
+                    self.events.append({"ph": "E", "ts": ts, "pid": e["pid"],
+                                        "tid": THREADS["solenoid"]})
+                    break
+        elif event in (TRACE_TX, TRACE_RX):
+            name = "%s %s" % ("tx" if event == TRACE_TX else "rx", MESSAGE_TYPES.get(a16, a16))
+            self.instant(ts, core, "sync", name, seq=a32)
+        elif event == TRACE_FRAME:
+            self.events.append({"name": "frame", "ph": "X", "ts": ts - a32, "dur": a32,
+                                "pid": core, "tid": THREADS["display"]})
+        elif event == TRACE_EUCLID:
+            self.instant(ts, core, "state", "euclid %d/%d" % (a16 >> 8, a16 & 0xFF),
+                         pattern=bin(a32))
+        elif event in (TRACE_SAVE, TRACE_LOAD):
+            self.instant(ts, core, "state", "save" if event == TRACE_SAVE else "load",
+                         ok=bool(a32))
+        elif event == TRACE_RESET:
+            self.instant(ts, core, "state", "reset " + RESETS.get(a16, str(a16)), value=a32)
+        elif event == TRACE_LOST:
+            self.lost += a32
+            self.instant(ts, core, "trace", "lost", records=a32)
+
+    def json(self):
+        meta = []
+        for core in sorted({e["pid"] for e in self.events}):
+            meta.append({"name": "process_name", "ph": "M", "pid": core,
+                         "args": {"name": "core %d" % core}})
+            for name, tid in THREADS.items():
+                meta.append({"name": "thread_name", "ph": "M", "pid": core, "tid": tid,
+                             "args": {"name": name}})
+        return {"traceEvents": meta + self.events, "displayTimeUnit": "ms"}
+
+
+def read_port(args):
+    import serial
+    port = serial.Serial(args.port, args.baud, timeout=0.1)
+    deadline = time.monotonic() + args.seconds
+    while time.monotonic() < deadline:
+        data = port.read(4096)
+        if data:
+            yield data
+
+
+def read_file(path):
+    with open(path, "rb") as f:
+        while True:
+            data = f.read(65536)
+            if not data:
+                return
+            yield data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="raw serial capture (default: --port)")
+    parser.add_argument("--port", help="serial device to capture from (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=921600)
+    parser.add_argument("--seconds", type=float, default=10.0)
+    parser.add_argument("-o", "--output", default="trace.json")
+    args = parser.parse_args()
+    if not args.capture and not args.port:
+        parser.error("give a capture file or --port")
+
+    reader = mc.FrameReader()
+    converter = Converter()
+    chunks = read_file(args.capture) if args.capture else read_port(args)
+    count = 0
+    for data in chunks:
+        for record in records(reader.feed(data)):
+            converter.add(*record)
+            count += 1
+        reader.text.clear()
+
+    with open(args.output, "w") as f:
+        json.dump(converter.json(), f)
+    print("%d records, %d lost on device, %d crc / %d framing errors -> %s" % (
+        count, converter.lost, reader.crc_errors, reader.framing_errors, args.output))
+
+
+if __name__ == "__main__":
+    main()